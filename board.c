@@ -19,10 +19,96 @@
 #include "board.h"
 
 static size_t board_print_border(struct board* board, char* buffer);
+static void board_write_begin(struct board* board);
+static void board_write_end(struct board* board);
+
+uint32_t board_component(struct board* board, uint32_t die) {
+	// Find root, halving the path along the way.
+	while (board->parents[die] != die) {
+		board->parents[die] = board->parents[board->parents[die]];
+		die = board->parents[die];
+	}
+	return die;
+}
+
+struct flub* board_connect(struct board* board, char* nick, uint32_t from,
+	uint32_t to) {
+	struct flub* flub;
+	uint32_t tmp;
+	uint32_t total;
+
+	// Check connection.
+	if ((flub = board_connect_check(board, from, to))) {
+		return flub;
+	}
+
+	// Score the group formed.
+	if ((flub = score_add(&board->score, nick,
+		board->sizes[board_component(board, from)] +
+		board->sizes[board_component(board, to)], &total))) {
+		return flub;
+	}
+
+	// Record connection.
+	board_write_begin(board);
+	strlcpy(board->connections[board->connection_count].nick, nick,
+		GLS_NICK_LENGTH);
+	board->connections[board->connection_count].from = from;
+	board->connections[board->connection_count].to = to;
+	board->connection_count++;
+	board->version++;
+
+	// Merge the smaller group into the larger.
+	from = board_component(board, from);
+	to = board_component(board, to);
+	if (board->sizes[from] < board->sizes[to]) {
+		tmp = from;
+		from = to;
+		to = tmp;
+	}
+	board->parents[to] = from;
+	board->sizes[from] += board->sizes[to];
+	board_write_end(board);
+	return NULL;
+}
+
+struct flub* board_connect_check(struct board* board, uint32_t from,
+	uint32_t to) {
+	if (from >= board->die_placed) {
+		return g_flub_toss("Die '%u' not placed", from);
+	} else if (to >= board->die_placed) {
+		return g_flub_toss("Die '%u' not placed", to);
+	} else if (board_component(board, from) ==
+		board_component(board, to)) {
+		return g_flub_toss("Dice already connected");
+	}
+	return NULL;
+}
+
+struct flub* board_deck(struct board* board) {
+	uint32_t count;
+	uint32_t i;
+
+	// Place each plate that fits in row-major order.
+	count = board->catalog->record_count;
+	if (count > board->rows * board->columns) {
+		count = board->rows * board->columns;
+		g_log_info("Board fits '%u' of the deck's '%u' plates", count,
+			board->catalog->record_count);
+	}
+	for (i = 0; i < count; i++) {
+		board_plate_set(board, i / board->columns, i % board->columns,
+			i);
+	}
+	return NULL;
+}
 
 struct flub* board_die_place(struct board* board, char* nick, char* location,
 	uint32_t* color, uint32_t* die) {
+	uint32_t column;
 	struct flub* flub;
+	uint32_t row;
+	uint32_t total;
 
 	// Check if the die can be placed.
 	if ((flub = board_die_place_check(board, location, color, die))) {
@@ -30,183 +116,341 @@ struct flub* board_die_place(struct board* board, char* nick, char* location,
 		return flub;
 	}
 
+	// Score die.
+	if ((flub = score_add(&board->score, nick, 1, &total))) {
+		return flub;
+	}
+	board->score.colors[(*color)]++;
+
 	// Place die.
+	board_write_begin(board);
 	strlcpy(board->dice[(*die)].nick, nick, GLS_NICK_LENGTH);
 	strlcpy(board->dice[(*die)].location, location, GLS_LOCATION_LENGTH);
 	board->dice[(*die)].color = (*color);
+	board->color_dice[(*color)]++;
+	board->die_placed++;
+	board->version++;
+	board_location_parse(board, location, &row, &column);
+	board->occupants[row * board->columns + column] = (*die) + 1;
+	board_write_end(board);
 	return NULL;
 }
 
 struct flub* board_die_place_check(struct board* board, char* location,
 	uint32_t* color, uint32_t* die) {
-	int i;
+	uint32_t column;
+	struct flub* flub;
+	uint32_t newc;
+	uint32_t row;
 
-	// Check for color.
+	// Check for color; each color places a single die.
 	if ((*color) == GLS_COLOR_NULL) {
-		int newc;
-
 		// Check for available color.
-		for (newc = GLS_COLOR_MIN; newc <= GLS_COLOR_MAX; newc++) {
-			for (i = 0; i < GLS_DIE_MAX; i++) {
-				if (board->dice[i].color == newc) {
-					break; // Color in use.
-				}
-			}
-			if (i == GLS_DIE_MAX) {
-				break; // Color found.
-			}
-		}
+		for (newc = GLS_COLOR_MIN; newc <= GLS_COLOR_MAX &&
+			board->color_dice[newc]; newc++);
 		if (newc > GLS_COLOR_MAX) {
 			return g_flub_toss("No colors left");
 		}
 		(*color) = newc;
-	} else {
-		// Check if color in use.
-		for (i = 0; i < GLS_DIE_MAX; i++) {
-			if (board->dice[i].color == (*color)) {
-				break; // Color in use.
-			}
-		}
-		if (i != GLS_DIE_MAX) {
-			return g_flub_toss("Color in use");
-		}
+	} else if ((*color) > GLS_COLOR_MAX) {
+		return g_flub_toss("Invalid color '%u'", (*color));
+	} else if (board->color_dice[(*color)]) {
+		return g_flub_toss("Color in use");
 	}
 
 	// Check for empty plate.
-	if (board->plates[location[0] - 'A'][location[1] - '1'].empty) {
+	if ((flub = board_location_parse(board, location, &row, &column))) {
+		return flub;
+	}
+	if (board_plate_get(board, row, column) == CATALOG_PLATE_NONE) {
 		return g_flub_toss("No plate at location '%s'", location);
 	}
 
 	// Check for a die.
-	for (i = 0; i < GLS_DIE_MAX; i++) {
-		if (!strlen(board->dice[i].location)) {
-			break;
-		}
-	}
-	if (i == GLS_DIE_MAX) {
+	if (board->die_placed == board->die_count) {
 		return g_flub_toss("No dice left");
 	}
-	(*die) = i;
+	(*die) = board->die_placed;
 	return NULL;
 }
 
-void board_init(struct board* board) {
-	// Use a default set of cards. Hacky.
+struct flub* board_die_set(struct board* board, char* nick, char* location,
+	uint32_t color, uint32_t die) {
+	uint32_t column;
+	struct flub* flub;
+	uint32_t row;
+
+	// Check die.
+	if (die >= board->die_count) {
+		return g_flub_toss("Invalid die '%u'", die);
+	} else if (color > GLS_COLOR_MAX) {
+		return g_flub_toss("Invalid color '%u'", color);
+	} else if ((flub = board_location_parse(board, location, &row,
+		&column))) {
+		return flub;
+	}
+
+	// Record die.
+	board_write_begin(board);
+	strlcpy(board->dice[die].nick, nick, GLS_NICK_LENGTH);
+	strlcpy(board->dice[die].location, location, GLS_LOCATION_LENGTH);
+	if (die < board->die_placed) {
+		board->color_dice[board->dice[die].color]--;
+	}
+	board->dice[die].color = color;
+	board->color_dice[color]++;
+	if (die >= board->die_placed) {
+		board->die_placed = die + 1;
+	}
+	board->version++;
+	board->occupants[row * board->columns + column] = die + 1;
+	board_write_end(board);
+	return NULL;
+}
+
+void board_free(struct board* board) {
+	// Free any storage that isn't inline.
+	if (board->cells != board->cells_fixed) {
+		free(board->cells);
+		free(board->abbrevs);
+		free(board->occupants);
+	}
+	if (board->dice != board->dice_fixed) {
+		free(board->dice);
+		free(board->connections);
+		free(board->parents);
+		free(board->sizes);
+	}
+	score_free(&board->score);
 	memset(board, 0, sizeof(struct board));
-	strncpy(board->plates[0][0].name, "Ambivalence", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][0].abbrev, "Amb", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][1].name, "Art Versus Nature", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][1].abbrev, "AVN", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][2].name, "The Need Not to Judge", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][2].abbrev, "TNJ", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][3].name, "Calculus", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][3].abbrev, "Clc", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][4].name, "City as Artifact", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][4].abbrev, "CaA", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][5].name, "Coding", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][5].abbrev, "Cde", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][6].name, "Contemplation", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][6].abbrev, "Ctp", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[0][7].name, "Continuity/Eternity", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[0][7].abbrev, "C/E", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][0].name, "Creation", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][0].abbrev, "Crt", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][1].name, "Ontogeny Recapitulates Phylogeny", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][1].abbrev, "ORP", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][2].name, "Education", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][2].abbrev, "Edu", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][3].name, "Helplessness", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][3].abbrev, "Hlp", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][4].name, "Intuition", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][4].abbrev, "Itu", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][5].name, "Monetary Value", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][5].abbrev, "MnV", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][6].name, "Wavicle", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][6].abbrev, "Wav", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[1][7].name, "Freedom", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[1][7].abbrev, "Fre", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][0].name, "Emotional Manipulation", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][0].abbrev, "EmM", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][1].name, "Gestalt", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][1].abbrev, "Gst", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][2].name, "Harmony", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][2].abbrev, "Hrm", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][3].name, "Hidden Potential", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][3].abbrev, "HdP", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][4].name, "Joy", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][4].abbrev, "Joy", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][5].name, "Magic", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][5].abbrev, "Mgc", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][6].name, "Mechanical Advantage", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][6].abbrev, "McA", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[2][7].name, "Metamorphosis", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[2][7].abbrev, "Mtm", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][0].name, "Nature Tending Towards Perfection", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][0].abbrev, "NTP", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][1].name, "Myth", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][1].abbrev, "Mth", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][2].name, "Coexisting Species", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][2].abbrev, "CxS", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][3].name, "Perspective", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][3].abbrev, "Prp", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][4].name, "Reaching Out", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][4].abbrev, "RcO", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][5].name, "Return", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][5].abbrev, "Rtn", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][6].name, "Society as Active/Passive Hierarchy", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][6].abbrev, "SoH", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[3][7].name, "Structural Strength", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[3][7].abbrev, "StS", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[4][0].name, "Struggle", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[4][0].abbrev, "Stg", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[4][1].name, "Synergy", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[4][1].abbrev, "Syg", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[4][2].name, "Syntax", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[4][2].abbrev, "Stx", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[4][3].name, "Unwanted Relationships", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[4][3].abbrev, "UwR", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[4][4].name, "Structural Improvisation", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[4][4].abbrev, "StI", GLS_PLATE_ABBREV_LENGTH);
-	strncpy(board->plates[4][5].name, "Anthropomorphism", GLS_PLATE_NAME_LENGTH);
-	strncpy(board->plates[4][5].abbrev, "Anp", GLS_PLATE_ABBREV_LENGTH);
-	board->plates[4][6].empty = 1;
-	board->plates[4][7].empty = 1;
-	board->plates[5][0].empty = 1;
-	board->plates[5][1].empty = 1;
-	board->plates[5][2].empty = 1;
-	board->plates[5][3].empty = 1;
-	board->plates[5][4].empty = 1;
-	board->plates[5][5].empty = 1;
-	board->plates[5][6].empty = 1;
-	board->plates[5][7].empty = 1;
-	board->plates[6][0].empty = 1;
-	board->plates[6][1].empty = 1;
-	board->plates[6][2].empty = 1;
-	board->plates[6][3].empty = 1;
-	board->plates[6][4].empty = 1;
-	board->plates[6][5].empty = 1;
-	board->plates[6][6].empty = 1;
-	board->plates[6][7].empty = 1;
-	board->plates[7][0].empty = 1;
-	board->plates[7][1].empty = 1;
-	board->plates[7][2].empty = 1;
-	board->plates[7][3].empty = 1;
-	board->plates[7][4].empty = 1;
-	board->plates[7][5].empty = 1;
-	board->plates[7][6].empty = 1;
-	board->plates[7][7].empty = 1;
+}
+
+struct flub* board_init(struct board* board, struct catalog* catalog,
+	uint32_t rows, uint32_t columns, uint32_t dice) {
+	uint32_t i;
+
+	// Check dimensions.
+	memset(board, 0, sizeof(struct board));
+	if (!rows || rows > GLS_BOARD_ROW_MAX) {
+		return g_flub_toss("Invalid board row count '%u'", rows);
+	} else if (!columns || columns > GLS_BOARD_COLUMN_MAX) {
+		return g_flub_toss("Invalid board column count '%u'", columns);
+	} else if (!dice || dice > GLS_DIE_MAX) {
+		return g_flub_toss("Invalid board die count '%u'", dice);
+	}
+	board->rows = rows;
+	board->columns = columns;
+	board->catalog = catalog;
+	board->die_count = dice;
+
+	// Use inline storage when it fits, otherwise allocate.
+	if (rows * columns <= GLS_BOARD_ROW_COUNT * GLS_BOARD_COLUMN_COUNT) {
+		board->cells = board->cells_fixed;
+		board->abbrevs = board->abbrevs_fixed;
+		board->occupants = board->occupants_fixed;
+	} else {
+		board->cells = malloc(rows * columns * sizeof(uint32_t));
+		board->abbrevs = calloc(rows * columns,
+			GLS_PLATE_ABBREV_LENGTH);
+		board->occupants = calloc(rows * columns, sizeof(uint16_t));
+		if (!board->cells || !board->abbrevs || !board->occupants) {
+			board_free(board);
+			return g_flub_toss("Unable to allocate board cells");
+		}
+	}
+	memset(board->cells, 0xFF, rows * columns * sizeof(uint32_t));
+	if (dice <= GLS_DIE_COUNT) {
+		board->dice = board->dice_fixed;
+		board->connections = board->connections_fixed;
+		board->parents = board->parents_fixed;
+		board->sizes = board->sizes_fixed;
+	} else {
+		board->dice = calloc(dice, sizeof(struct die));
+		board->connections = calloc(dice,
+			sizeof(struct board_connection));
+		board->parents = calloc(dice, sizeof(uint32_t));
+		board->sizes = calloc(dice, sizeof(uint32_t));
+		if (!board->dice || !board->connections || !board->parents ||
+			!board->sizes) {
+			board_free(board);
+			return g_flub_toss("Unable to allocate board dice");
+		}
+	}
+	for (i = 0; i < dice; i++) {
+		board->parents[i] = i;
+		board->sizes[i] = 1;
+	}
+	score_init(&board->score);
+	return NULL;
+}
+
+struct flub* board_location_parse(struct board* board, char* location,
+	uint32_t* row, uint32_t* column) {
+	struct flub* flub;
+
+	// Parse and bounds-check the location.
+	if ((flub = gls_location_parse(location, row, column))) {
+		return flub;
+	} else if ((*row) >= board->rows) {
+		return g_flub_toss("Plate row specifier too large");
+	} else if ((*column) >= board->columns) {
+		return g_flub_toss("Plate column specified too large");
+	}
+	return NULL;
+}
+
+struct flub* board_marshal(struct board* board, char** buffer, size_t* size) {
+	char* b;
+	uint32_t cells;
+	uint32_t i;
+	uint32_t tmp;
+
+	// Allocate buffer.
+	cells = board->rows * board->columns;
+	(*size) = board_marshal_size(board, board->die_placed,
+		board->connection_count);
+	if (!(b = malloc(*size))) {
+		return g_flub_toss("Unable to allocate board buffer");
+	}
+	(*buffer) = b;
+
+	// Write dimensions, plates, and dice.
+	tmp = htobe32(board->rows);
+	memcpy(b, &tmp, sizeof(uint32_t));
+	tmp = htobe32(board->columns);
+	memcpy(b += sizeof(uint32_t), &tmp, sizeof(uint32_t));
+	tmp = htobe32(board->die_count);
+	memcpy(b += sizeof(uint32_t), &tmp, sizeof(uint32_t));
+	tmp = htobe32(board->die_placed);
+	memcpy(b += sizeof(uint32_t), &tmp, sizeof(uint32_t));
+	tmp = htobe32(board->catalog->record_count);
+	memcpy(b += sizeof(uint32_t), &tmp, sizeof(uint32_t));
+	b += sizeof(uint32_t);
+	for (i = 0; i < cells; i++) {
+		tmp = htobe32(board->cells[i]);
+		memcpy(b, &tmp, sizeof(uint32_t));
+		b += sizeof(uint32_t);
+	}
+	for (i = 0; i < board->die_placed; i++) {
+		tmp = htobe32(board->dice[i].color);
+		memcpy(b, &tmp, sizeof(uint32_t));
+		b += sizeof(uint32_t);
+		memcpy(b, board->dice[i].location, GLS_LOCATION_LENGTH);
+		b += GLS_LOCATION_LENGTH;
+		memcpy(b, board->dice[i].nick, GLS_NICK_LENGTH);
+		b += GLS_NICK_LENGTH;
+	}
+	tmp = htobe32(board->connection_count);
+	memcpy(b, &tmp, sizeof(uint32_t));
+	b += sizeof(uint32_t);
+	for (i = 0; i < board->connection_count; i++) {
+		tmp = htobe32(board->connections[i].from);
+		memcpy(b, &tmp, sizeof(uint32_t));
+		b += sizeof(uint32_t);
+		tmp = htobe32(board->connections[i].to);
+		memcpy(b, &tmp, sizeof(uint32_t));
+		b += sizeof(uint32_t);
+		memcpy(b, board->connections[i].nick, GLS_NICK_LENGTH);
+		b += GLS_NICK_LENGTH;
+	}
+	return NULL;
+}
+
+size_t board_marshal_size(struct board* board, uint32_t dice,
+	uint32_t connections) {
+	return sizeof(uint32_t) * (6 + board->rows * board->columns) + dice *
+		(sizeof(uint32_t) + GLS_LOCATION_LENGTH + GLS_NICK_LENGTH) +
+		connections * (2 * sizeof(uint32_t) + GLS_NICK_LENGTH);
+}
+
+struct flub* board_plate_detail(struct board* board, char* location,
+	struct gls_plate_detail* detail) {
+	uint32_t column;
+	struct flub* flub;
+	uint32_t id;
+	struct plate plate;
+	uint32_t row;
+
+	// Look up plate.
+	memset(detail, 0, sizeof(struct gls_plate_detail));
+	if ((flub = board_location_parse(board, location, &row, &column))) {
+		return flub;
+	}
+	strlcpy(detail->plate.loc, location, GLS_LOCATION_LENGTH);
+	id = board_plate_get(board, row, column);
+	if (id == CATALOG_PLATE_NONE) {
+		detail->plate.flags = GLS_PLATE_FLAG_EMPTY;
+		return NULL;
+	}
+	catalog_plate(board->catalog, id, &plate);
+	strlcpy(detail->plate.abbrev, plate.abbrev, GLS_PLATE_ABBREV_LENGTH);
+	strlcpy(detail->plate.description, plate.description,
+		GLS_PLATE_DESCRIPTION_LENGTH);
+	strlcpy(detail->plate.name, plate.name, GLS_PLATE_NAME_LENGTH);
+	return NULL;
+}
+
+uint64_t board_plate_hash(struct board* board, uint32_t* plates) {
+	uint32_t cell;
+	uint64_t hash;
+	struct plate plate;
+	uint32_t tmp;
+
+	// Hash the dimensions, then each plate along with its cell.
+	hash = G_HASH64_SEED;
+	tmp = htobe32(board->rows);
+	hash = g_hash64(hash, &tmp, sizeof(tmp));
+	tmp = htobe32(board->columns);
+	hash = g_hash64(hash, &tmp, sizeof(tmp));
+	*plates = 0;
+	for (cell = 0; cell < board->rows * board->columns; cell++) {
+		if (board->cells[cell] == CATALOG_PLATE_NONE) {
+			continue;
+		}
+		catalog_plate(board->catalog, board->cells[cell], &plate);
+		tmp = htobe32(cell);
+		hash = g_hash64(hash, &tmp, sizeof(tmp));
+		hash = g_hash64(hash, plate.abbrev, strlen(plate.abbrev) + 1);
+		hash = g_hash64(hash, plate.name, strlen(plate.name) + 1);
+		hash = g_hash64(hash, plate.description,
+			strlen(plate.description) + 1);
+		(*plates)++;
+	}
+	return hash ? hash : 1;
+}
+
+void board_plate_set(struct board* board, uint32_t row, uint32_t column,
+	uint32_t id) {
+	uint32_t cell;
+
+	// Set identifier and cache abbreviation.
+	cell = row * board->columns + column;
+	board_write_begin(board);
+	board->cells[cell] = id;
+	board->version++;
+	if (id == CATALOG_PLATE_NONE) {
+		memset(board->abbrevs[cell], 0, GLS_PLATE_ABBREV_LENGTH);
+	} else {
+		memcpy(board->abbrevs[cell], board->catalog->records[id].abbrev,
+			GLS_PLATE_ABBREV_LENGTH);
+	}
+	board_write_end(board);
 }
 
 struct flub* board_print(struct board* board, int fd) {
 	int offset;
 	char* buffer;
-	const int height = 25;
+	int height;
 	int i;
 	int j;
 	int k;
-	const int width = 80;
+	char* abbrev;
+	char location[GLS_LOCATION_LENGTH];
+	int width;
 
 	// Allocate buffer for writing board.
+	width = 16 + board->columns * 6 + 2;
+	height = board->rows * 2 + 2;
 	buffer = malloc(width * height);
 	if (!buffer) {
 		return g_flub_toss("Unable to allocate board print buffer");
@@ -217,36 +461,32 @@ struct flub* board_print(struct board* board, int fd) {
 	for (i = 0; i < 16; i++) {
 		buffer[offset++] = ' ';
 	}
-	for (i = 0; i < GLS_BOARD_ROW_COUNT; i++) {
-		strcpy(&buffer[offset], "   1  ");
-		buffer[offset + 3] += i; // So hack.
-		offset += 6;
+	for (i = 0; i < board->columns; i++) {
+		offset += sprintf(&buffer[offset], "%4u  ", i + 1);
 	}
 	buffer[offset++] = '\n';
 
 	// Write each plate to the file descriptor.
-	for (i = 0; i < GLS_BOARD_ROW_COUNT; i++) {
+	for (i = 0; i < board->rows; i++) {
 		// Write row border.
 		offset += board_print_border(board, &buffer[offset]);
 
-		// Write left margin.
-		for (k = 0; k < 14; k++) {
-			buffer[offset++] = ' ';
-		}
-		buffer[offset++] = 'A' + i; // So hack.
-		buffer[offset++] = ' ';
+		// Write left margin with the row's letters.
+		gls_location_format(location, i, 0);
+		for (k = 0; isupper(location[k]); k++);
+		location[k] = '\0';
+		offset += sprintf(&buffer[offset], "%15s ", location);
 
 		// Write plate abbreviations.
-		for (j = 0; j < GLS_BOARD_COLUMN_COUNT; j++) {
+		for (j = 0; j < board->columns; j++) {
 			// Write plate abbreviations.
 			strcpy(&buffer[offset], "| ");
 			offset += 2;
-			if (board->plates[i][j].empty) {
+			abbrev = board->abbrevs[i * board->columns + j];
+			if (!abbrev[0]) {
 				strcpy(&buffer[offset], " - ");
 			} else {
-				strncpy(&buffer[offset],
-					board->plates[i][j].abbrev,
-					3);
+				strncpy(&buffer[offset], abbrev, 3);
 			}
 			for (k = 0; k < 3; k++) {
 				// Replace empty characters with space.
@@ -263,7 +503,7 @@ struct flub* board_print(struct board* board, int fd) {
 	offset += board_print_border(board, &buffer[offset]);
 
 	// Write board to file.
-	if (write(fd, buffer, strlen(buffer)) == -1) {
+	if (write(fd, buffer, offset) == -1) {
 		g_flub_toss("Unable to write board: '%s'", g_serr(errno));
 	}
 
@@ -274,6 +514,109 @@ struct flub* board_print(struct board* board, int fd) {
 	return NULL;
 }
 
+struct flub* board_unmarshal(struct board* board, struct catalog* catalog,
+	char* buffer, size_t size) {
+	uint32_t cells;
+	uint32_t color;
+	uint32_t connections;
+	size_t end;
+	struct flub* flub;
+	uint32_t from;
+	uint32_t head[5];
+	uint32_t i;
+	uint32_t id;
+	char location[GLS_LOCATION_LENGTH];
+	char nick[GLS_NICK_LENGTH];
+	uint32_t to;
+
+	// Read dimensions.
+	if (size < sizeof(head)) {
+		return g_flub_toss("Board buffer too small");
+	}
+	for (i = 0; i < 5; i++) {
+		memcpy(&head[i], buffer, sizeof(uint32_t));
+		head[i] = be32toh(head[i]);
+		buffer += sizeof(uint32_t);
+	}
+	if (head[4] != catalog->record_count) {
+		return g_flub_toss("Board uses a catalog of '%u' plates, not "
+			"'%u'", head[4], catalog->record_count);
+	} else if (head[3] > head[2]) {
+		return g_flub_toss("Board has more placed dice than dice");
+	}
+	if ((flub = board_init(board, catalog, head[0], head[1], head[2]))) {
+		return flub;
+	}
+	cells = head[0] * head[1];
+	end = sizeof(head) + cells * sizeof(uint32_t) + head[3] *
+		(sizeof(uint32_t) + GLS_LOCATION_LENGTH + GLS_NICK_LENGTH);
+	if (size < end + sizeof(uint32_t)) {
+		board_free(board);
+		return g_flub_toss("Board buffer size mismatch");
+	}
+	memcpy(&connections, buffer + end - sizeof(head), sizeof(uint32_t));
+	connections = be32toh(connections);
+	if (connections > head[3] || size != end + sizeof(uint32_t) +
+		connections * (2 * sizeof(uint32_t) + GLS_NICK_LENGTH)) {
+		board_free(board);
+		return g_flub_toss("Board buffer size mismatch");
+	}
+
+	// Read plates.
+	for (i = 0; i < cells; i++) {
+		memcpy(&id, buffer, sizeof(uint32_t));
+		id = be32toh(id);
+		buffer += sizeof(uint32_t);
+		if (id != CATALOG_PLATE_NONE && id >= catalog->record_count) {
+			board_free(board);
+			return g_flub_toss("Invalid plate '%u'", id);
+		}
+		board_plate_set(board, i / board->columns, i % board->columns,
+			id);
+	}
+
+	// Place dice.
+	for (i = 0; i < head[3]; i++) {
+		memcpy(&color, buffer, sizeof(uint32_t));
+		color = be32toh(color);
+		buffer += sizeof(uint32_t);
+		memcpy(location, buffer, GLS_LOCATION_LENGTH);
+		location[GLS_LOCATION_LENGTH - 1] = '\0';
+		buffer += GLS_LOCATION_LENGTH;
+		memcpy(nick, buffer, GLS_NICK_LENGTH);
+		nick[GLS_NICK_LENGTH - 1] = '\0';
+		buffer += GLS_NICK_LENGTH;
+		if (color < GLS_COLOR_MIN || color > GLS_COLOR_MAX) {
+			board_free(board);
+			return g_flub_toss("Invalid color '%u'", color);
+		}
+		if ((flub = board_die_place(board, nick, location, &color,
+			&id))) {
+			board_free(board);
+			return flub_append(flub, "placing die '%u'", i);
+		}
+	}
+
+	// Connect dice.
+	buffer += sizeof(uint32_t);
+	for (i = 0; i < connections; i++) {
+		memcpy(&from, buffer, sizeof(uint32_t));
+		from = be32toh(from);
+		buffer += sizeof(uint32_t);
+		memcpy(&to, buffer, sizeof(uint32_t));
+		to = be32toh(to);
+		buffer += sizeof(uint32_t);
+		memcpy(nick, buffer, GLS_NICK_LENGTH);
+		nick[GLS_NICK_LENGTH - 1] = '\0';
+		buffer += GLS_NICK_LENGTH;
+		if ((flub = board_connect(board, nick, from, to))) {
+			board_free(board);
+			return flub_append(flub, "making connection '%u'", i);
+		}
+	}
+	return NULL;
+}
+
 static size_t board_print_border(struct board* board, char* buffer) {
 	int i;
 
@@ -281,7 +624,7 @@ static size_t board_print_border(struct board* board, char* buffer) {
 	for (i = 0; i < 16; i++) {
 		buffer[i] = ' ';
 	}
-	for ( ; i < 65; i++) {
+	for ( ; i < 16 + board->columns * 6 + 1; i++) {
 		if ((i - 16) % 6) {
 			buffer[i] = '-';
 		} else {
@@ -293,3 +636,18 @@ static size_t board_print_border(struct board* board, char* buffer) {
 	// Return bytes buffered.
 	return i;
 }
+
+/**
+ * Marks the start of a change to the board for readers on other threads.
+ */
+static void board_write_begin(struct board* board) {
+	__atomic_store_n(&board->seq, board->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * Marks the end of a change to the board for readers on other threads.
+ */
+static void board_write_end(struct board* board) {
+	__atomic_store_n(&board->seq, board->seq + 1, __ATOMIC_RELEASE);
+}
@@ -19,25 +19,139 @@
 #ifndef board_H
 #define board_H
 
+#include "include.h"
+
+#include <endian.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "catalog.h"
 #include "die.h"
 #include "global.h"
 #include "gls.h"
 #include "plate.h"
+#include "score.h"
+
+/**
+ * Connection between two placed dice.
+ */
+struct board_connection {
+	// Player that made the connection.
+	char nick[GLS_NICK_LENGTH];
+	// Die numbers of the connected dice.
+	uint32_t from;
+	uint32_t to;
+};
 
 /**
  * Holds information about the actual game.
+ *
+ * Per-cell state is kept as a structure of arrays: the fields touched by
+ * board scans (plate identifier, abbreviation, and die occupancy) sit in dense
+ * per-cell arrays, while names and descriptions stay in the catalog and are
+ * only read when a single plate is displayed or sent.  An empty cell has the
+ * identifier 'CATALOG_PLATE_NONE' and an empty abbreviation.  Boards of the
+ * default size keep all of their storage inline and never allocate; a board
+ * of the default size must therefore not be copied by value.
  */
 struct board {
-	// Plates are arrange in a static 8x8 square for now.
-	struct plate plates[GLS_BOARD_ROW_COUNT][GLS_BOARD_COLUMN_COUNT];
+	// Board dimensions.
+	uint32_t rows;
+	uint32_t columns;
+	// Catalog holding the board's plates.
+	struct catalog* catalog;
+	// Catalog plate identifier for each cell in row-major order.
+	uint32_t* cells;
+	uint32_t cells_fixed[GLS_BOARD_ROW_COUNT * GLS_BOARD_COLUMN_COUNT];
+	// Plate abbreviation for each cell.
+	char (*abbrevs)[GLS_PLATE_ABBREV_LENGTH];
+	char abbrevs_fixed[GLS_BOARD_ROW_COUNT * GLS_BOARD_COLUMN_COUNT]
+		[GLS_PLATE_ABBREV_LENGTH];
+	// Die number plus one of the die on each cell; zero marks a cell
+	// without a die.
+	uint16_t* occupants;
+	uint16_t occupants_fixed[GLS_BOARD_ROW_COUNT * GLS_BOARD_COLUMN_COUNT];
 	// Game dice.
-	struct die dice[GLS_DIE_MAX];
+	struct die* dice;
+	uint32_t die_count;
+	struct die dice_fixed[GLS_DIE_COUNT];
+	// Number of dice placed; dice are placed in order.
+	uint32_t die_placed;
+	// Number of dice placed of each color.
+	uint32_t color_dice[GLS_COLOR_MAX + 1];
+	// Connections in the order made.  A connection must join two separate
+	// groups of connected dice, so there are fewer connections than dice.
+	struct board_connection* connections;
+	uint32_t connection_count;
+	struct board_connection connections_fixed[GLS_DIE_COUNT];
+	// Union-find forest over dice by die number: each die's parent and,
+	// for the root of each group, the number of dice in the group.
+	uint32_t* parents;
+	uint32_t parents_fixed[GLS_DIE_COUNT];
+	uint32_t* sizes;
+	uint32_t sizes_fixed[GLS_DIE_COUNT];
+	// Sequence count for readers on other threads; odd while the board is
+	// being changed.
+	uint32_t seq;
+	// Running scores.  Placing a die scores one point for its player and
+	// its color; making a connection scores its player the number of dice
+	// in the group it forms.
+	struct score score;
+	// Incremented on each change to the board.
+	uint64_t version;
 };
 
+/**
+ * Starts a read of the board from a thread other than the one changing it,
+ * waiting out any change in progress, and returns the sequence count to pass
+ * to 'board_read_retry'.  Such readers take no lock and never block the
+ * changing thread; they may only call functions that don't change the board,
+ * such as 'board_die_place_check', and must discard their results if
+ * 'board_read_retry' says to.
+ */
+static inline uint32_t board_read_begin(struct board* board) {
+	uint32_t seq;
+
+	while ((seq = __atomic_load_n(&board->seq, __ATOMIC_ACQUIRE)) & 1);
+	return seq;
+}
+
+/**
+ * Returns nonzero if the board changed since the matching
+ * 'board_read_begin', in which case the read must be retried.
+ */
+static inline int board_read_retry(struct board* board, uint32_t seq) {
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&board->seq, __ATOMIC_RELAXED) != seq;
+}
+
+/**
+ * Returns the die number representing the group of connected dice that the
+ * specified die belongs to.  Two dice are connected, directly or indirectly,
+ * if and only if they have the same group.
+ */
+uint32_t board_component(struct board* board, uint32_t die);
+
+/**
+ * Connects the specified placed dice on behalf of the specified player.
+ */
+struct flub* board_connect(struct board* board, char* nick, uint32_t from,
+	uint32_t to);
+
+/**
+ * Check if the specified dice may be connected: both must be placed and
+ * must not already be connected.
+ */
+struct flub* board_connect_check(struct board* board, uint32_t from,
+	uint32_t to);
+
+/**
+ * Load every plate in the board's catalog onto the board in row-major order.
+ * A board too small for the deck takes its first plates.
+ */
+struct flub* board_deck(struct board* board);
+
 /**
  * Attempts to place a die at the specified location on the board with the
  * specified color.  Sets 'color' and 'die' as per the corresponding, suffixed
@@ -45,6 +159,17 @@ struct board {
 struct flub* board_die_place(struct board* board, char* nick, char* location,
 	uint32_t* color, uint32_t* die);
 
+/**
+ * Returns the die at the specified row and column, or NULL if there is none.
+ */
+static inline struct die* board_die_get(struct board* board, uint32_t row,
+	uint32_t column) {
+	uint16_t occupant;
+
+	occupant = board->occupants[row * board->columns + column];
+	return occupant ? &board->dice[occupant - 1] : NULL;
+}
+
 /**
  * Check if a die may be placed at the specified location and with the given
  * color.  Outputs the color that will be used (if specified as the special
@@ -54,9 +179,81 @@ struct flub* board_die_place_check(struct board* board, char* location,
 	uint32_t* color, uint32_t* die);
 
 /**
- * Initialize the game board.
+ * Records the specified die as placed, for boards that are sent only part
+ * of the game.  Unlike 'board_die_place' the die need not be the next one
+ * and is not scored; earlier dice not yet recorded count as placed but have
+ * no location.
+ */
+struct flub* board_die_set(struct board* board, char* nick, char* location,
+	uint32_t color, uint32_t die);
+
+/**
+ * Frees any storage allocated for the board.
+ */
+void board_free(struct board* board);
+
+/**
+ * Initialize an empty game board using plates from the specified catalog and
+ * with the specified dimensions and number of dice.
+ */
+struct flub* board_init(struct board* board, struct catalog* catalog,
+	uint32_t rows, uint32_t columns, uint32_t dice);
+
+/**
+ * Parses the specified location into a row and column on the board.
+ */
+struct flub* board_location_parse(struct board* board, char* location,
+	uint32_t* row, uint32_t* column);
+
+/**
+ * Fills in the detail of the plate at the specified location, flagging it
+ * empty if there is none.  Changes nothing, so may be called by readers.
+ */
+struct flub* board_plate_detail(struct board* board, char* location,
+	struct gls_plate_detail* detail);
+
+/**
+ * Returns a hash of the board's plates and their locations, never zero, and
+ * sets 'plates' to the number of plates on the board.  Boards holding the same
+ * plates at the same locations have the same hash.
+ */
+uint64_t board_plate_hash(struct board* board, uint32_t* plates);
+
+/**
+ * Returns the catalog identifier of the plate at the specified row and column,
+ * or 'CATALOG_PLATE_NONE' if the cell is empty.
+ */
+static inline uint32_t board_plate_get(struct board* board, uint32_t row,
+	uint32_t column) {
+	return board->cells[row * board->columns + column];
+}
+
+/**
+ * Replaces the board with one deserialized from the specified buffer, as
+ * written by 'board_marshal', using plates from the specified catalog.
+ */
+struct flub* board_unmarshal(struct board* board, struct catalog* catalog,
+	char* buffer, size_t size);
+
+/**
+ * Places the specified catalog plate at the specified row and column,
+ * replacing any existing plate.  'CATALOG_PLATE_NONE' empties the cell.
+ */
+void board_plate_set(struct board* board, uint32_t row, uint32_t column,
+	uint32_t id);
+
+/**
+ * Serializes the board's plates, placed dice, and connections into a
+ * newly-allocated buffer which the caller must free.
+ */
+struct flub* board_marshal(struct board* board, char** buffer, size_t* size);
+
+/**
+ * Returns the size 'board_marshal' gives the board with the specified
+ * numbers of placed dice and connections.
  */
-void board_init(struct board* board);
+size_t board_marshal_size(struct board* board, uint32_t dice,
+	uint32_t connections);
 
 /**
  * Pretty-print the board to the specified file descriptor.
@@ -18,6 +18,11 @@ void cargs_help(struct cargs* args, struct flub* flub) {
 	fprintf(out, "\t-h --help  Print this usage message\n");
 	fprintf(out, "\t-n --nick  Connect using specified nickname (default: "
 		"'%s', cur: '%s')\n", CARGS_NICK_DEFAULT, args->nick);
+	fprintf(out, "\t-p --protocol  Speak specified protocol version "
+		"(default: '%s', cur: '%s')\n",
+		gls_protocol_versions[GLS_PROTOCOL_MAX], args->protocol);
+	fprintf(out, "\t-s --spectate  Watch the game from the server's "
+		"spectator port (cur: '%u')\n", args->spectate);
 
 	// Exit program.
 	if (flub) {
@@ -32,16 +37,23 @@ struct flub* cargs_parse(struct cargs* args, int argc, char* argv[]) {
 	struct option longopts[] = {
 		{"help", 0, NULL, 'h'},
 		{"nick", 1, NULL, 'n'},
+		{"protocol", 1, NULL, 'p'},
+		{"spectate", 1, NULL, 's'},
 		{0, 0, 0, 0}
 	};
+	char* end;
+	unsigned long port;
+	uint32_t protocol;
 	int ret;
 
 	// Set defaults.
 	memset(args, 0, sizeof(struct cargs));
 	strcpy(args->nick, CARGS_NICK_DEFAULT);
+	strcpy(args->protocol, gls_protocol_versions[GLS_PROTOCOL_MAX]);
 
 	// Parse arguments.
-	while((ret = getopt_long(argc, argv, ":n:", longopts, NULL)) != -1) {
+	while((ret = getopt_long(argc, argv, ":n:p:s:", longopts, NULL)) !=
+		-1) {
 		switch(ret) {
 		case 'h':
 			cargs_help(args, NULL);
@@ -51,6 +63,25 @@ struct flub* cargs_parse(struct cargs* args, int argc, char* argv[]) {
 				cargs_help(args, flub);
 			}
 			break;
+		case 'p':
+			strlcpy(args->protocol, optarg,
+				GLS_PROTOVER_VERSION_LENGTH);
+			if ((flub = gls_protocol_parse(args->protocol,
+				&protocol))) {
+				cargs_help(args, flub);
+			}
+			break;
+		case 's':
+			errno = 0;
+			port = strtoul(optarg, &end, 10);
+			if (errno || !strlen(optarg) || *end || !port ||
+				port > UINT16_MAX) {
+				flub = g_flub_toss("Invalid spectator port "
+					"'%s'", optarg);
+				cargs_help(args, flub);
+			}
+			args->spectate = (uint16_t)port;
+			break;
 		case ':':
 			flub = g_flub_toss("Missing argument after '%c'",
 				optopt);
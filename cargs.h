@@ -23,6 +23,8 @@
 #ifndef cargs_H
 #define cargs_H
 
+#include "include.h"
+
 #include <getopt.h>
 
 #include "gls.h"
@@ -31,6 +33,10 @@
 struct cargs {
 	// Nickname to use.
 	char nick[GLS_NICK_LENGTH];
+	// Protover version to speak.
+	char protocol[GLS_PROTOVER_VERSION_LENGTH];
+	// Spectator port to watch the game from, or zero to play.
+	uint16_t spectate;
 };
 
 // Print help message for client arguments then exit the program.
@@ -0,0 +1,492 @@
+/**
+ *  See 'catalog.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "catalog.h"
+
+// Default set of plates as name and abbreviation pairs.
+static const char* catalog_deck[][2] = {
+	{"Ambivalence", "Amb"},
+	{"Art Versus Nature", "AVN"},
+	{"The Need Not to Judge", "TNJ"},
+	{"Calculus", "Clc"},
+	{"City as Artifact", "CaA"},
+	{"Coding", "Cde"},
+	{"Contemplation", "Ctp"},
+	{"Continuity/Eternity", "C/E"},
+	{"Creation", "Crt"},
+	{"Ontogeny Recapitulates Phylogeny", "ORP"},
+	{"Education", "Edu"},
+	{"Helplessness", "Hlp"},
+	{"Intuition", "Itu"},
+	{"Monetary Value", "MnV"},
+	{"Wavicle", "Wav"},
+	{"Freedom", "Fre"},
+	{"Emotional Manipulation", "EmM"},
+	{"Gestalt", "Gst"},
+	{"Harmony", "Hrm"},
+	{"Hidden Potential", "HdP"},
+	{"Joy", "Joy"},
+	{"Magic", "Mgc"},
+	{"Mechanical Advantage", "McA"},
+	{"Metamorphosis", "Mtm"},
+	{"Nature Tending Towards Perfection", "NTP"},
+	{"Myth", "Mth"},
+	{"Coexisting Species", "CxS"},
+	{"Perspective", "Prp"},
+	{"Reaching Out", "RcO"},
+	{"Return", "Rtn"},
+	{"Society as Active/Passive Hierarchy", "SoH"},
+	{"Structural Strength", "StS"},
+	{"Struggle", "Stg"},
+	{"Synergy", "Syg"},
+	{"Syntax", "Stx"},
+	{"Unwanted Relationships", "UwR"},
+	{"Structural Improvisation", "StI"},
+	{"Anthropomorphism", "Anp"},
+};
+
+static struct flub* catalog_intern(struct catalog* catalog, const char* string,
+	uint32_t* offset);
+static struct flub* catalog_string_check(const char* string, size_t size,
+	int empty);
+
+struct flub* catalog_default(struct catalog* catalog) {
+	struct flub* flub;
+	int i;
+	uint32_t id;
+
+	// Add each default plate.
+	catalog_init(catalog);
+	for (i = 0; i < sizeof(catalog_deck) / sizeof(catalog_deck[0]); i++) {
+		if ((flub = catalog_plate_add(catalog, catalog_deck[i][0],
+			catalog_deck[i][1], "", &id))) {
+			catalog_free(catalog);
+			return flub_append(flub, "building default catalog");
+		}
+	}
+	return NULL;
+}
+
+void catalog_free(struct catalog* catalog) {
+	// Unmap or free storage.
+	if (catalog->map) {
+		if (munmap(catalog->map, catalog->map_size) == -1) {
+			g_log_warn("Unable to unmap catalog: '%s'",
+				g_serr(errno));
+		}
+	} else {
+		free(catalog->records);
+		free(catalog->strings);
+	}
+	free(catalog->interns);
+	memset(catalog, 0, sizeof(struct catalog));
+}
+
+struct flub* catalog_import(struct catalog* catalog, char* path) {
+	char* abbrev;
+	char* description;
+	FILE* file;
+	struct flub* flub;
+	uint32_t id;
+	char* line;
+	size_t line_size;
+	int number;
+	char* name;
+
+	// Open text file.
+	if (!(file = fopen(path, "r"))) {
+		return g_flub_toss("Unable to open plate file '%s': '%s'",
+			path, g_serr(errno));
+	}
+
+	// Add a plate for each line.
+	flub = NULL;
+	line = NULL;
+	line_size = 0;
+	for (number = 1; getline(&line, &line_size, file) != -1; number++) {
+		// Split fields.
+		line[strcspn(line, "\r\n")] = '\0';
+		if (!strlen(line)) {
+			continue;
+		}
+		abbrev = line;
+		if (!(name = strchr(abbrev, '\t'))) {
+			flub = g_flub_toss("Missing plate name on line '%i'",
+				number);
+			break;
+		}
+		*(name++) = '\0';
+		if ((description = strchr(name, '\t'))) {
+			*(description++) = '\0';
+		} else {
+			description = "";
+		}
+
+		// Add plate.
+		if ((flub = catalog_plate_add(catalog, name, abbrev,
+			description, &id))) {
+			flub_append(flub, "on line '%i'", number);
+			break;
+		}
+	}
+	if (!flub && ferror(file)) {
+		flub = g_flub_toss("Unable to read plate file '%s'", path);
+	}
+	free(line);
+	if (fclose(file) == EOF) {
+		g_log_warn("Unable to close plate file: '%s'", g_serr(errno));
+	}
+	return flub;
+}
+
+void catalog_init(struct catalog* catalog) {
+	memset(catalog, 0, sizeof(struct catalog));
+}
+
+struct flub* catalog_map(struct catalog* catalog, char* path) {
+	int fd;
+	struct flub* flub;
+	struct catalog_header* header;
+	uint32_t i;
+	uint32_t length;
+	void* map;
+	uint32_t offset;
+	uint32_t plate_count;
+	struct catalog_record* record;
+	size_t size;
+	struct stat st;
+	char* strings;
+	uint32_t strings_size;
+
+	// Map the file.
+	catalog_init(catalog);
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		return g_flub_toss("Unable to open catalog '%s': '%s'", path,
+			g_serr(errno));
+	}
+	if (fstat(fd, &st) == -1) {
+		flub = g_flub_toss("Unable to stat catalog '%s': '%s'", path,
+			g_serr(errno));
+		close(fd);
+		return flub;
+	}
+	size = st.st_size;
+	if (size < sizeof(struct catalog_header)) {
+		close(fd);
+		return g_flub_toss("Catalog '%s' too small", path);
+	}
+	map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (close(fd) == -1) {
+		g_log_warn("Unable to close catalog: '%s'", g_serr(errno));
+	}
+	if (map == MAP_FAILED) {
+		return g_flub_toss("Unable to map catalog '%s': '%s'", path,
+			g_serr(errno));
+	}
+	catalog->map = map;
+	catalog->map_size = size;
+
+	// Check header.
+	header = (struct catalog_header*)map;
+	plate_count = be32toh(header->plate_count);
+	strings_size = be32toh(header->strings_size);
+	if (memcmp(header->magic, CATALOG_MAGIC, sizeof(header->magic))) {
+		flub = g_flub_toss("Bad catalog magic");
+		goto err;
+	} else if (be32toh(header->version) != CATALOG_VERSION) {
+		flub = g_flub_toss("Unsupported catalog version '%u'",
+			be32toh(header->version));
+		goto err;
+	} else if ((size - sizeof(struct catalog_header)) /
+		sizeof(struct catalog_record) < plate_count ||
+		size != sizeof(struct catalog_header) + plate_count *
+		sizeof(struct catalog_record) + strings_size) {
+		flub = g_flub_toss("Catalog size mismatch");
+		goto err;
+	}
+	record = (struct catalog_record*)(header + 1);
+	strings = (char*)(record + plate_count);
+
+	// Check strings and records.
+	if (strings_size && strings[strings_size - 1] != '\0') {
+		flub = g_flub_toss("Unterminated catalog string table");
+		goto err;
+	}
+	for (i = 0; i < strings_size; i++) {
+		if (strings[i] && !isprint(strings[i])) {
+			flub = g_flub_toss("Invalid catalog string char at "
+				"'%u'", i);
+			goto err;
+		}
+	}
+	for (i = 0; i < plate_count; i++) {
+		if (be32toh(record[i].name) >= strings_size ||
+			be32toh(record[i].description) >= strings_size) {
+			flub = g_flub_toss("Catalog plate '%u' string out of "
+				"range", i);
+			goto err;
+		} else if ((flub = catalog_string_check(record[i].abbrev,
+			GLS_PLATE_ABBREV_LENGTH, 0))) {
+			flub_append(flub, "catalog plate '%u'", i);
+			goto err;
+		}
+
+		// Hold strings to the limits 'catalog_plate_add' sets,
+		// scanning no further than the string table.
+		offset = be32toh(record[i].name);
+		length = strings_size - offset;
+		if ((flub = catalog_string_check(&strings[offset],
+			length < GLS_PLATE_NAME_LENGTH ? length :
+			GLS_PLATE_NAME_LENGTH, 0))) {
+			flub_append(flub, "catalog plate '%u' name", i);
+			goto err;
+		}
+		offset = be32toh(record[i].description);
+		length = strings_size - offset;
+		if ((flub = catalog_string_check(&strings[offset],
+			length < GLS_PLATE_DESCRIPTION_LENGTH ? length :
+			GLS_PLATE_DESCRIPTION_LENGTH, 1))) {
+			flub_append(flub, "catalog plate '%u' description",
+				i);
+			goto err;
+		}
+	}
+	catalog->records = record;
+	catalog->record_count = plate_count;
+	catalog->record_size = plate_count;
+	catalog->strings = strings;
+	catalog->strings_count = strings_size;
+	catalog->strings_size = strings_size;
+	return NULL;
+
+err:
+	catalog_free(catalog);
+	return flub_append(flub, "mapping '%s'", path);
+}
+
+void catalog_plate(struct catalog* catalog, uint32_t id, struct plate* plate) {
+	struct catalog_record* record;
+
+	record = &catalog->records[id];
+	plate->abbrev = record->abbrev;
+	plate->name = &catalog->strings[be32toh(record->name)];
+	plate->description = &catalog->strings[be32toh(record->description)];
+}
+
+struct flub* catalog_plate_add(struct catalog* catalog, const char* name,
+	const char* abbrev, const char* description, uint32_t* id) {
+	uint32_t description_offset;
+	struct flub* flub;
+	uint32_t name_offset;
+	struct catalog_record* record;
+
+	// Check plate.
+	if (catalog->map) {
+		return g_flub_toss("Mapped catalogs are read-only");
+	} else if ((flub = catalog_string_check(name, GLS_PLATE_NAME_LENGTH,
+		0))) {
+		return flub_append(flub, "checking plate name");
+	} else if ((flub = catalog_string_check(abbrev,
+		GLS_PLATE_ABBREV_LENGTH, 0))) {
+		return flub_append(flub, "checking plate abbreviation");
+	} else if ((flub = catalog_string_check(description,
+		GLS_PLATE_DESCRIPTION_LENGTH, 1))) {
+		return flub_append(flub, "checking plate description");
+	} else if (catalog->record_count == CATALOG_PLATE_NONE) {
+		return g_flub_toss("Catalog full");
+	}
+
+	// Intern strings.
+	if ((flub = catalog_intern(catalog, name, &name_offset))) {
+		return flub;
+	} else if ((flub = catalog_intern(catalog, description,
+		&description_offset))) {
+		return flub;
+	}
+
+	// Add record.
+	if (catalog->record_count == catalog->record_size) {
+		struct catalog_record* records;
+		uint32_t size;
+
+		size = catalog->record_size ? catalog->record_size * 2 : 64;
+		records = realloc(catalog->records,
+			size * sizeof(struct catalog_record));
+		if (!records) {
+			return g_flub_toss("Unable to allocate catalog "
+				"records");
+		}
+		catalog->records = records;
+		catalog->record_size = size;
+	}
+	record = &catalog->records[catalog->record_count];
+	memset(record, 0, sizeof(struct catalog_record));
+	record->name = htobe32(name_offset);
+	record->description = htobe32(description_offset);
+	strlcpy(record->abbrev, abbrev, GLS_PLATE_ABBREV_LENGTH);
+	(*id) = catalog->record_count++;
+	return NULL;
+}
+
+struct flub* catalog_write(struct catalog* catalog, char* path) {
+	int fd;
+	struct flub* flub;
+	struct catalog_header header;
+	struct iovec iovs[3];
+	ssize_t len;
+	char tmp[PATH_MAX];
+
+	// Prepare header.
+	memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+	header.version = htobe32(CATALOG_VERSION);
+	header.plate_count = htobe32(catalog->record_count);
+	header.strings_size = htobe32(catalog->strings_count);
+
+	// Write to a temporary file then move it into place.
+	if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= sizeof(tmp)) {
+		return g_flub_toss("Catalog path too long");
+	}
+	if ((fd = open(tmp, O_CREAT | O_TRUNC | O_WRONLY, 0644)) == -1) {
+		return g_flub_toss("Unable to create catalog '%s': '%s'", tmp,
+			g_serr(errno));
+	}
+	len = 0;
+	iovs[0].iov_base = &header;
+	len += iovs[0].iov_len = sizeof(header);
+	iovs[1].iov_base = catalog->records;
+	len += iovs[1].iov_len = catalog->record_count *
+		sizeof(struct catalog_record);
+	iovs[2].iov_base = catalog->strings;
+	len += iovs[2].iov_len = catalog->strings_count;
+	flub = NULL;
+	if (gls_writevn(fd, iovs, 3) < len) {
+		flub = g_flub_toss("Unable to write catalog: '%s'",
+			g_serr(errno));
+	} else if (fsync(fd) == -1) {
+		flub = g_flub_toss("Unable to sync catalog: '%s'",
+			g_serr(errno));
+	}
+	if (close(fd) == -1 && !flub) {
+		flub = g_flub_toss("Unable to close catalog: '%s'",
+			g_serr(errno));
+	}
+	if (!flub && rename(tmp, path) == -1) {
+		flub = g_flub_toss("Unable to rename catalog to '%s': '%s'",
+			path, g_serr(errno));
+	}
+	return flub;
+}
+
+/**
+ * Outputs the string table offset of the specified string, adding it to the
+ * table if it isn't already present.
+ */
+static struct flub* catalog_intern(struct catalog* catalog, const char* string,
+	uint32_t* offset) {
+	uint32_t i;
+	size_t length;
+	uint32_t mask;
+
+	// Grow intern table to keep it at most half full.
+	if (catalog->intern_size < 2 * (catalog->record_count * 2 + 2)) {
+		uint32_t* interns;
+		uint32_t j;
+		uint32_t size;
+
+		size = catalog->intern_size ? catalog->intern_size * 2 : 256;
+		interns = calloc(size, sizeof(uint32_t));
+		if (!interns) {
+			return g_flub_toss("Unable to allocate intern table");
+		}
+		for (j = 0; j < catalog->intern_size; j++) {
+			char* old;
+
+			if (!catalog->interns[j]) {
+				continue;
+			}
+			old = &catalog->strings[catalog->interns[j] - 1];
+			i = g_hash(old, strlen(old)) & (size - 1);
+			while (interns[i]) {
+				i = (i + 1) & (size - 1);
+			}
+			interns[i] = catalog->interns[j];
+		}
+		free(catalog->interns);
+		catalog->interns = interns;
+		catalog->intern_size = size;
+	}
+
+	// Look up string.
+	length = strlen(string);
+	mask = catalog->intern_size - 1;
+	for (i = g_hash(string, length) & mask; catalog->interns[i];
+		i = (i + 1) & mask) {
+		if (!strcmp(&catalog->strings[catalog->interns[i] - 1],
+			string)) {
+			(*offset) = catalog->interns[i] - 1;
+			return NULL;
+		}
+	}
+
+	// Append string.
+	if (catalog->strings_count + length + 1 > catalog->strings_size) {
+		char* strings;
+		uint32_t size;
+
+		size = catalog->strings_size ? catalog->strings_size : 4096;
+		while (catalog->strings_count + length + 1 > size) {
+			size *= 2;
+		}
+		strings = realloc(catalog->strings, size);
+		if (!strings) {
+			return g_flub_toss("Unable to allocate string table");
+		}
+		catalog->strings = strings;
+		catalog->strings_size = size;
+	}
+	(*offset) = catalog->strings_count;
+	memcpy(&catalog->strings[catalog->strings_count], string, length + 1);
+	catalog->strings_count += length + 1;
+	catalog->interns[i] = (*offset) + 1;
+	return NULL;
+}
+
+/**
+ * Returns a flub if the specified string isn't a printable, NUL-terminated
+ * string that fits within 'size' bytes.  A nonzero 'empty' allows the empty
+ * string.
+ */
+static struct flub* catalog_string_check(const char* string, size_t size,
+	int empty) {
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (string[i] == '\0') {
+			break;
+		} else if (!isprint(string[i])) {
+			return g_flub_toss("Invalid char at index '%zu'", i);
+		}
+	}
+	if (i == size) {
+		return g_flub_toss("String exceeded '%zu' characters",
+			size - 1);
+	} else if (!i && !empty) {
+		return g_flub_toss("Empty string");
+	}
+	return NULL;
+}
@@ -0,0 +1,134 @@
+/**
+ *  Catalog of plate concepts shared by every board in the process.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef catalog_H
+#define catalog_H
+
+#include "include.h"
+
+#include <ctype.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "global.h"
+#include "gls.h"
+#include "plate.h"
+
+// Catalog file magic and format version.
+#define CATALOG_MAGIC "GLSC"
+#define CATALOG_VERSION 1
+// Plate identifier for "no plate".
+#define CATALOG_PLATE_NONE 0xFFFFFFFF
+
+/**
+ * Catalog file header.  A catalog file consists of the header, followed by
+ * 'plate_count' plate records, followed by a string table of 'strings_size'
+ * bytes holding NUL-terminated strings.  All integers are big endian.
+ */
+struct catalog_header {
+	char magic[4];
+	uint32_t version;
+	uint32_t plate_count;
+	uint32_t strings_size;
+};
+
+/**
+ * Catalog plate record; names and descriptions are offsets into the string
+ * table.
+ */
+struct catalog_record {
+	uint32_t name;
+	uint32_t description;
+	char abbrev[GLS_PLATE_ABBREV_LENGTH];
+};
+
+/**
+ * Plate catalog.  A catalog is either mapped read-only from a catalog file or
+ * built in memory; strings in built catalogs are interned so that each
+ * distinct string is stored once.
+ */
+struct catalog {
+	// Plate records.
+	struct catalog_record* records;
+	uint32_t record_count;
+	uint32_t record_size;
+	// String table.
+	char* strings;
+	uint32_t strings_count;
+	uint32_t strings_size;
+	// Open-addressed table of string offsets plus one (built catalogs).
+	uint32_t* interns;
+	uint32_t intern_size;
+	// File mapping (mapped catalogs).
+	void* map;
+	size_t map_size;
+};
+
+/**
+ * Initialize the specified catalog with the default set of plates.
+ */
+struct flub* catalog_default(struct catalog* catalog);
+
+/**
+ * Frees any resources held by the catalog.
+ */
+void catalog_free(struct catalog* catalog);
+
+/**
+ * Appends plates from a text file to the specified built catalog.  Each line
+ * holds a plate's abbreviation, name, and optional description separated by
+ * tabs.
+ */
+struct flub* catalog_import(struct catalog* catalog, char* path);
+
+/**
+ * Initialize an empty, built catalog.
+ */
+void catalog_init(struct catalog* catalog);
+
+/**
+ * Maps the catalog file at the specified path read-only into the specified
+ * catalog.
+ */
+struct flub* catalog_map(struct catalog* catalog, char* path);
+
+/**
+ * Fills 'plate' with the strings of the specified plate.
+ */
+void catalog_plate(struct catalog* catalog, uint32_t id, struct plate* plate);
+
+/**
+ * Adds a plate to the specified built catalog and outputs its identifier.
+ */
+struct flub* catalog_plate_add(struct catalog* catalog, const char* name,
+	const char* abbrev, const char* description, uint32_t* id);
+
+/**
+ * Writes the catalog to a catalog file at the specified path.
+ */
+struct flub* catalog_write(struct catalog* catalog, char* path);
+
+#endif // catalog_H
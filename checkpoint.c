@@ -0,0 +1,334 @@
+/**
+ *  See 'checkpoint.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "checkpoint.h"
+
+static uint32_t checkpoint_crc(char* slot, uint32_t size);
+static int checkpoint_slot_check(struct checkpoint* checkpoint, int slot,
+	uint64_t* generation);
+static void* checkpoint_thread(void* checkpoint);
+
+void checkpoint_close(struct checkpoint* checkpoint) {
+	int ret;
+
+	// Stop writer thread once the queue is empty.
+	if (checkpoint->running) {
+		pthread_mutex_lock(&checkpoint->mutex);
+		checkpoint->running = 0;
+		pthread_cond_signal(&checkpoint->cond);
+		pthread_mutex_unlock(&checkpoint->mutex);
+		if ((ret = pthread_join(checkpoint->thread, NULL))) {
+			g_log_warn("Unable to join checkpoint thread: '%s'",
+				g_serr(ret));
+		}
+	}
+
+	// Unmap file.
+	if (checkpoint->map && munmap(checkpoint->map, checkpoint->map_size)
+		== -1) {
+		g_log_warn("Unable to unmap checkpoint: '%s'", g_serr(errno));
+	}
+	if (checkpoint->fd != -1 && close(checkpoint->fd) == -1) {
+		g_log_warn("Unable to close checkpoint: '%s'", g_serr(errno));
+	}
+	pthread_cond_destroy(&checkpoint->cond);
+	pthread_mutex_destroy(&checkpoint->mutex);
+	free(checkpoint->pending);
+	checkpoint->fd = -1;
+	checkpoint->map = NULL;
+	checkpoint->pending = NULL;
+}
+
+struct flub* checkpoint_open(struct checkpoint* checkpoint, char* path,
+	uint32_t interval, struct board* board, uint64_t* seq, int* loaded) {
+	struct catalog* catalog;
+	struct flub* flub;
+	uint64_t generation[2];
+	char* header;
+	long page;
+	int ret;
+	size_t size;
+	int slot;
+	struct stat st;
+	uint32_t tmp;
+	int valid[2];
+
+	// Initialize checkpoint.
+	memset(checkpoint, 0, sizeof(struct checkpoint));
+	checkpoint->fd = -1;
+	checkpoint->interval = interval;
+	checkpoint->slot = 1;
+	(*loaded) = 0;
+	if ((ret = pthread_mutex_init(&checkpoint->mutex, NULL))) {
+		return g_flub_toss("Unable to create checkpoint mutex: '%s'",
+			g_serr(ret));
+	}
+	if ((ret = pthread_cond_init(&checkpoint->cond, NULL))) {
+		pthread_mutex_destroy(&checkpoint->mutex);
+		return g_flub_toss("Unable to create checkpoint condition: "
+			"'%s'", g_serr(ret));
+	}
+
+	// Open file.
+	if ((checkpoint->fd = open(path, O_RDWR | O_CREAT, 0644)) == -1) {
+		flub = g_flub_toss("Unable to open checkpoint '%s': '%s'",
+			path, g_serr(errno));
+		goto err;
+	}
+	if (fstat(checkpoint->fd, &st) == -1) {
+		flub = g_flub_toss("Unable to stat checkpoint: '%s'",
+			g_serr(errno));
+		goto err;
+	}
+	page = sysconf(_SC_PAGESIZE);
+
+	// Map an existing file and look for its latest valid slot.
+	valid[0] = valid[1] = 0;
+	if (st.st_size && !(st.st_size % (2 * page))) {
+		checkpoint->map_size = st.st_size;
+		checkpoint->slot_size = st.st_size / 2;
+		checkpoint->map = mmap(NULL, checkpoint->map_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED, checkpoint->fd, 0);
+		if (checkpoint->map == MAP_FAILED) {
+			checkpoint->map = NULL;
+			flub = g_flub_toss("Unable to map checkpoint: '%s'",
+				g_serr(errno));
+			goto err;
+		}
+		valid[0] = checkpoint_slot_check(checkpoint, 0, &generation[0]);
+		valid[1] = checkpoint_slot_check(checkpoint, 1, &generation[1]);
+	}
+	if (valid[0] || valid[1]) {
+		// Load the newest slot.
+		slot = valid[0] && (!valid[1] ||
+			generation[0] > generation[1]) ? 0 : 1;
+		header = &checkpoint->map[slot * checkpoint->slot_size];
+		memcpy(&tmp, &header[24], sizeof(uint32_t));
+		catalog = board->catalog;
+		board_free(board);
+		if ((flub = board_unmarshal(board, catalog,
+			&header[CHECKPOINT_HEADER_SIZE], be32toh(tmp)))) {
+			flub_append(flub, "loading checkpoint");
+			goto err;
+		}
+		memcpy(seq, &header[16], sizeof(uint64_t));
+		(*seq) = be64toh(*seq);
+		checkpoint->slot = slot;
+		checkpoint->generation = generation[slot];
+		(*loaded) = 1;
+		g_log_info("Loaded checkpoint generation '%llu'",
+			(unsigned long long)checkpoint->generation);
+	} else {
+		// Size a new file for the board.
+		if (st.st_size) {
+			g_log_warn("No valid checkpoint in '%s'; starting "
+				"over", path);
+		}
+		if (checkpoint->map &&
+			munmap(checkpoint->map, checkpoint->map_size) == -1) {
+			g_log_warn("Unable to unmap checkpoint: '%s'",
+				g_serr(errno));
+		}
+		// Fit every die placed and connected; connections join
+		// separate groups, so there is one fewer than dice.
+		size = CHECKPOINT_HEADER_SIZE + board_marshal_size(board,
+			board->die_count, board->die_count - 1);
+		checkpoint->slot_size = (size + page - 1) / page * page;
+		checkpoint->map_size = 2 * checkpoint->slot_size;
+		if (ftruncate(checkpoint->fd, 0) == -1 ||
+			ftruncate(checkpoint->fd, checkpoint->map_size) == -1) {
+			checkpoint->map = NULL;
+			flub = g_flub_toss("Unable to size checkpoint: '%s'",
+				g_serr(errno));
+			goto err;
+		}
+		checkpoint->map = mmap(NULL, checkpoint->map_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED, checkpoint->fd, 0);
+		if (checkpoint->map == MAP_FAILED) {
+			checkpoint->map = NULL;
+			flub = g_flub_toss("Unable to map checkpoint: '%s'",
+				g_serr(errno));
+			goto err;
+		}
+	}
+	checkpoint->version = board->version;
+	checkpoint->last = time(NULL);
+
+	// Start writer thread.
+	checkpoint->running = 1;
+	if ((ret = pthread_create(&checkpoint->thread, NULL,
+		checkpoint_thread, (void*)checkpoint))) {
+		checkpoint->running = 0;
+		flub = g_flub_toss("Unable to create checkpoint thread: '%s'",
+			g_serr(ret));
+		goto err;
+	}
+	return NULL;
+
+err:
+	checkpoint_close(checkpoint);
+	return flub_append(flub, "opening checkpoint '%s'", path);
+}
+
+struct flub* checkpoint_save(struct checkpoint* checkpoint,
+	struct board* board, uint64_t seq, int force) {
+	char* buffer;
+	struct flub* flub;
+	time_t now;
+	size_t size;
+
+	// Check whether a checkpoint is due.
+	now = time(NULL);
+	if (!force && (board->version == checkpoint->version ||
+		now - checkpoint->last < checkpoint->interval)) {
+		return NULL;
+	}
+
+	// Marshal board and hand it to the writer thread.
+	if ((flub = board_marshal(board, &buffer, &size))) {
+		return flub_append(flub, "checkpointing board");
+	} else if (CHECKPOINT_HEADER_SIZE + size > checkpoint->slot_size) {
+		free(buffer);
+		return g_flub_toss("Board too large for checkpoint slot");
+	}
+	pthread_mutex_lock(&checkpoint->mutex);
+	free(checkpoint->pending);
+	checkpoint->pending = buffer;
+	checkpoint->pending_size = size;
+	checkpoint->pending_seq = seq;
+	pthread_cond_signal(&checkpoint->cond);
+	pthread_mutex_unlock(&checkpoint->mutex);
+	checkpoint->version = board->version;
+	checkpoint->last = now;
+	return NULL;
+}
+
+/**
+ * Returns the CRC of a slot's header (excluding the CRC field itself) and
+ * the 'size' bytes of board that follow it.
+ */
+static uint32_t checkpoint_crc(char* slot, uint32_t size) {
+	uint32_t crc;
+
+	crc = g_crc32(0, slot, 28);
+	return g_crc32(crc, &slot[CHECKPOINT_HEADER_SIZE], size);
+}
+
+/**
+ * Returns nonzero and outputs the generation if the specified slot holds a
+ * valid checkpoint.
+ */
+static int checkpoint_slot_check(struct checkpoint* checkpoint, int slot,
+	uint64_t* generation) {
+	uint32_t crc;
+	char* header;
+	uint32_t size;
+	uint32_t version;
+
+	// Check header fields then CRC.
+	header = &checkpoint->map[slot * checkpoint->slot_size];
+	memcpy(&version, &header[4], sizeof(uint32_t));
+	memcpy(&size, &header[24], sizeof(uint32_t));
+	memcpy(&crc, &header[28], sizeof(uint32_t));
+	size = be32toh(size);
+	if (memcmp(header, CHECKPOINT_MAGIC, 4) ||
+		be32toh(version) != CHECKPOINT_VERSION ||
+		size > checkpoint->slot_size - CHECKPOINT_HEADER_SIZE ||
+		be32toh(crc) != checkpoint_crc(header, size)) {
+		return 0;
+	}
+	memcpy(generation, &header[8], sizeof(uint64_t));
+	(*generation) = be64toh(*generation);
+	return 1;
+}
+
+/**
+ * Writer thread; writes queued boards to alternating slots.
+ */
+static void* checkpoint_thread(void* v_checkpoint) {
+	char* buffer;
+	struct checkpoint* checkpoint = (struct checkpoint*)v_checkpoint;
+	uint32_t crc;
+	uint64_t generation;
+	char* header;
+	uint64_t seq;
+	size_t size;
+	uint32_t tmp;
+
+	// Initialize thread-specific data.
+	if (g_serr_init()) {
+		g_log_error("Unable to setup system error buffer");
+		return NULL;
+	}
+	if (g_flub_init()) {
+		g_log_error("Unable to initialize flub");
+		return NULL;
+	}
+
+	while (1) {
+		// Take queued board.
+		pthread_mutex_lock(&checkpoint->mutex);
+		while (checkpoint->running && !checkpoint->pending) {
+			pthread_cond_wait(&checkpoint->cond,
+				&checkpoint->mutex);
+		}
+		if (!checkpoint->pending) {
+			pthread_mutex_unlock(&checkpoint->mutex);
+			break;
+		}
+		buffer = checkpoint->pending;
+		size = checkpoint->pending_size;
+		seq = checkpoint->pending_seq;
+		checkpoint->pending = NULL;
+		pthread_mutex_unlock(&checkpoint->mutex);
+
+		// Write and sync board into the older slot.
+		header = &checkpoint->map[(1 - checkpoint->slot) *
+			checkpoint->slot_size];
+		memset(header, 0, CHECKPOINT_HEADER_SIZE);
+		memcpy(&header[CHECKPOINT_HEADER_SIZE], buffer, size);
+		free(buffer);
+		if (msync(header, CHECKPOINT_HEADER_SIZE + size, MS_SYNC)
+			== -1) {
+			g_log_error("Unable to sync checkpoint: '%s'",
+				g_serr(errno));
+			continue;
+		}
+
+		// Write and sync header.
+		memcpy(header, CHECKPOINT_MAGIC, 4);
+		tmp = htobe32(CHECKPOINT_VERSION);
+		memcpy(&header[4], &tmp, sizeof(uint32_t));
+		generation = htobe64(checkpoint->generation + 1);
+		memcpy(&header[8], &generation, sizeof(uint64_t));
+		seq = htobe64(seq);
+		memcpy(&header[16], &seq, sizeof(uint64_t));
+		tmp = htobe32(size);
+		memcpy(&header[24], &tmp, sizeof(uint32_t));
+		crc = htobe32(checkpoint_crc(header, size));
+		memcpy(&header[28], &crc, sizeof(uint32_t));
+		if (msync(header, CHECKPOINT_HEADER_SIZE, MS_SYNC) == -1) {
+			g_log_error("Unable to sync checkpoint header: '%s'",
+				g_serr(errno));
+			continue;
+		}
+		checkpoint->slot = 1 - checkpoint->slot;
+		checkpoint->generation++;
+	}
+	return NULL;
+}
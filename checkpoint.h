@@ -0,0 +1,105 @@
+/**
+ *  Crash-consistent board checkpoints in a memory-mapped file.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef checkpoint_H
+#define checkpoint_H
+
+#include "include.h"
+
+#include <endian.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "global.h"
+
+// Checkpoint slot magic and format version.
+#define CHECKPOINT_MAGIC "GLSK"
+#define CHECKPOINT_VERSION 2
+// Default seconds between checkpoints.
+#define CHECKPOINT_INTERVAL 5
+// Size of a slot header.
+#define CHECKPOINT_HEADER_SIZE 32
+
+/**
+ * Checkpoint file.  The file holds two equally-sized, page-aligned slots;
+ * each starts with a header holding a generation number, the journal
+ * sequence number the board reflects, and a CRC over the header and the
+ * marshaled board that follows it.  A checkpoint is written to the slot not
+ * holding the latest one: the board is copied and synced first, then the
+ * header, so a crash at any point leaves at least one valid slot.  Boards
+ * are marshaled by the game thread and written by a separate thread.
+ */
+struct checkpoint {
+	// Mapped file.
+	int fd;
+	char* map;
+	size_t map_size;
+	// Size of each slot.
+	size_t slot_size;
+	// Slot holding the latest checkpoint.
+	int slot;
+	// Generation of the latest checkpoint.
+	uint64_t generation;
+	// Writer thread.
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	// Marshaled board waiting to be written.
+	char* pending;
+	size_t pending_size;
+	uint64_t pending_seq;
+	// Board version of the last queued checkpoint.
+	uint64_t version;
+	// Time of the last queued checkpoint and seconds between checkpoints.
+	time_t last;
+	uint32_t interval;
+	// Writer thread running.
+	unsigned running:1;
+};
+
+/**
+ * Writes any queued checkpoint, stops the writer thread, and unmaps the file.
+ */
+void checkpoint_close(struct checkpoint* checkpoint);
+
+/**
+ * Maps the checkpoint file at the specified path, creating it if needed, and
+ * starts the writer thread.  If the file holds a valid checkpoint then the
+ * board is replaced with it, 'seq' is set to its journal sequence number,
+ * and 'loaded' is set; otherwise the board is left as-is and the file is
+ * sized for it.  Checkpoints are queued at most every 'interval' seconds.
+ */
+struct flub* checkpoint_open(struct checkpoint* checkpoint, char* path,
+	uint32_t interval, struct board* board, uint64_t* seq, int* loaded);
+
+/**
+ * Queues a checkpoint of the board, which reflects journal records up to
+ * 'seq'.  Unless 'force' is set, the board is only queued if it changed and
+ * the checkpoint interval has passed.
+ */
+struct flub* checkpoint_save(struct checkpoint* checkpoint,
+	struct board* board, uint64_t seq, int force);
+
+#endif // checkpoint_H
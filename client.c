@@ -89,13 +89,228 @@ struct flub* client_nickname_write(struct client* client, char* nickname) {
 	return NULL;
 }
 
+struct flub* client_plate_place(struct client* client,
+	struct gls_plate_place* place) {
+	uint32_t column;
+	struct flub* flub;
+	uint32_t id;
+	uint32_t row;
+
+	// Copy plate to game board.
+	if ((flub = board_location_parse(&client->board, place->loc, &row,
+		&column))) {
+		return flub_append(flub, "placing plate");
+	}
+	client->brief[row * client->board.columns + column] = 0;
+	if (place->flags & GLS_PLATE_FLAG_EMPTY) {
+		board_plate_set(&client->board, row, column,
+			CATALOG_PLATE_NONE);
+		return NULL;
+	}
+	if (place->flags & GLS_PLATE_FLAG_BRIEF) {
+		// Stand the abbreviation in for the name until details arrive.
+		client->brief[row * client->board.columns + column] = 1;
+		flub = catalog_plate_add(&client->catalog, place->abbrev,
+			place->abbrev, "", &id);
+	} else {
+		flub = catalog_plate_add(&client->catalog, place->name,
+			place->abbrev, place->description, &id);
+	}
+	if (flub) {
+		return flub_append(flub, "adding plate");
+	}
+	board_plate_set(&client->board, row, column, id);
+
+	// Keep the plate for the next synchronization.
+	if (client->plates_fd != -1) {
+		if ((flub = gls_plate_place_write(place, client->plates_fd))) {
+			return flub_append(flub, "caching plate");
+		}
+		client->plates_left--;
+	}
+	return NULL;
+}
+
+struct flub* client_plates_close(struct client* client) {
+	struct flub* flub;
+	char tmp[PATH_MAX];
+
+	// Move a complete cache into place.
+	if (client->plates_fd == -1) {
+		return NULL;
+	}
+	flub = NULL;
+	if (snprintf(tmp, sizeof(tmp), "%s.%d", client->plates_path,
+		(int)getpid()) >= sizeof(tmp)) {
+		flub = g_flub_toss("Plate cache path too long");
+	}
+	if (close(client->plates_fd) == -1 && !flub) {
+		flub = g_flub_toss("Unable to close plate cache: '%s'",
+			g_serr(errno));
+	} else if (client->plates_left) {
+		flub = g_flub_toss("Plate cache missing %u plates",
+			client->plates_left);
+	} else if (rename(tmp, client->plates_path) == -1) {
+		flub = g_flub_toss("Unable to rename plate cache to '%s': "
+			"'%s'", client->plates_path, g_serr(errno));
+	}
+	if (flub) {
+		unlink(tmp);
+	}
+	client->plates_fd = -1;
+	return flub;
+}
+
+uint64_t client_plates_hash(struct client* client) {
+	int fd;
+	struct gls_packet packet;
+
+	// Read the cache's plate set.
+	if (!client->plates_path[0] ||
+		(fd = open(client->plates_path, O_RDONLY)) == -1) {
+		return 0;
+	}
+	if (gls_packet_read(&packet, fd, 1) ||
+		packet.header.event != GLS_EVENT_PLATE_SET) {
+		close(fd);
+		return 0;
+	}
+	close(fd);
+	return packet.data.plate_set.hash;
+}
+
+struct flub* client_plates_load(struct client* client,
+	struct gls_plate_set* set) {
+	int fd;
+	struct flub* flub;
+	uint32_t i;
+	struct gls_packet packet;
+
+	// Check the cache holds the plate set.
+	if ((fd = open(client->plates_path, O_RDONLY)) == -1) {
+		return g_flub_toss("Unable to open plate cache '%s': '%s'",
+			client->plates_path, g_serr(errno));
+	}
+	if ((flub = gls_packet_read(&packet, fd, 1))) {
+		close(fd);
+		return flub_append(flub, "reading plate cache");
+	}
+	if (packet.header.event != GLS_EVENT_PLATE_SET ||
+		packet.data.plate_set.hash != set->hash ||
+		packet.data.plate_set.plates != set->plates) {
+		close(fd);
+		return g_flub_toss("Plate cache '%s' is stale",
+			client->plates_path);
+	}
+
+	// Place the cached plates.
+	for (i = 0; i < set->plates; i++) {
+		if ((flub = gls_packet_read(&packet, fd, 1))) {
+			break;
+		}
+		if (packet.header.event != GLS_EVENT_PLATE_PLACE) {
+			flub = g_flub_toss("Unexpected event '%u' in plate "
+				"cache", packet.header.event);
+			break;
+		}
+		if ((flub = client_plate_place(client,
+			&packet.data.plate_place))) {
+			break;
+		}
+	}
+	close(fd);
+	if (flub) {
+		// Don't offer a broken cache again.
+		unlink(client->plates_path);
+		return flub_append(flub, "loading plate cache");
+	}
+	return NULL;
+}
+
+struct flub* client_plates_open(struct client* client,
+	struct gls_plate_set* set) {
+	struct flub* flub;
+	struct gls_plate_set header;
+	char tmp[PATH_MAX];
+
+	// Write to a temporary file until every plate arrives.
+	if (!client->plates_path[0]) {
+		return NULL;
+	}
+	if (snprintf(tmp, sizeof(tmp), "%s.%d", client->plates_path,
+		(int)getpid()) >= sizeof(tmp)) {
+		return g_flub_toss("Plate cache path too long");
+	}
+	if ((client->plates_fd = open(tmp, O_CREAT | O_TRUNC | O_WRONLY,
+		0644)) == -1) {
+		return g_flub_toss("Unable to create plate cache '%s': '%s'",
+			tmp, g_serr(errno));
+	}
+	header = *set;
+	header.flags = 0;
+	client->plates_left = set->plates;
+	if ((flub = gls_plate_set_write(&header, client->plates_fd))) {
+		close(client->plates_fd);
+		client->plates_fd = -1;
+		unlink(tmp);
+		return flub_append(flub, "writing plate cache");
+	}
+	return NULL;
+}
+
+struct flub* client_plates_path(struct client* client) {
+	char dir[PATH_MAX];
+	char* home;
+	int len;
+
+	// Find the user's cache directory.
+	client->plates_path[0] = '\0';
+	if ((home = getenv("XDG_CACHE_HOME")) && home[0]) {
+		len = snprintf(dir, sizeof(dir), "%s", home);
+	} else if ((home = getenv("HOME")) && home[0]) {
+		len = snprintf(dir, sizeof(dir), "%s/.cache", home);
+	} else {
+		return g_flub_toss("No cache directory");
+	}
+	if (len < 0 || len >= sizeof(dir)) {
+		return g_flub_toss("Cache directory too long");
+	}
+
+	// Create the game's directory within it.
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+		return g_flub_toss("Unable to create '%s': '%s'", dir,
+			g_serr(errno));
+	}
+	if (strlcat(dir, "/gls", sizeof(dir)) >= sizeof(dir)) {
+		return g_flub_toss("Cache directory too long");
+	}
+	if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+		return g_flub_toss("Unable to create '%s': '%s'", dir,
+			g_serr(errno));
+	}
+
+	// Name the cache within it.
+	len = snprintf(client->plates_path, sizeof(client->plates_path),
+		"%s/plates", dir);
+	if (len < 0 || len >= sizeof(client->plates_path)) {
+		client->plates_path[0] = '\0';
+		return g_flub_toss("Plate cache path too long");
+	}
+	return NULL;
+}
+
 int main(int argc, char* argv[]) {
 	struct cargs cargs;
 	struct client client;
 	int done;
 	char errbuf[128];
 	struct flub* flub;
+	// Connect packets still expected for a History packet.
+	uint32_t history_connections;
+	// Die Place packets still expected for a History packet.
+	uint32_t history_dice;
 	struct gls_packet packet;
+	uint32_t protocol;
 	struct sockaddr_in sockaddr_in;
 	int ret;
 
@@ -127,8 +342,28 @@ int main(int argc, char* argv[]) {
 		exit(EXIT_FAILURE);
 	}
 
+	// Set up an empty board until the server sends its size.
+	catalog_init(&client.catalog);
+	flub = board_init(&client.board, &client.catalog, GLS_BOARD_ROW_COUNT,
+		GLS_BOARD_COLUMN_COUNT, GLS_DIE_COUNT);
+	if (flub) {
+		g_log_error("Unable to initialize board: '%s'", flub->message);
+		exit(EXIT_FAILURE);
+	}
+	client.brief = calloc(client.board.rows * client.board.columns, 1);
+	if (!client.brief) {
+		g_log_error("Unable to allocate brief plates");
+		exit(EXIT_FAILURE);
+	}
+
+	// Find the plate cache; without one every sync carries the plates.
+	client.plates_fd = -1;
+	if (!cargs.spectate && (flub = client_plates_path(&client))) {
+		g_log_warn("Not caching plates: '%s'", flub->message);
+	}
+
 	// Set up socket.
-	memset(&client.board, 0, sizeof(struct board));
+	client.subscribed = 0;
 	client.sockfd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 	if (client.sockfd == -1) {
 		perror("Unable to create socket");
@@ -138,7 +373,7 @@ int main(int argc, char* argv[]) {
 	// Connect to the server.
 	memset(&sockaddr_in, 0, sizeof(sockaddr_in));
 	sockaddr_in.sin_family = AF_INET;
-	sockaddr_in.sin_port = htons(13500);
+	sockaddr_in.sin_port = htons(cargs.spectate ? cargs.spectate : 13500);
 	sockaddr_in.sin_addr.s_addr = INADDR_ANY;
 	if (connect(client.sockfd, (struct sockaddr*)&sockaddr_in,
 		sizeof(sockaddr_in)) == -1) {
@@ -147,14 +382,16 @@ int main(int argc, char* argv[]) {
 	}
 
 	// Exchange protocol versions.
+	// Spectators only listen; the server acknowledges them unasked.
 	memset(&packet, 0, sizeof(struct gls_packet));
 	packet.header.event = GLS_EVENT_PROTOVER;
 	strlcpy(packet.data.protover.magic, "GLS", GLS_PROTOVER_MAGIC_LENGTH);
-	strlcpy(packet.data.protover.version, "0.0",
+	strlcpy(packet.data.protover.version, cargs.protocol,
 		GLS_PROTOVER_VERSION_LENGTH);
 	strlcpy(packet.data.protover.software, "gls",
 		GLS_PROTOVER_SOFTWARE_LENGTH);
-	flub = gls_packet_write(&packet, client.sockfd);
+	flub = cargs.spectate ? NULL : gls_packet_write(&packet,
+		client.sockfd);
 	if (flub) {
 		fprintf(stderr, "Unable to write protover: '%s'\n",
 			flub->message);
@@ -175,10 +412,32 @@ int main(int argc, char* argv[]) {
 			packet.data.protoverack.reason);
 		exit(EXIT_FAILURE);
 	}
+	if (!cargs.spectate && ((flub = gls_protocol_parse(
+		packet.data.protoverack.pver.version, &protocol)) ||
+		(flub = gls_protocol_set(client.sockfd, protocol,
+		Z_DEFAULT_COMPRESSION)))) {
+		fprintf(stderr, "Unable to speak server protocol: '%s'\n",
+			flub->message);
+		exit(EXIT_FAILURE);
+	}
+
+	// Ask for a plate set of brief plates, naming the cached plates if
+	// any.
+	memset(&packet, 0, sizeof(struct gls_packet));
+	packet.data.sync_req.plates = client_plates_hash(&client);
+	packet.data.sync_req.flags = GLS_SYNC_REQ_FLAG_BRIEF;
+	if (!cargs.spectate &&
+		(flub = gls_sync_req_write(&packet.data.sync_req,
+		client.sockfd))) {
+		fprintf(stderr, "Unable to write sync req: '%s'\n",
+			flub->message);
+		exit(EXIT_FAILURE);
+	}
 
 	// Set nickname.
-	flub = client_nickname_write(&client, cargs.nick);
-	if (flub) {
+	if (cargs.spectate) {
+		fprintf(stderr, "Spectating.\n");
+	} else if ((flub = client_nickname_write(&client, cargs.nick))) {
 		fprintf(stderr, "Nickname set failed: '%s'\n",
 			flub->message);
 		exit(EXIT_FAILURE);
@@ -188,9 +447,6 @@ int main(int argc, char* argv[]) {
 
 	// Synchronize.
 	do {
-		int i;
-		struct plate* plate;
-
 		// Check header.
 		if ((flub = gls_header_read(&packet.header, client.sockfd))) {
 			g_log_error("Unable to read header: '%s'",
@@ -200,6 +456,67 @@ int main(int argc, char* argv[]) {
 		if (packet.header.event == GLS_EVENT_SYNC_END) {
 			// End of sync.
 			break;
+		} else if (packet.header.event == GLS_EVENT_FRAME) {
+			// The frame's packets follow on their own.
+			if ((flub = gls_frame_read(&packet.data.frame,
+				client.sockfd, 1))) {
+				g_log_error("Unable to read frame: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
+		} else if (packet.header.event == GLS_EVENT_BOARD_SIZE) {
+			// Read in board size.
+			if ((flub = gls_board_size_read(
+				&packet.data.board_size, client.sockfd, 1))) {
+				g_log_error("Unable to read board size: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
+
+			// Resize the game board.
+			board_free(&client.board);
+			if ((flub = board_init(&client.board, &client.catalog,
+				packet.data.board_size.rows,
+				packet.data.board_size.columns,
+				packet.data.board_size.dice))) {
+				g_log_error("Unable to size board: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
+			free(client.brief);
+			client.brief = calloc(client.board.rows *
+				client.board.columns, 1);
+			if (!client.brief) {
+				g_log_error("Unable to allocate brief plates");
+				exit(EXIT_FAILURE);
+			}
+		} else if (packet.header.event == GLS_EVENT_PLATE_SET) {
+			// Read in plate set.
+			if ((flub = gls_plate_set_read(&packet.data.plate_set,
+				client.sockfd, 1))) {
+				g_log_error("Unable to read plate set: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
+
+			// Load the cached plates or cache the plates to come.
+			if (packet.data.plate_set.flags &
+				GLS_PLATE_SET_FLAG_CACHED) {
+				flub = client_plates_load(&client,
+					&packet.data.plate_set);
+			} else {
+				flub = client_plates_open(&client,
+					&packet.data.plate_set);
+			}
+			if (flub && (packet.data.plate_set.flags &
+				GLS_PLATE_SET_FLAG_CACHED)) {
+				g_log_error("Unable to load plates: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			} else if (flub) {
+				g_log_warn("Not caching plates: '%s'",
+					flub->message);
+			}
 		} else if (packet.header.event == GLS_EVENT_PLATE_PLACE) {
 			// Read in plate.
 			if ((flub = gls_plate_place_read(
@@ -208,20 +525,12 @@ int main(int argc, char* argv[]) {
 					flub->message);
 				exit(EXIT_FAILURE);
 			}
-
-			// Copy plate to game board.
-			i = ((packet.data.plate_place.loc[0] - 'A') * 8) +
-				((packet.data.plate_place.loc[1] - '1'));
-			plate = ((struct plate*)client.board.plates) + i;
-			strlcpy(plate->abbrev, packet.data.plate_place.abbrev,
-				GLS_PLATE_ABBREV_LENGTH);
-			strlcpy(plate->description,
-				packet.data.plate_place.description,
-				GLS_PLATE_DESCRIPTION_LENGTH);
-			strlcpy(plate->name, packet.data.plate_place.name,
-				GLS_PLATE_NAME_LENGTH);
-			plate->empty = packet.data.plate_place.flags &
-				GLS_PLATE_FLAG_EMPTY;
+			if ((flub = client_plate_place(&client,
+				&packet.data.plate_place))) {
+				g_log_error("Unable to place plate: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
 		} else if (packet.header.event == GLS_EVENT_DIE_PLACE) {
 			// Read in die placement.
 			if ((flub = gls_die_place_read(&packet.data.die_place,
@@ -241,6 +550,24 @@ int main(int argc, char* argv[]) {
 					flub->message);
 				exit(EXIT_FAILURE);
 			}
+		} else if (packet.header.event == GLS_EVENT_CONNECT) {
+			// Read in connection.
+			if ((flub = gls_connect_read(&packet.data.connect,
+				client.sockfd, 1))) {
+				g_log_error("Unable to read connect: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
+
+			// Connect dice.
+			if ((flub = board_connect(&client.board,
+				packet.data.connect.nick,
+				packet.data.connect.from,
+				packet.data.connect.to))) {
+				g_log_error("Unable to connect dice: '%s'",
+					flub->message);
+				exit(EXIT_FAILURE);
+			}
 		} else {
 			g_log_error("Unexpected event: '%u'",
 				packet.header.event);
@@ -253,20 +580,29 @@ int main(int argc, char* argv[]) {
 		flub->message);
 		exit(EXIT_FAILURE);
 	}
+	if ((flub = client_plates_close(&client))) {
+		g_log_warn("Not caching plates: '%s'", flub->message);
+	}
 	if (strlen(packet.data.sync_end.motd)) {
 		g_log_info("MotD: '%s'", packet.data.sync_end.motd);
 	}
 
 	// Play the game (main loop).
 	done = 0;
+	history_connections = 0;
+	history_dice = 0;
 	const int REGMATCH_COUNT = 5;
 	regex_t regex_board;
 	regex_t regex_command;
+	regex_t regex_connect;
 	regex_t regex_help;
+	regex_t regex_history;
 	regex_t regex_nick;
 	regex_t regex_place;
 	regex_t regex_plate;
 	regex_t regex_quit;
+	regex_t regex_score;
+	regex_t regex_subscribe;
 	regmatch_t regmatch[REGMATCH_COUNT];
 	if ((ret = regcomp(&regex_board, "^board\\s*$",
 		REG_EXTENDED | REG_NOSUB))) {
@@ -278,11 +614,21 @@ int main(int argc, char* argv[]) {
 		regerror(ret, &regex_command, errbuf, sizeof(errbuf));
 		g_log_error("Unable to compile command regex: '%s'", errbuf);
 		exit(EXIT_FAILURE);
+	} else if ((ret = regcomp(&regex_connect,
+		"^connect(\\s+(\\w+)(\\s+(\\w+))?)?\\s*$", REG_EXTENDED))) {
+		regerror(ret, &regex_connect, errbuf, sizeof(errbuf));
+		g_log_error("Unable to compile connect regex: '%s'", errbuf);
+		exit(EXIT_FAILURE);
 	} else if ((ret = regcomp(&regex_help, "^(help|\\?)\\s*$",
 		REG_EXTENDED | REG_NOSUB))) {
 		regerror(ret, &regex_help, errbuf, sizeof(errbuf));
 		g_log_error("Unable to compile help regex: '%s'", errbuf);
 		exit(EXIT_FAILURE);
+	} else if ((ret = regcomp(&regex_history,
+		"^history(\\s+([0-9]+))?\\s*$", REG_EXTENDED))) {
+		regerror(ret, &regex_history, errbuf, sizeof(errbuf));
+		g_log_error("Unable to compile history regex: '%s'", errbuf);
+		exit(EXIT_FAILURE);
 	} else if ((ret = regcomp(&regex_nick, "^nick(\\s+(\\w+))?\\s*$",
 		REG_EXTENDED))) {
 		regerror(ret, &regex_nick, errbuf, sizeof(errbuf));
@@ -303,6 +649,17 @@ int main(int argc, char* argv[]) {
 		regerror(ret, &regex_quit, errbuf, sizeof(errbuf));
 		g_log_error("Unable to compile quit regex: '%s'", errbuf);
 		exit(EXIT_FAILURE);
+	} else if ((ret = regcomp(&regex_score, "^score\\s*$",
+		REG_EXTENDED | REG_NOSUB))) {
+		regerror(ret, &regex_score, errbuf, sizeof(errbuf));
+		g_log_error("Unable to compile score regex: '%s'", errbuf);
+		exit(EXIT_FAILURE);
+	} else if ((ret = regcomp(&regex_subscribe,
+		"^subscribe(\\s+(\\w+)\\s+(\\w+)(\\s+add)?)?\\s*$",
+		REG_EXTENDED))) {
+		regerror(ret, &regex_subscribe, errbuf, sizeof(errbuf));
+		g_log_error("Unable to compile subscribe regex: '%s'", errbuf);
+		exit(EXIT_FAILURE);
 	}
 	while (!done) {
 		int read_count;
@@ -313,12 +670,16 @@ int main(int argc, char* argv[]) {
 
 		// Read data from server.
 		do {
+			struct plate plate;
 			time_t tval;
 			struct tm tm;
 			char tstr[10];
 
-			// Check for data from server.
-			if (ioctl(client.sockfd, FIONREAD, &ret) == -1) {
+			// Check for data from server, including data already
+			// inflated.
+			if (gls_pending(client.sockfd)) {
+				ret = 1;
+			} else if (ioctl(client.sockfd, FIONREAD, &ret) == -1) {
 				g_log_error("Unable to peek socket read end: "
 					"'%s'", g_serr(errno));
 				done = 1;
@@ -338,12 +699,38 @@ int main(int argc, char* argv[]) {
 				break;
 			}
 			switch (packet.header.event) {
+			case (GLS_EVENT_FRAME):
+				// The frame's packets follow on their own.
+				break;
 			case (GLS_EVENT_DIE_PLACE):
-				if ((flub = board_die_place(&client.board,
-					packet.data.die_place.nick,
-					packet.data.die_place.location,
-					&packet.data.die_place.color,
-					&packet.data.die_place.die))) {
+				if (history_dice) {
+					// Die of a requested history version.
+					history_dice--;
+					g_log_info("  Die '%u' (%s) at '%s' by "
+						"'%s'",
+						packet.data.die_place.die,
+						gls_color_names[
+						packet.data.die_place.color],
+						packet.data.die_place.location,
+						packet.data.die_place.nick);
+					break;
+				}
+				if (client.subscribed) {
+					// Dice outside the subscription are
+					// skipped and sent again later.
+					flub = board_die_set(&client.board,
+						packet.data.die_place.nick,
+						packet.data.die_place.location,
+						packet.data.die_place.color,
+						packet.data.die_place.die);
+				} else {
+					flub = board_die_place(&client.board,
+						packet.data.die_place.nick,
+						packet.data.die_place.location,
+						&packet.data.die_place.color,
+						&packet.data.die_place.die);
+				}
+				if (flub) {
 					g_log_error("Unable to place die '%s':"
 						"%s",
 						packet.data.die_place.location,
@@ -358,6 +745,55 @@ int main(int argc, char* argv[]) {
 						packet.data.die_place.color],
 					packet.data.die_place.location);
 				break;
+			case (GLS_EVENT_CONNECT):
+				if (history_connections) {
+					// Connection of a requested history
+					// version.
+					history_connections--;
+					g_log_info("  Dice '%u' and '%u' "
+						"connected by '%s'",
+						packet.data.connect.from,
+						packet.data.connect.to,
+						packet.data.connect.nick);
+					break;
+				}
+				if ((flub = board_connect(&client.board,
+					packet.data.connect.nick,
+					packet.data.connect.from,
+					packet.data.connect.to)) &&
+					client.subscribed) {
+					// Die outside the subscription.
+					g_log_info("'%s' connected dice '%u' "
+						"and '%u'",
+						packet.data.connect.nick,
+						packet.data.connect.from,
+						packet.data.connect.to);
+					break;
+				} else if (flub) {
+					g_log_error("Unable to connect dice "
+						"'%u' and '%u': %s",
+						packet.data.connect.from,
+						packet.data.connect.to,
+						flub->message);
+					done = 1;
+					break;
+				}
+				g_log_info("'%s' connected dice '%u' (%s) and "
+					"'%u' (%s)", packet.data.connect.nick,
+					packet.data.connect.from,
+					client.board.dice[
+					packet.data.connect.from].location,
+					packet.data.connect.to,
+					client.board.dice[
+					packet.data.connect.to].location);
+				break;
+			case (GLS_EVENT_CONNECT_REJECT):
+				g_log_info("Server rejected connection of dice "
+					"'%u' and '%u': %s",
+					packet.data.connect_reject.from,
+					packet.data.connect_reject.to,
+					packet.data.connect_reject.reason);
+				break;
 			case (GLS_EVENT_DIE_PLACE_REJECT):
 				g_log_info("Server rejected placement of die "
 					"at '%s': %s",
@@ -380,6 +816,48 @@ int main(int argc, char* argv[]) {
 					packet.data.nick_change.old,
 					packet.data.nick_change.new);
 				break;
+			case (GLS_EVENT_HISTORY):
+				if (!packet.data.history.dice &&
+					packet.data.history.version >=
+					packet.data.history.versions) {
+					g_log_info("No version '%u'; history "
+						"has '%u' versions",
+						packet.data.history.version,
+						packet.data.history.versions);
+					break;
+				}
+				g_log_info("Version '%u' of '%u': '%u' dice, "
+					"'%u' connections",
+					packet.data.history.version,
+					packet.data.history.versions - 1,
+					packet.data.history.dice,
+					packet.data.history.connections);
+				history_dice = packet.data.history.dice;
+				history_connections =
+					packet.data.history.connections;
+				break;
+			case (GLS_EVENT_PLATE_DETAIL):
+				// Keep the details and print the plate.
+				if ((flub = client_plate_place(&client,
+					&packet.data.plate_detail.plate))) {
+					g_log_error("Unable to keep plate "
+						"detail: %s", flub->message);
+					done = 1;
+					break;
+				}
+				if (packet.data.plate_detail.plate.flags &
+					GLS_PLATE_FLAG_EMPTY) {
+					plate_print(NULL, STDOUT_FILENO);
+					break;
+				}
+				plate.name =
+					packet.data.plate_detail.plate.name;
+				plate.abbrev =
+					packet.data.plate_detail.plate.abbrev;
+				plate.description = packet.data.plate_detail
+					.plate.description;
+				plate_print(&plate, STDOUT_FILENO);
+				break;
 			case (GLS_EVENT_PLAYER_JOIN):
 				g_log_info("Player '%s' has joined",
 					packet.data.player_join.nick);
@@ -388,6 +866,20 @@ int main(int argc, char* argv[]) {
 				g_log_info("Player '%s' has parted",
 					packet.data.player_part.nick);
 				break;
+			case (GLS_EVENT_SCORE):
+				if (packet.data.score.color == GLS_COLOR_NULL) {
+					g_log_info("'%s' has '%u' points",
+						packet.data.score.nick,
+						packet.data.score.points);
+					break;
+				}
+				g_log_info("'%s' has '%u' points; %s has '%u' "
+					"points", packet.data.score.nick,
+					packet.data.score.points,
+					gls_color_names[
+					packet.data.score.color],
+					packet.data.score.color_points);
+				break;
 			case (GLS_EVENT_SHUTDOWN):
 				g_log_info("Server shutdown: '%s'",
 					packet.data.shutdown.reason);
@@ -416,6 +908,13 @@ int main(int argc, char* argv[]) {
 					packet.data.say2.message);
 				break;
 			default:
+				if (gls_event_length(packet.header.event) ==
+					GLS_LENGTH_UNKNOWN) {
+					// Skipped by a newer server.
+					g_log_warn("Skipped unknown event: "
+						"'%u'", packet.header.event);
+					break;
+				}
 				g_log_error("Unknown event: '%i'",
 					packet.header.event);
 				done = 1;
@@ -465,6 +964,12 @@ int main(int argc, char* argv[]) {
 			regmatch, 0)) {
 			struct gls_say1 say;
 
+			// Spectators cannot talk.
+			if (cargs.spectate) {
+				g_log_warn("Spectators cannot send messages");
+				continue;
+			}
+
 			// Prepare Say1 packet.
 			memset(&say, 0, sizeof(struct gls_say1));
 			if (strlcpy(say.message, command,
@@ -486,24 +991,116 @@ int main(int argc, char* argv[]) {
 			continue;
 		}
 		cmd = &command[regmatch[1].rm_so];
-		if (!regexec(&regex_board, cmd, REGMATCH_COUNT, regmatch, 0)) {
+		if (cargs.spectate && (!regexec(&regex_connect, cmd, 0, NULL,
+			0) || !regexec(&regex_history, cmd, 0, NULL, 0) ||
+			!regexec(&regex_nick, cmd, 0, NULL, 0) ||
+			!regexec(&regex_place, cmd, 0, NULL, 0) ||
+			!regexec(&regex_subscribe, cmd, 0, NULL, 0))) {
+			// Spectators only watch.
+			g_log_warn("Spectators cannot play");
+		} else if (!regexec(&regex_board, cmd, REGMATCH_COUNT,
+			regmatch, 0)) {
 			// Print game board.
 			board_print(&client.board, STDOUT_FILENO);
+		} else if (!regexec(&regex_connect, cmd, REGMATCH_COUNT,
+			regmatch, 0)) {
+			// Connect dice.
+			uint32_t column;
+			struct die* dice[2];
+			int i;
+			regoff_t len;
+			char location[GLS_LOCATION_LENGTH];
+			struct gls_connect_try packet;
+			uint32_t row;
+
+			// Find the die at each location.
+			if (regmatch[2].rm_so == -1 ||
+				regmatch[4].rm_so == -1) {
+				g_log_warn("Missing location");
+				continue;
+			}
+			for (i = 0; i < 2; i++) {
+				len = regmatch[i * 2 + 2].rm_eo -
+					regmatch[i * 2 + 2].rm_so + 1;
+				strlcpy(location,
+					&cmd[regmatch[i * 2 + 2].rm_so],
+					len < GLS_LOCATION_LENGTH ? len :
+					GLS_LOCATION_LENGTH);
+				if ((flub = board_location_parse(&client.board,
+					location, &row, &column))) {
+					g_log_warn("Invalid location: %s",
+						flub->message);
+					break;
+				}
+				if (!(dice[i] = board_die_get(&client.board,
+					row, column))) {
+					g_log_warn("No die at '%s'", location);
+					break;
+				}
+			}
+			if (i < 2) {
+				continue;
+			}
+
+			// Check board.
+			memset(&packet, 0, sizeof(packet));
+			packet.from = dice[0] - client.board.dice;
+			packet.to = dice[1] - client.board.dice;
+			if ((flub = board_connect_check(&client.board,
+				packet.from, packet.to))) {
+				g_log_warn("Unable to connect dice: %s",
+					flub->message);
+				continue;
+			}
+
+			// Send packet.
+			if ((flub = gls_connect_try_write(&packet,
+				client.sockfd))) {
+				g_log_warn("Unable to write connect try "
+					"packet: %s", flub->message);
+			}
 		} else if (!regexec(&regex_help, cmd, 0, NULL, 0)) {
 			// Print help message.
 			char* message =
 				"/board: Print the game board.\n"
+				"/connect <Location> <Location>: Connect the "
+					"dice at the specified locations.\n"
 				"/help: Show this help menu.\n"
+				"/history [version]: Show dice placed as of "
+					"the specified (or latest) version.\n"
 				"/nick <nick>: Request specified nickname.\n"
 				"/plate <RowColumn>: Print specifed plate.\n"
 				"/place <Location> [color]: Place die at "
 					"specified location.\n"
 				"/quit: Exit the program.\n"
+				"/score: Show each player's and color's "
+					"score.\n"
+				"/subscribe [<Location> <Location> [add]]: "
+					"Receive die placements only between "
+					"the locations, or on the whole "
+					"board.\n"
 				"/?: Same as 'help'.\n";
 			if (write(STDOUT_FILENO, message, strlen(message)) <
 				strlen(message)) {
 				g_log_error("Writing help message");
 			}
+		} else if (!regexec(&regex_history, cmd, REGMATCH_COUNT,
+			regmatch, 0)) {
+			// Request history version.
+			struct gls_history_req req;
+
+			memset(&req, 0, sizeof(struct gls_history_req));
+			if (regmatch[2].rm_so == -1) {
+				req.version = GLS_HISTORY_LATEST;
+			} else {
+				req.version = strtoul(&cmd[regmatch[2].rm_so],
+					NULL, 10);
+			}
+			if ((flub = gls_history_req_write(&req,
+				client.sockfd))) {
+				g_log_warn("Unable to request history: %s",
+					flub->message);
+			}
 		} else if (!regexec(&regex_nick, cmd, REGMATCH_COUNT, regmatch,
 			0)) {
 			// Send Nick Request.
@@ -542,6 +1139,7 @@ int main(int argc, char* argv[]) {
 			uint32_t color;
 			char color_str[16]; // Hacky.
 			uint32_t die;
+			regoff_t len;
 			struct gls_die_place_try packet;
 			char location[GLS_LOCATION_LENGTH];
 
@@ -550,7 +1148,9 @@ int main(int argc, char* argv[]) {
 				g_log_warn("Missing location");
 				continue;
 			}
+			len = regmatch[2].rm_eo - regmatch[2].rm_so + 1;
 			strlcpy(location, &cmd[regmatch[2].rm_so],
+				len < GLS_LOCATION_LENGTH ? len :
 				GLS_LOCATION_LENGTH);
 			if ((flub = gls_location_validate(location))) {
 				g_log_warn("Unable to parse location: %s",
@@ -560,8 +1160,7 @@ int main(int argc, char* argv[]) {
 
 			// Parse color.
 			if (regmatch[4].rm_so != -1) {
-				regoff_t len = regmatch[4].rm_eo -
-					regmatch[4].rm_so;
+				len = regmatch[4].rm_eo - regmatch[4].rm_so;
 				strlcpy(color_str, &cmd[regmatch[4].rm_so],
 					sizeof(color_str) < len + 1?
 					sizeof(color_str) : len + 1);
@@ -606,9 +1205,12 @@ int main(int argc, char* argv[]) {
 		} else if (!regexec(&regex_plate, cmd, REGMATCH_COUNT, regmatch,
 			0)) {
 			// Print specified plate.
-			int column;
-			int offset;
-			int row;
+			uint32_t column;
+			uint32_t id;
+			regoff_t len;
+			struct plate plate;
+			char location[GLS_LOCATION_LENGTH];
+			uint32_t row;
 
 			// Check for plate specification.
 			if (regmatch[2].rm_so == -1) {
@@ -617,47 +1219,109 @@ int main(int argc, char* argv[]) {
 			}
 
 			// Parse board coordinates.
-			// TODO: Deal with lowercase, multiple letters/numbers,
-			// make less sucky in general.
-			offset = regmatch[2].rm_so;
-			if (!isalpha(cmd[offset])) {
-				g_log_info("Invalid row '%c'", cmd[offset]);
-				continue;
-			}
-			row = cmd[offset] - 'A';
-			if (row < 0) {
-				g_log_info("Row '%c' too low", cmd[offset]);
-				continue;
-			} else if (row >= GLS_BOARD_ROW_COUNT) {
-				g_log_info("Row '%c' too high (must be less "
-					"than '%c')", cmd[offset],
-					GLS_BOARD_ROW_COUNT + 'A');
-				continue;
-			}
-			offset++;
-			if (!isdigit(cmd[offset])) {
-				g_log_info("Invalid column '%c'; expected "
-					"digit", cmd[offset]);
+			// TODO: Deal with lowercase.
+			len = regmatch[2].rm_eo - regmatch[2].rm_so + 1;
+			strlcpy(location, &cmd[regmatch[2].rm_so],
+				len < GLS_LOCATION_LENGTH ? len :
+				GLS_LOCATION_LENGTH);
+			if ((flub = board_location_parse(&client.board,
+				location, &row, &column))) {
+				g_log_info("Invalid plate location: %s",
+					flub->message);
 				continue;
 			}
-			column = cmd[offset] - '1';
-			if (column < 0) {
-				g_log_info("Column '%c' too low", cmd[offset]);
-				continue;
-			} else if (column >= GLS_BOARD_COLUMN_COUNT) {
-				g_log_info("Column '%c' too high (must be "
-				"less than '%c')", cmd[offset],
-				GLS_BOARD_COLUMN_COUNT + '1');
+
+			// Fetch details of a brief plate before printing it.
+			if (client.brief[row * client.board.columns + column]) {
+				struct gls_plate_detail_req req;
+
+				memset(&req, 0, sizeof(req));
+				strlcpy(req.loc, location, GLS_LOCATION_LENGTH);
+				if ((flub = gls_plate_detail_req_write(&req,
+					client.sockfd))) {
+					g_log_warn("Unable to write plate "
+						"detail req: %s",
+						flub->message);
+				}
 				continue;
 			}
 
 			// Print plate.
-			plate_print(&client.board.plates[row][column],
-				STDOUT_FILENO);
+			id = board_plate_get(&client.board, row, column);
+			if (id == CATALOG_PLATE_NONE) {
+				plate_print(NULL, STDOUT_FILENO);
+				continue;
+			}
+			catalog_plate(&client.catalog, id, &plate);
+			plate_print(&plate, STDOUT_FILENO);
 		} else if (!regexec(&regex_quit, cmd, REGMATCH_COUNT, regmatch,
 			0)) {
 			// Quit the game.
 			done = 1;
+		} else if (!regexec(&regex_score, cmd, 0, NULL, 0)) {
+			// Print scores.
+			struct score* score;
+			uint32_t i;
+
+			score = &client.board.score;
+			for (i = 0; i < score->player_size; i++) {
+				if (!score->players[i].nick[0]) {
+					continue;
+				}
+				g_log_info("'%s': '%u' points",
+					score->players[i].nick,
+					score->players[i].points);
+			}
+			for (i = GLS_COLOR_MIN; i <= GLS_COLOR_MAX; i++) {
+				g_log_info("%s: '%u' points",
+					gls_color_names[i], score->colors[i]);
+			}
+		} else if (!regexec(&regex_subscribe, cmd, REGMATCH_COUNT,
+			regmatch, 0)) {
+			// Subscribe to part of the board.
+			uint32_t column;
+			int i;
+			regoff_t len;
+			char* locations[2];
+			uint32_t row;
+			struct gls_subscribe subscribe;
+
+			// Parse region.
+			flub = NULL;
+			memset(&subscribe, 0, sizeof(subscribe));
+			locations[0] = subscribe.from;
+			locations[1] = subscribe.to;
+			if (regmatch[1].rm_so == -1) {
+				subscribe.flags = GLS_SUBSCRIBE_FLAG_ALL;
+			} else if (regmatch[4].rm_so != -1) {
+				subscribe.flags = GLS_SUBSCRIBE_FLAG_ADD;
+			}
+			for (i = 0; i < 2 && regmatch[1].rm_so != -1; i++) {
+				len = regmatch[i + 2].rm_eo -
+					regmatch[i + 2].rm_so + 1;
+				strlcpy(locations[i],
+					&cmd[regmatch[i + 2].rm_so],
+					len < GLS_LOCATION_LENGTH ? len :
+					GLS_LOCATION_LENGTH);
+				if ((flub = board_location_parse(&client.board,
+					locations[i], &row, &column))) {
+					g_log_warn("Invalid location: %s",
+						flub->message);
+					break;
+				}
+			}
+			if (flub) {
+				continue;
+			}
+
+			// Send packet.
+			if ((flub = gls_subscribe_write(&subscribe,
+				client.sockfd))) {
+				g_log_warn("Unable to subscribe: %s",
+					flub->message);
+				continue;
+			}
+			client.subscribed = 1;
 		} else {
 			// Unknown command.
 			g_log_info("Command not recognized");
@@ -669,6 +1333,10 @@ int main(int argc, char* argv[]) {
 		log_error(&g_log, "Closing connection to server.");
 	}
 
+	// Free the board.
+	board_free(&client.board);
+	catalog_free(&client.catalog);
+
 	// Close the logger.
 	log_free(&g_log);
 
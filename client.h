@@ -25,12 +25,15 @@
 #include "include.h"
 
 #include <bsd/string.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <regex.h>
 #include <stdint.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
@@ -44,9 +47,55 @@
 
 struct client {
 	struct board board;
+	struct catalog catalog;
 	int sockfd;
+	// Nonzero for each cell whose plate was sent without its details.
+	uint8_t* brief;
+	// Plate cache, or an empty path if plates aren't cached.
+	char plates_path[PATH_MAX];
+	// Plate cache being written during synchronization, or -1.
+	int plates_fd;
+	// Plates still expected for the plate cache being written.
+	uint32_t plates_left;
+	// Subscription changed, so dice may be skipped or sent again.
+	unsigned subscribed:1;
 };
 
 struct flub* client_nickname_write(struct client* client, char* nickname);
 
+/**
+ * Places the specified plate on the client's board.
+ */
+struct flub* client_plate_place(struct client* client,
+	struct gls_plate_place* place);
+
+/**
+ * Finishes the plate cache being written, keeping it only if every plate of
+ * its plate set arrived.
+ */
+struct flub* client_plates_close(struct client* client);
+
+/**
+ * Returns the hash of the cached plates, or zero if none are cached.
+ */
+uint64_t client_plates_hash(struct client* client);
+
+/**
+ * Places the cached plates of the specified plate set on the client's board.
+ */
+struct flub* client_plates_load(struct client* client,
+	struct gls_plate_set* set);
+
+/**
+ * Starts writing the plates of the specified plate set to the plate cache.
+ */
+struct flub* client_plates_open(struct client* client,
+	struct gls_plate_set* set);
+
+/**
+ * Sets the path of the plate cache under the user's cache directory,
+ * creating the directory if needed.
+ */
+struct flub* client_plates_path(struct client* client);
+
 #endif // client_H
@@ -94,6 +94,67 @@ struct flub* g_flub_toss(char* format, ...) {
 	return (flub);
 }
 
+// Lookup table for 'g_crc32', built on first use.
+static uint32_t g_crc32_table[256];
+static pthread_once_t g_crc32_once = PTHREAD_ONCE_INIT;
+
+static void g_crc32_init() {
+	uint32_t c;
+	int i;
+	int j;
+
+	// Build table for the reflected polynomial.
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++) {
+			c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+		g_crc32_table[i] = c;
+	}
+}
+
+uint32_t g_crc32(uint32_t crc, const void* data, size_t size) {
+	const unsigned char* bytes;
+	size_t i;
+
+	// Update CRC with each byte.
+	pthread_once(&g_crc32_once, g_crc32_init);
+	bytes = data;
+	crc = ~crc;
+	for (i = 0; i < size; i++) {
+		crc = g_crc32_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+uint32_t g_hash(const void* data, size_t size) {
+	const unsigned char* bytes;
+	uint32_t hash;
+	size_t i;
+
+	// Hash each byte.
+	bytes = data;
+	hash = 2166136261u;
+	for (i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+uint64_t g_hash64(uint64_t hash, const void* data, size_t size) {
+	const unsigned char* bytes;
+	size_t i;
+
+	// Hash each byte.
+	bytes = data;
+	for (i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
 char* g_serr(int err) {
 	char* buf;
 
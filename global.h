@@ -24,13 +24,16 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #include "flub.h"
 #include "log.h"
 
-// Size for server to player-thread pipe; acts as effective send queue
-// maximum.
+// Size for server to player-thread game and presence lanes.
 #define G_PLAYER_PIPE_WRITE_SIZE 65536
+// Size for server to player-thread chat lane; chat beyond it is dropped.
+#define G_PLAYER_CHAT_PIPE_SIZE 16384
 // Size for system error (serr) buffer.
 #define G_SERR_SIZE 256
 
@@ -78,6 +81,24 @@ int g_flub_init();
 struct flub* g_flub_toss(char* format, ...)
 	__attribute__((format(printf, 1, 2)));
 
+/**
+ * Returns the CRC-32 (IEEE 802.3) of the specified bytes, continuing from the
+ * specified previous CRC (zero to start).
+ */
+uint32_t g_crc32(uint32_t crc, const void* data, size_t size);
+
+/**
+ * Returns the 32-bit FNV-1a hash of the specified bytes.
+ */
+uint32_t g_hash(const void* data, size_t size);
+
+/**
+ * Returns the 64-bit FNV-1a hash of the specified bytes, continuing from the
+ * specified previous hash ('G_HASH64_SEED' to start).
+ */
+#define G_HASH64_SEED 14695981039346656037ULL
+uint64_t g_hash64(uint64_t hash, const void* data, size_t size);
+
 /**
  * Thread-safe version of 'strerror_r' with less cruft.
  */
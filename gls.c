@@ -3,11 +3,61 @@
 // Key for thread-specific buffer.
 pthread_key_t gls_key;
 
+// Key for thread-specific descriptor state.
+pthread_key_t gls_descriptor_key;
+
+// Deflate streams of a compressed file descriptor.
+struct gls_compress {
+	z_stream deflate;
+	z_stream inflate;
+	// Compressed record being written or read.
+	unsigned char* record;
+	size_t record_size;
+	// Inflated bytes not yet read.
+	unsigned char* plain;
+	size_t plain_size;
+	size_t plain_start;
+	size_t plain_end;
+	// Counters of each direction.
+	struct gls_compress_stats sent;
+	struct gls_compress_stats received;
+};
+
+// State kept by a single thread for a single file descriptor.
+struct gls_descriptor {
+	// Packets held back.
+	struct gls_batch batch;
+	// Stream compression, or NULL.
+	struct gls_compress* compress;
+	// Protocol spoken.
+	uint32_t protocol;
+	// Body length given by the last compact header read.
+	uint32_t length;
+};
+
+// Descriptor state of a single thread, indexed by file descriptor.
+struct gls_descriptors {
+	struct gls_descriptor* descriptors;
+	int size;
+};
+
 // Statically-allocated color names.
 const char* gls_color_names[] = {
 	"null", "red", "orange", "yellow", "green", "blue", "purple"
 };
 
+// Protover versions of each protocol.
+const char* gls_protocol_versions[] = {
+	"0.1", "1.0", "1.1"
+};
+
+// Room left ahead of a compact packet's body for its header.
+#define GLS_COMPACT_HEADER_LENGTH (2 * GLS_VARINT_LENGTH_MAX)
+
+// Character classes of 'gls_span'.
+#define GLS_SPAN_PRINT 0
+#define GLS_SPAN_ALNUM 1
+
 // Static functions.
 ssize_t gls_rdwrn(int fd, void* buffer, size_t count,
 	ssize_t(*rdwr)(int fd, void* buffer, size_t count)) {
@@ -17,7 +67,7 @@ ssize_t gls_rdwrn(int fd, void* buffer, size_t count,
 
 	// Read in 'n' bytes.
 	buf = (char*)buffer;
-	for (i = 0; i < count; ) {
+	for (i = 0; count; ) {
 		ret = rdwr(fd, buf, count);
 		if (ret == -1) {
 			// Read error.
@@ -59,1311 +109,1805 @@ static ssize_t gls_rdwrvn(int fd, struct iovec* iov, int iovcnt,
 			iovcnt--;
 		}
 		if (ret) {
+			iov[0].iov_base = (char*)iov[0].iov_base + ret;
 			iov[0].iov_len -= ret;
 		}
 	} while (iovcnt);
 	return cnt;
 }
 
-// Library functions.
-struct flub* gls_die_place_read(struct gls_die_place* die, int fd,
-	int validate) {
-	struct flub* flub;
-	struct iovec iovs[4];
-	ssize_t len;
+static ssize_t gls_batch_append(struct gls_batch* batch, int fd,
+	void* buffer, size_t count) {
+	char* data;
+	size_t size;
 
-	// Read packet.
-	memset(die, 0, sizeof(struct gls_die_place));
-	len = 0;
-	iovs[0].iov_base = die->location;
-	len += iovs[0].iov_len = GLS_LOCATION_LENGTH;
-	iovs[1].iov_base = &die->color;
-	len += iovs[1].iov_len = sizeof(uint32_t);
-	iovs[2].iov_base = die->nick;
-	len += iovs[2].iov_len = GLS_NICK_LENGTH;
-	iovs[3].iov_base = &die->die;
-	len += iovs[3].iov_len = sizeof(uint32_t);
-	if (gls_readvn(fd, iovs, sizeof(iovs) / sizeof(struct iovec)) < len) {
-		g_flub_toss("Unable to read die place packet: %s",
-			g_serr(errno));
+	// Flush batch that would grow past the largest frame.
+	if (batch->length + count > GLS_FRAME_LENGTH_MAX &&
+		gls_batch_flush(fd)) {
+		return -1;
 	}
-	die->color = be32toh(die->color);
-	die->die = be32toh(die->die);
 
-	// Validate packet.
-	if (!validate) {
-		return NULL;
-	} else if ((flub = gls_location_validate(die->location))) {
-		return flub_append(flub, "reading die place");
-	} else if (die->color > GLS_COLOR_MAX || die->color == GLS_COLOR_NULL) {
-		return g_flub_toss("Invalid die color '%u'", die->color);
-	} else if ((flub = gls_nick_validate(die->nick, 0))) {
-		return flub_append(flub, "reading die place");
-	} else if (die->die > GLS_DIE_MAX) {
-		return g_flub_toss("Invalid die number '%u'", die->die);
+	// Grow buffer.
+	if (batch->length + count > batch->size) {
+		size = batch->size ? batch->size : GLS_BUFFER_SIZE / 16;
+		while (size < batch->length + count) {
+			size *= 2;
+		}
+		if (!(data = realloc(batch->data, size))) {
+			errno = ENOMEM;
+			return -1;
+		}
+		batch->data = data;
+		batch->size = size;
 	}
-	return NULL;
+
+	// Hold packet.
+	memcpy(batch->data + batch->length, buffer, count);
+	batch->length += count;
+	batch->count++;
+	return count;
 }
 
-struct flub* gls_die_place_write(struct gls_die_place* die, int fd) {
-	char* buf;
-	char* cur;
-	ssize_t len;
-	uint32_t tmp32;
+static struct gls_descriptor* gls_descriptor_find(int fd) {
+	struct gls_descriptors* descriptors;
 
-	// Prepare buffer.
-	if (!(cur = buf = pthread_getspecific(gls_key))) {
-		return g_flub_toss("Unable to get gls buffer");
-	}
-	len = 0;
-	gls_header_marshal(cur, GLS_EVENT_DIE_PLACE);
-	cur += 4;
-	len += 4;
-	strlcpy(cur, die->location, GLS_LOCATION_LENGTH);
-	cur += GLS_LOCATION_LENGTH;
-	len += GLS_LOCATION_LENGTH;
-	tmp32 = htobe32(die->color);
-	memcpy(cur, &tmp32, sizeof(uint32_t));
-	cur += sizeof(uint32_t);
-	len += sizeof(uint32_t);
-	strlcpy(cur, die->nick, GLS_NICK_LENGTH);
-	cur += GLS_NICK_LENGTH;
-	len += GLS_NICK_LENGTH;
-	tmp32 = htobe32(die->die);
-	memcpy(cur, &tmp32, sizeof(uint32_t));
-	cur += sizeof(uint32_t);
-	len += sizeof(uint32_t);
-
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write die place: %s",
-			g_serr(errno));
+	// Find state for descriptor.
+	descriptors = pthread_getspecific(gls_descriptor_key);
+	if (!descriptors || fd < 0 || fd >= descriptors->size) {
+		return NULL;
 	}
-	return NULL;
+	return &descriptors->descriptors[fd];
 }
 
-struct flub* gls_die_place_reject_read(struct gls_die_place_reject* die, int fd,
-	int validate) {
-	struct flub* flub;
-	int i;
-	struct iovec iovs[3];
-	ssize_t len;
-
-	// Read in packet.
-	len = 0;
-	iovs[0].iov_base = die->location;
-	len += iovs[0].iov_len = GLS_LOCATION_LENGTH;
-	iovs[1].iov_base = &die->color;
-	len += iovs[1].iov_len = sizeof(uint32_t);
-	iovs[2].iov_base = die->reason;
-	len += iovs[2].iov_len = GLS_DIE_PLACE_REJECT_REASON_LENGTH;
-	if (gls_readvn(fd, iovs, sizeof(iovs) / sizeof(struct iovec)) < len) {
-		return g_flub_toss("Unable to read die place reject: %s",
-			g_serr(errno));
+static struct flub* gls_descriptor_get(int fd,
+	struct gls_descriptor** descriptor) {
+	struct gls_descriptors* descriptors;
+	struct gls_descriptor* grown;
+	int ret;
+	int size;
+
+	// Get thread's descriptor state.
+	if (fd < 0) {
+		return g_flub_toss("Invalid descriptor '%i'", fd);
+	} else if (!(descriptors = pthread_getspecific(gls_descriptor_key))) {
+		descriptors = calloc(1, sizeof(struct gls_descriptors));
+		if (!descriptors) {
+			return g_flub_toss("Unable to allocate descriptors");
+		}
+		if ((ret = pthread_setspecific(gls_descriptor_key,
+			descriptors))) {
+			free(descriptors);
+			return g_flub_toss("Unable to set pthread descriptors: "
+				"'%s'", g_serr(ret));
+		}
 	}
-	die->color = be32toh(die->color);
 
-	// Validate packet.
-	if (!validate) {
-		return NULL;
-	} else if ((flub = gls_location_validate(die->location))) {
-		return flub_append(flub, "reading die place reject");
-	} else if (die->color == GLS_COLOR_NULL || die->color > GLS_COLOR_MAX) {
-		return g_flub_toss("Invalid die color '%u'", die->color);
-	}
-	for (i = 0; i < GLS_DIE_PLACE_REJECT_REASON_LENGTH; i++) {
-		if (die->reason[i] == '\0') {
-			break;
-		} else if (!isprint(die->reason[i])) {
-			return g_flub_toss("Invalid reason char at '%i'", i);
+	// Grow state to cover descriptor.
+	if (fd >= descriptors->size) {
+		size = descriptors->size ? descriptors->size : 16;
+		while (size <= fd) {
+			size *= 2;
 		}
+		grown = realloc(descriptors->descriptors,
+			size * sizeof(struct gls_descriptor));
+		if (!grown) {
+			return g_flub_toss("Unable to grow descriptors to '%i'",
+				size);
+		}
+		memset(grown + descriptors->size, 0, (size -
+			descriptors->size) * sizeof(struct gls_descriptor));
+		descriptors->descriptors = grown;
+		descriptors->size = size;
 	}
-	if (i >= GLS_DIE_PLACE_REJECT_REASON_LENGTH) {
-		return g_flub_toss("Reason too long");
-	}
+	*descriptor = &descriptors->descriptors[fd];
 	return NULL;
 }
 
-struct flub* gls_die_place_reject_write(struct gls_die_place_reject* die,
-	int fd) {
-	char* buf;
-	char* cur;
-	ssize_t len;
-	uint32_t tmp;
+static struct gls_batch* gls_batch_get(int fd) {
+	struct gls_descriptor* descriptor;
 
-	// Prepare buffer.
-	if (!(cur = buf = pthread_getspecific(gls_key))) {
-		return g_flub_toss("Unable to get gls buffer");
-	}
-	len = 0;
-	gls_header_marshal(cur, GLS_EVENT_DIE_PLACE_REJECT);
-	cur += 4;
-	len += 4;
-	strlcpy(cur, die->location, GLS_LOCATION_LENGTH);
-	cur += GLS_LOCATION_LENGTH;
-	len += GLS_LOCATION_LENGTH;
-	tmp = htobe32(die->color);
-	memcpy(cur, &tmp, sizeof(uint32_t));
-	cur += sizeof(uint32_t);
-	len += sizeof(uint32_t);
-	strlcpy(cur, die->reason, GLS_DIE_PLACE_REJECT_REASON_LENGTH);
-	cur += GLS_DIE_PLACE_REJECT_REASON_LENGTH;
-	len += GLS_DIE_PLACE_REJECT_REASON_LENGTH;
-
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write die place reject: %s",
-			g_serr(errno));
+	// Find batch for descriptor.
+	if (!(descriptor = gls_descriptor_find(fd)) ||
+		!descriptor->batch.open) {
+		return NULL;
 	}
-	return NULL;
+	return &descriptor->batch;
 }
 
-struct flub* gls_die_place_try_read(struct gls_die_place_try* die, int fd,
-	int validate) {
-	struct flub* flub;
-	struct iovec iovs[2];
-	ssize_t len;
+static uint32_t gls_morton_spread(uint32_t value) {
+	// Spread the low byte's bits to the even bits.
+	value &= 0xFF;
+	value = (value | (value << 4)) & 0x0F0F;
+	value = (value | (value << 2)) & 0x3333;
+	value = (value | (value << 1)) & 0x5555;
+	return value;
+}
 
-	// Read packet.
-	len = 0;
-	iovs[0].iov_base = die->location;
-	len += iovs[0].iov_len = GLS_LOCATION_LENGTH;
-	iovs[1].iov_base = &die->color;
-	len += iovs[1].iov_len = sizeof(uint32_t);
-	if (gls_readvn(fd, iovs, sizeof(iovs) / sizeof(struct iovec)) < len) {
-		return g_flub_toss("Unable to read die place try packet: %s",
-			g_serr(errno));
-	}
-	die->color = be32toh(die->color);
+static uint32_t gls_morton_squeeze(uint32_t value) {
+	// Gather the even bits into the low byte.
+	value &= 0x5555;
+	value = (value | (value >> 1)) & 0x3333;
+	value = (value | (value >> 2)) & 0x0F0F;
+	value = (value | (value >> 4)) & 0x00FF;
+	return value;
+}
 
-	// Validate packet.
-	if (!validate) {
+static char* gls_compact_get(char* cur, char* end, uint64_t* value) {
+	int shift;
+
+	// Decode varint.
+	if (!cur) {
 		return NULL;
-	} else if ((flub = gls_location_validate(die->location))) {
-		return flub_append(flub, "reading die place try");
-	} else if (die->color == GLS_COLOR_NULL || die->color > GLS_COLOR_MAX) {
-		return g_flub_toss("Invalid color '%u'", die->color);
+	}
+	*value = 0;
+	for (shift = 0; cur < end && shift < 64; shift += 7) {
+		*value |= (uint64_t)(*cur & 0x7F) << shift;
+		if (!(*cur++ & 0x80)) {
+			return cur;
+		}
 	}
 	return NULL;
 }
 
-struct flub* gls_die_place_try_write(struct gls_die_place_try* die, int fd) {
-	char* buf;
-	char* cur;
-	ssize_t len;
-	uint32_t tmp;
+static char* gls_compact_get_location(char* cur, char* end,
+	char* location) {
+	uint64_t value;
 
-	// Prepare buffer.
-	if (!(cur = buf = pthread_getspecific(gls_key))) {
-		return g_flub_toss("Unable to get gls buffer");
-	}
-	len = 0;
-	gls_header_marshal(cur, GLS_EVENT_DIE_PLACE_TRY);
-	cur += 4;
-	len += 4;
-	strlcpy(cur, die->location, GLS_LOCATION_LENGTH);
-	cur += GLS_LOCATION_LENGTH;
-	len += GLS_LOCATION_LENGTH;
-	tmp = htobe32(die->color);
-	memcpy(cur, &tmp, sizeof(uint32_t));
-	cur += sizeof(uint32_t);
-	len += sizeof(uint32_t);
-
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write die place try: %s",
-			g_serr(errno));
+	// Decode Morton-coded row and column, or an empty location.
+	memset(location, 0, GLS_LOCATION_LENGTH);
+	if (!(cur = gls_compact_get(cur, end, &value)) || !value) {
+		return cur;
+	} else if (--value > 0xFFFF) {
+		return NULL;
 	}
-	return NULL;
+	gls_location_format(location, gls_morton_squeeze(value >> 1),
+		gls_morton_squeeze(value));
+	return cur;
 }
 
-void gls_header_marshal(char* buffer, uint32_t event) {
-	uint32_t tmp;
+static char* gls_compact_get_string(char* cur, char* end, char* string,
+	size_t length) {
+	uint64_t value;
 
-	// Write header data.
-	tmp = htonl(event);
-	memcpy(buffer, &tmp, sizeof(uint32_t));
+	// Decode length-prefixed string into a NUL-padded field.
+	if (!(cur = gls_compact_get(cur, end, &value)) || value > length ||
+		value > end - cur) {
+		return NULL;
+	}
+	memcpy(string, cur, value);
+	memset(string + value, 0, length - value);
+	return cur + value;
 }
 
-struct flub* gls_header_read(struct gls_header* header, int fd) {
-	// Read header.
-	if (gls_readn(fd, &header->event, sizeof(uint32_t)) <
-		sizeof(uint32_t)) {
-		// Failed/partial read.
-		return g_flub_toss("Unable to read header: '%s'",
-			g_serr(errno));
+static char* gls_compact_get_u16(char* cur, char* end, struct gls_be16* be) {
+	uint64_t value;
+
+	if (!(cur = gls_compact_get(cur, end, &value)) || value > UINT16_MAX) {
+		return NULL;
 	}
-	header->event = ntohl(header->event);
-	return NULL;
+	gls_be16_set(be, value);
+	return cur;
 }
 
-struct flub* gls_init() {
-	char* buffer;
-	struct flub* flub;
-	static int key_created = 0;
-	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-	int ret;
+static char* gls_compact_get_u32(char* cur, char* end, struct gls_be32* be) {
+	uint64_t value;
 
-	// Initialize key.
-	flub = NULL;
-	ret = pthread_mutex_lock(&mutex);
-	if (ret) {
-		return g_flub_toss("Unable to lock mutex: '%s'",
-			g_serr(ret));
-	}
-	if (!key_created) {
-		ret = pthread_key_create(&gls_key, gls_init_destructor);
-		if (ret) {
-			flub = g_flub_toss("Unable to create key: '%s'",
-				g_serr(ret));
-			goto unlock;
-		}
-		key_created = 1;
-	}
-unlock:
-	ret = pthread_mutex_unlock(&mutex);
-	if (ret && flub) {
-		flub_append(flub, "Mutex unlock failed: '%s'",
-			g_serr(ret));
-	} else if (ret) {
-		flub = g_flub_toss("Mutex unlock failed: '%s'",
-			g_serr(ret));
-	}
-	if (flub) {
-		return flub;
+	if (!(cur = gls_compact_get(cur, end, &value)) || value > UINT32_MAX) {
+		return NULL;
 	}
+	gls_be32_set(be, value);
+	return cur;
+}
 
-	// Initialize buffer.
-	buffer = (char*)malloc(GLS_BUFFER_SIZE);
-	if (!buffer) {
-		return g_flub_toss("Unable to allocate buffer");
-	}
+static char* gls_compact_get_u64(char* cur, char* end, struct gls_be64* be) {
+	uint64_t value;
 
-	// Set buffer.
-	ret = pthread_setspecific(gls_key, buffer);
-	if (ret) {
-		return g_flub_toss("Unable to set pthread buffer: '%s'",
-			g_serr(ret));
+	if (!(cur = gls_compact_get(cur, end, &value))) {
+		return NULL;
 	}
-	return NULL;
+	gls_be64_set(be, value);
+	return cur;
 }
 
-void gls_init_destructor(void* buffer) {
-	free(buffer);
+static char* gls_compact_put(char* cur, uint64_t value) {
+	// Encode varint.
+	if (!cur) {
+		return NULL;
+	}
+	for (; value >= 0x80; value >>= 7) {
+		*cur++ = (char)(value | 0x80);
+	}
+	*cur++ = (char)value;
+	return cur;
 }
 
-struct flub* gls_nick_set_read(struct gls_nick_set* set, int fd,
-	int validate) {
+static char* gls_compact_put_location(char* cur, char* location) {
+	uint32_t column;
 	struct flub* flub;
-	int i;
-	struct iovec iovs[2];
-	ssize_t len;
+	uint32_t row;
 
-	// Read nick set.
-	memset(set, 0, sizeof(struct gls_nick_set));
-	len = 0;
-	iovs[0].iov_base = &set->nick;
-	len += iovs[0].iov_len = GLS_NICK_LENGTH;
-	iovs[1].iov_base = &set->reason;
-	len += iovs[1].iov_len = GLS_NICK_SET_REASON;
-	if (gls_readvn(fd, iovs, 2) < len) {
-		return g_flub_toss("Unable to read nick set: '%s'",
-			g_serr(errno));
+	// Encode Morton-coded row and column, or an empty location.
+	if (!location[0]) {
+		return gls_compact_put(cur, 0);
+	} else if ((flub = gls_location_parse(location, &row, &column))) {
+		flub_append(flub, "encoding location");
+		return NULL;
 	}
+	return gls_compact_put(cur, ((gls_morton_spread(row) << 1) |
+		gls_morton_spread(column)) + 1);
+}
 
-	// Validate nick set.
-	if (!validate) {
+static char* gls_compact_put_string(char* cur, char* string,
+	size_t length) {
+	size_t len;
+
+	// Encode length-prefixed string.
+	len = strnlen(string, length);
+	if (!(cur = gls_compact_put(cur, len))) {
 		return NULL;
 	}
-	flub = gls_nick_validate(set->nick, 1);
-	if (flub) {
-		return flub_append(flub, "reading nick set request");
-	}
-	for (i = 0; i < GLS_NICK_SET_REASON - 1; i++) {
-		if ((!isprint(set->reason[i])) && (set->reason[i] != '\0')) {
-			return g_flub_toss("Invalid character in nick set "
-				"failure reason");
-		}
-	}
-	set->reason[GLS_NICK_SET_REASON - 1] = '\0';
-	return NULL;
+	memcpy(cur, string, len);
+	return cur + len;
 }
 
-struct flub* gls_nick_set_write(struct gls_nick_set* set, int fd) {
-	char* buf;
+static char* gls_compact_header(char* buf, uint32_t event, char* end) {
+	char header[GLS_COMPACT_HEADER_LENGTH];
+	char* body;
 	char* cur;
-	int32_t len;
-
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
-	}
 
-	// Prepare header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_NICK_SET);
-	cur += 4;
-	len = 4;
+	// Place header right before the body.
+	body = buf + GLS_COMPACT_HEADER_LENGTH;
+	cur = gls_compact_put(header, event);
+	cur = gls_compact_put(cur, end - body);
+	memcpy(body - (cur - header), header, cur - header);
+	return body - (cur - header);
+}
 
-	// Prepare nick set.
-	memcpy(cur, set->nick, GLS_NICK_LENGTH);
-	cur += GLS_NICK_LENGTH;
-	len += GLS_NICK_LENGTH;
-	memcpy(cur, set->reason, GLS_NICK_SET_REASON);
-	cur += GLS_NICK_SET_REASON;
-	len += GLS_NICK_SET_REASON;
+static struct flub* gls_compact_header_read(struct gls_header* header,
+	int fd, struct gls_descriptor* descriptor) {
+	char bytes[GLS_COMPACT_HEADER_LENGTH];
+	char* cur;
+	uint64_t event;
+	uint64_t length;
+	size_t len;
 
-	// Write packet.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write nick set: '%s'",
+	// Read the shortest header, then any further varint bytes.
+	len = 2;
+	if (gls_readn(fd, bytes, len) < len) {
+		return g_flub_toss("Unable to read header: '%s'",
 			g_serr(errno));
 	}
+	while (!(cur = gls_compact_get(bytes, bytes + len, &event)) ||
+		!gls_compact_get(cur, bytes + len, &length)) {
+		if (len == sizeof(bytes)) {
+			return g_flub_toss("Malformed compact header");
+		} else if (gls_readn(fd, bytes + len, 1) < 1) {
+			return g_flub_toss("Unable to read header: '%s'",
+				g_serr(errno));
+		}
+		len++;
+	}
+	if (event > UINT32_MAX) {
+		return g_flub_toss("Invalid event '%llu'",
+			(unsigned long long)event);
+	} else if (length > GLS_COMPACT_LENGTH_MAX) {
+		return g_flub_toss("Compact packet length '%llu' exceeds '%u'",
+			(unsigned long long)length, GLS_COMPACT_LENGTH_MAX);
+	}
+	header->event = event;
+	header->length = descriptor->length = length;
+	header->size = len;
 	return NULL;
 }
 
-struct flub* gls_location_validate(char* location) {
-	if (!isupper(location[0])) {
-		return g_flub_toss("Invalid plate row specifier");
-	} else if (location[0] - 'A' < 0) {
-		return g_flub_toss("Plate row specifier too small");
-	} else if (location[0] - 'A' >= GLS_BOARD_ROW_COUNT) {
-		return g_flub_toss("Plate row specifier too large");
-	} else if (!isdigit(location[1])) {
-		return g_flub_toss("Invalid plate column specifier");
-	} else if (location[1] - '1' < 0) {
-		return g_flub_toss("Plate column specifier too small");
-	} else if (location[1] - '1' >= GLS_BOARD_COLUMN_COUNT) {
-		return g_flub_toss("Plate column specified too large");
-	} else if (location[2] != '\0') {
-		return g_flub_toss("Expected null byte in loc specifier");
+static struct flub* gls_compact_read(int fd, char** body, char** end) {
+	char* buf;
+	struct gls_descriptor* descriptor;
+	size_t len;
+
+	// Read body given by the last header into the end of the buffer.
+	if (!(buf = pthread_getspecific(gls_key))) {
+		return g_flub_toss("Unable to get gls buffer");
+	} else if (!(descriptor = gls_descriptor_find(fd))) {
+		return g_flub_toss("No compact header read");
+	}
+	*body = buf + GLS_BUFFER_SIZE - GLS_COMPACT_LENGTH_MAX;
+	len = descriptor->length;
+	descriptor->length = 0;
+	if (gls_readn(fd, *body, len) < len) {
+		return g_flub_toss("Unable to read compact packet: '%s'",
+			g_serr(errno));
 	}
+	*end = *body + len;
 	return NULL;
 }
 
-struct flub* gls_motd_validate(char* message) {
-	int i;
-	for (i = 0; i < GLS_MOTD_LENGTH; i++) {
-		if (message[i] == '\0') {
-			break;
-		} else if (!isprint(message[i])) {
-			return g_flub_toss("Invalid MotD char at index '%i'",
-				i);
-		}
+static struct flub* gls_compact_write(int fd, uint32_t event, char* buf,
+	char* end) {
+	char* start;
+
+	// Write header and body with one call.
+	if (!end) {
+		return g_flub_toss("Unable to encode packet '%u'", event);
 	}
-	if (i == GLS_MOTD_LENGTH) {
-		return g_flub_toss("MotD too long");
+	start = gls_compact_header(buf, event, end);
+	if (gls_writen(fd, start, end - start) < end - start) {
+		return g_flub_toss("Unable to write packet '%u': '%s'",
+			event, g_serr(errno));
 	}
 	return NULL;
 }
 
-struct flub* gls_nick_change_read(struct gls_nick_change* change, int fd,
-	int validate) {
-	struct flub* flub;
-	struct iovec iovs[2];
-	ssize_t len;
+static uint64_t gls_compress_clock() {
+	struct timespec now;
 
-	// Read nick change.
-	memset(change, 0, sizeof(struct gls_nick_change));
-	len = 0;
-	iovs[0].iov_base = &change->old;
-	len += iovs[0].iov_len = GLS_NICK_LENGTH;
-	iovs[1].iov_base = &change->new;
-	len += iovs[1].iov_len = GLS_NICK_LENGTH;
-	if (gls_readvn(fd, iovs, 2) < len) {
-		return g_flub_toss("Unable to read nick change: '%s'",
-			g_serr(errno));
+	// Get thread CPU time.
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == -1) {
+		return 0;
 	}
+	return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
 
-	// Validate nick change.
-	if (!validate) {
-		return NULL;
-	}
-	flub = gls_nick_validate(change->old, 0);
-	if (flub) {
-		return flub_append(flub, "validating nick change old nick");
-	}
-	flub = gls_nick_validate(change->new, 0);
-	if (flub) {
-		return flub_append(flub, "validating nick change new nick");
-	}
-	return NULL;
+static void gls_compress_free(struct gls_compress* compress) {
+	// End streams.
+	deflateEnd(&compress->deflate);
+	inflateEnd(&compress->inflate);
+	free(compress->record);
+	free(compress->plain);
+	free(compress);
 }
 
-struct flub* gls_nick_change_write(struct gls_nick_change* change, int fd) {
-	// Write nick change.
-	char* buf;
-	char* cur;
-	ssize_t len;
+static int gls_compress_grow(unsigned char** buffer, size_t* size,
+	size_t need) {
+	unsigned char* grown;
+	size_t to;
 
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+	// Grow buffer to hold 'need' bytes.
+	if (*size >= need) {
+		return 0;
+	}
+	for (to = *size ? *size : 4096; to < need; to *= 2);
+	if (!(grown = realloc(*buffer, to))) {
+		return -1;
 	}
+	*buffer = grown;
+	*size = to;
+	return 0;
+}
 
-	// Prepare header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_NICK_CHANGE);
-	cur += 4;
-	len = 4;
+static int gls_compress_fill(struct gls_compress* compress, int fd) {
+	unsigned char byte;
+	uint64_t clock;
+	size_t length;
+	int ret;
+	int shift;
 
-	// Prepare nick change.
-	memcpy(cur, change->old, GLS_NICK_LENGTH);
-	cur += GLS_NICK_LENGTH;
-	len += GLS_NICK_LENGTH;
-	memcpy(cur, change->new, GLS_NICK_LENGTH);
-	cur += GLS_NICK_LENGTH;
-	len += GLS_NICK_LENGTH;
+	// Read record length.
+	length = 0;
+	for (shift = 0; ; shift += 7) {
+		if (shift > 21) {
+			errno = EPROTO;
+			return -1;
+		} else if (gls_rdwrn(fd, &byte, 1, read) < 1) {
+			return -1;
+		}
+		length |= (size_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			break;
+		}
+	}
+	if (!length || length > GLS_COMPRESS_RECORD_MAX) {
+		errno = EPROTO;
+		return -1;
+	}
 
-	// Write packet.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write nick change: '%s'",
-			g_serr(errno));
+	// Read record.
+	if (gls_compress_grow(&compress->record, &compress->record_size,
+		length)) {
+		return -1;
+	} else if (gls_rdwrn(fd, compress->record, length, read) < length) {
+		return -1;
 	}
-	return NULL;
-}
+	compress->received.compressed += length + shift / 7 + 1;
 
-struct flub* gls_nick_req_read(struct gls_nick_req* req, int fd, int validate) {
-	struct flub* flub;
-	ssize_t size = sizeof(req->nick);
+	// Inflate record.
+	clock = gls_compress_clock();
+	compress->plain_start = compress->plain_end = 0;
+	compress->inflate.next_in = compress->record;
+	compress->inflate.avail_in = length;
+	do {
+		if (compress->plain_end == compress->plain_size) {
+			if (compress->plain_size >= GLS_COMPRESS_RECORD_MAX) {
+				errno = EMSGSIZE;
+				return -1;
+			} else if (gls_compress_grow(&compress->plain,
+				&compress->plain_size,
+				compress->plain_size + 1)) {
+				return -1;
+			}
+		}
+		compress->inflate.next_out = compress->plain +
+			compress->plain_end;
+		compress->inflate.avail_out = compress->plain_size -
+			compress->plain_end;
+		ret = inflate(&compress->inflate, Z_SYNC_FLUSH);
+		compress->plain_end = compress->inflate.next_out -
+			compress->plain;
+		if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			errno = EPROTO;
+			return -1;
+		}
+	} while (compress->inflate.avail_in || !compress->inflate.avail_out);
+	compress->received.plain += compress->plain_end;
+	compress->received.nanoseconds += gls_compress_clock() - clock;
+	return 0;
+}
 
-	// Read nick request.
-	memset(req, 0, sizeof(struct gls_nick_req));
-	if (gls_readn(fd, req->nick, size) < size) {
-		return g_flub_toss("Unable to read nick request: %s",
-			g_serr(errno));
-	}
+static struct gls_compress* gls_compress_open(int level) {
+	struct gls_compress* compress;
 
-	// Validate nick.
-	if (!validate) {
+	// Start streams.
+	if (!(compress = calloc(1, sizeof(struct gls_compress)))) {
+		return NULL;
+	} else if (deflateInit(&compress->deflate, level) != Z_OK) {
+		free(compress);
+		return NULL;
+	} else if (inflateInit(&compress->inflate) != Z_OK) {
+		deflateEnd(&compress->deflate);
+		free(compress);
 		return NULL;
 	}
-	if ((flub = gls_nick_validate(req->nick, 0))) {
-		return flub_append(flub, "reading nick request");
-	}
-	return NULL;
+	return compress;
 }
 
-struct flub* gls_nick_req_write(struct gls_nick_req* req, int fd) {
-	char* buf;
-	char* cur;
-	int32_t len;
-
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+static ssize_t gls_compress_readv(struct gls_compress* compress, int fd,
+	struct iovec* iov, int iovcnt) {
+	size_t count;
+	int i;
+	size_t len;
+	ssize_t total;
+
+	// Copy out inflated bytes, inflating records as needed.
+	total = 0;
+	for (i = 0; i < iovcnt; i++) {
+		for (count = 0; count < iov[i].iov_len; count += len) {
+			if (compress->plain_start == compress->plain_end &&
+				gls_compress_fill(compress, fd)) {
+				return -1;
+			}
+			len = compress->plain_end - compress->plain_start;
+			if (len > iov[i].iov_len - count) {
+				len = iov[i].iov_len - count;
+			}
+			memcpy((char*)iov[i].iov_base + count, compress->plain +
+				compress->plain_start, len);
+			compress->plain_start += len;
+		}
+		total += count;
 	}
+	return total;
+}
 
-	// Prepare header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_NICK_REQ);
-	cur += 4;
-	len = 4;
+static ssize_t gls_compress_writev(struct gls_compress* compress, int fd,
+	struct iovec* iov, int iovcnt) {
+	uint64_t clock;
+	char header[GLS_VARINT_LENGTH_MAX];
+	char* end;
+	int i;
+	size_t length;
+	size_t offset;
+	unsigned char* start;
+	ssize_t total;
+
+	// Deflate all vectors into one record, flushed so the peer can read
+	// it whole.
+	clock = gls_compress_clock();
+	total = 0;
+	if (gls_compress_grow(&compress->record, &compress->record_size,
+		GLS_VARINT_LENGTH_MAX + 1)) {
+		return -1;
+	}
+	compress->deflate.next_out = compress->record + GLS_VARINT_LENGTH_MAX;
+	compress->deflate.avail_out = compress->record_size -
+		GLS_VARINT_LENGTH_MAX;
+	for (i = 0; i < iovcnt; i++) {
+		compress->deflate.next_in = iov[i].iov_base;
+		compress->deflate.avail_in = iov[i].iov_len;
+		total += iov[i].iov_len;
+		do {
+			if (!compress->deflate.avail_out) {
+				offset = compress->deflate.next_out -
+					compress->record;
+				if (gls_compress_grow(&compress->record,
+					&compress->record_size,
+					compress->record_size + 1)) {
+					return -1;
+				}
+				compress->deflate.next_out = compress->record +
+					offset;
+				compress->deflate.avail_out =
+					compress->record_size - offset;
+			}
+			if (deflate(&compress->deflate, i == iovcnt - 1 ?
+				Z_SYNC_FLUSH : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+				errno = EPROTO;
+				return -1;
+			}
+		} while (compress->deflate.avail_in ||
+			!compress->deflate.avail_out);
+	}
+	length = compress->deflate.next_out - compress->record -
+		GLS_VARINT_LENGTH_MAX;
+	if (length > GLS_COMPRESS_RECORD_MAX) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+	compress->sent.nanoseconds += gls_compress_clock() - clock;
+
+	// Write record after its length.
+	end = gls_compact_put(header, length);
+	start = compress->record + GLS_VARINT_LENGTH_MAX - (end - header);
+	memcpy(start, header, end - header);
+	length += end - header;
+	if (gls_rdwrn(fd, start, length,
+		(ssize_t(*)(int, void*, size_t))write) < length) {
+		return -1;
+	}
+	compress->sent.plain += total;
+	compress->sent.compressed += length;
+	return total;
+}
 
-	// Prepare nick request.
-	memcpy(cur, req->nick, sizeof(req->nick));
-	len += sizeof(req->nick);
+static ssize_t gls_send(int fd, void* buffer, size_t count) {
+	struct gls_descriptor* descriptor;
+	struct iovec iov;
 
-	// Write packet.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write nick request: '%s'",
-			g_serr(errno));
+	// Write past any batch, through the descriptor's deflate stream.
+	if ((descriptor = gls_descriptor_find(fd)) && descriptor->compress) {
+		iov.iov_base = buffer;
+		iov.iov_len = count;
+		return gls_compress_writev(descriptor->compress, fd, &iov, 1);
 	}
-	return NULL;
+	return gls_rdwrn(fd, buffer, count,
+		(ssize_t(*)(int, void*, size_t))write);
 }
 
-struct flub* gls_nick_validate(char* nick, int empty) {
-	int i;
-
-	// Validate nick characters.
-	for (i = 0; i < GLS_NICK_LENGTH; i++) {
-		if (nick[i] == '\0') {
+/**
+ * Returns the length of the run of printable ASCII (or alphanumeric) bytes
+ * at the start of the string, stopping at 'length'.  A NUL ends the run, so
+ * the string is terminated if the run is shorter than 'length' and the byte
+ * ending it is NUL.  Unlike 'isprint' and 'isalnum' no locale is consulted.
+ */
+static size_t gls_span_scalar(const char* string, size_t length, int class) {
+	unsigned char c;
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		c = string[i];
+		if (class == GLS_SPAN_ALNUM ? !((c >= '0' && c <= '9') ||
+			((c | 0x20) >= 'a' && (c | 0x20) <= 'z')) :
+			c < 0x20 || c > 0x7E) {
 			break;
 		}
-		if (!isalnum(nick[i])) {
-			return g_flub_toss("Invalid character in nick at "
-				"index '%i'", i);
+	}
+	return i;
+}
+
+#ifdef __SSE2__
+/**
+ * 'gls_span_scalar' sixteen bytes at a time.  Bytes are compared as signed,
+ * so bytes past 0x7F are negative and fall outside either class.
+ */
+static size_t gls_span_sse2(const char* string, size_t length, int class) {
+	__m128i bytes;
+	size_t i;
+	unsigned mask;
+	__m128i ok;
+
+	for (i = 0; i + 16 <= length; i += 16) {
+		bytes = _mm_loadu_si128((const __m128i*)(string + i));
+		if (class == GLS_SPAN_ALNUM) {
+			ok = _mm_and_si128(
+				_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)),
+				_mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+			bytes = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+			ok = _mm_or_si128(ok, _mm_and_si128(
+				_mm_cmpgt_epi8(bytes, _mm_set1_epi8('a' - 1)),
+				_mm_cmplt_epi8(bytes, _mm_set1_epi8('z' + 1))));
+		} else {
+			ok = _mm_and_si128(
+				_mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)),
+				_mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F)));
+		}
+		mask = _mm_movemask_epi8(ok);
+		if (mask != 0xFFFF) {
+			return i + __builtin_ctz(~mask);
 		}
 	}
-	if (i == GLS_NICK_LENGTH) {
-		return g_flub_toss("Nick exceeded '%i' characters",
-			GLS_NICK_LENGTH - 1);
+	return i + gls_span_scalar(string + i, length - i, class);
+}
+#endif
+
+#ifdef __x86_64__
+/**
+ * 'gls_span_scalar' thirty-two bytes at a time, for processors with AVX2.
+ */
+__attribute__((target("avx2")))
+static size_t gls_span_avx2(const char* string, size_t length, int class) {
+	__m256i bytes;
+	size_t i;
+	unsigned mask;
+	__m256i ok;
+
+	for (i = 0; i + 32 <= length; i += 32) {
+		bytes = _mm256_loadu_si256((const __m256i*)(string + i));
+		if (class == GLS_SPAN_ALNUM) {
+			ok = _mm256_and_si256(
+				_mm256_cmpgt_epi8(bytes,
+				_mm256_set1_epi8('0' - 1)),
+				_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1),
+				bytes));
+			bytes = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+			ok = _mm256_or_si256(ok, _mm256_and_si256(
+				_mm256_cmpgt_epi8(bytes,
+				_mm256_set1_epi8('a' - 1)),
+				_mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1),
+				bytes)));
+		} else {
+			ok = _mm256_and_si256(
+				_mm256_cmpgt_epi8(bytes,
+				_mm256_set1_epi8(0x1F)),
+				_mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F),
+				bytes));
+		}
+		mask = _mm256_movemask_epi8(ok);
+		if (mask != 0xFFFFFFFF) {
+			return i + __builtin_ctz(~mask);
+		}
 	}
-	if (!empty && !strlen(nick)) {
-		return g_flub_toss("Empty nick");
+	return i + gls_span_sse2(string + i, length - i, class);
+}
+#endif
+
+// Widest 'gls_span_*' the processor supports, picked by 'gls_init'.
+#ifdef __SSE2__
+static size_t (*gls_span)(const char*, size_t, int) = gls_span_sse2;
+#else
+static size_t (*gls_span)(const char*, size_t, int) = gls_span_scalar;
+#endif
+
+static struct flub* gls_reason_check(char* reason, int length) {
+	size_t i;
+
+	// Validate reason.
+	i = gls_span(reason, length, GLS_SPAN_PRINT);
+	if (i >= length) {
+		return g_flub_toss("Reason too long");
+	} else if (reason[i] != '\0') {
+		return g_flub_toss("Invalid reason char at '%i'", (int)i);
 	}
 	return NULL;
 }
 
-struct flub* gls_packet_read(struct gls_packet* packet, int fd, int validate) {
+static struct flub* gls_board_size_check(struct gls_board_size_wire* size) {
+	uint32_t columns;
+	uint32_t dice;
+	uint32_t rows;
+
+	rows = gls_be32_get(&size->rows);
+	columns = gls_be32_get(&size->columns);
+	dice = gls_be32_get(&size->dice);
+	if (!rows || rows > GLS_BOARD_ROW_MAX) {
+		return g_flub_toss("Invalid board row count '%u'", rows);
+	} else if (!columns || columns > GLS_BOARD_COLUMN_MAX) {
+		return g_flub_toss("Invalid board column count '%u'", columns);
+	} else if (!dice || dice > GLS_DIE_MAX) {
+		return g_flub_toss("Invalid board die count '%u'", dice);
+	}
+	return NULL;
+}
+
+static struct flub* gls_connect_check(struct gls_connect_wire* connect) {
 	struct flub* flub;
 
-	// Read in packet header.
-	memset(packet, 0, sizeof(struct gls_packet));
-	flub = gls_header_read(&packet->header, fd);
-	if (flub) {
+	if ((flub = gls_connect_validate(gls_be32_get(&connect->from),
+		gls_be32_get(&connect->to)))) {
+		return flub;
+	} else if ((flub = gls_nick_validate(connect->nick, 0))) {
 		return flub;
 	}
+	return NULL;
+}
 
-	// Read in actual packet.
-	switch(packet->header.event) {
-	case GLS_EVENT_DIE_PLACE:
-		flub = gls_die_place_read(&packet->data.die_place, fd,
-			validate);
-		break;
-	case GLS_EVENT_DIE_PLACE_REJECT:
-		flub = gls_die_place_reject_read(&packet->data.die_place_reject,
-			fd, validate);
-		break;
-	case GLS_EVENT_DIE_PLACE_TRY:
-		flub = gls_die_place_try_read(&packet->data.die_place_try, fd,
-			validate);
-		break;
-	case GLS_EVENT_PROTOVER:
-		flub = gls_protover_read(&packet->data.protover, fd, validate);
-		break;
-	case GLS_EVENT_PROTOVERACK:
-		flub = gls_protoverack_read(&packet->data.protoverack, fd,
-			validate);
-		break;
-	case GLS_EVENT_NICK_REQ:
-		flub = gls_nick_req_read(&packet->data.nick_req, fd, validate);
-		break;
-	case GLS_EVENT_NICK_SET:
-		flub = gls_nick_set_read(&packet->data.nick_set, fd,
-			validate);
-		break;
-	case GLS_EVENT_NICK_CHANGE:
-		flub = gls_nick_change_read(&packet->data.nick_change, fd,
-			validate);
-		break;
-	case GLS_EVENT_PLAYER_JOIN:
-		flub = gls_player_join_read(&packet->data.player_join, fd,
-			validate);
-		break;
-	case GLS_EVENT_PLAYER_PART:
-		flub = gls_player_part_read(&packet->data.player_part, fd,
-			validate);
-		break;
-	case GLS_EVENT_SHUTDOWN:
-		flub = gls_shutdown_read(&packet->data.shutdown, fd, validate);
-		break;
-	case GLS_EVENT_SAY1:
-		flub = gls_say1_read(&packet->data.say1, fd, validate);
-		break;
-	case GLS_EVENT_SAY2:
-		flub = gls_say2_read(&packet->data.say2, fd, validate);
-		break;
-	case GLS_EVENT_SYNC_END:
-		flub = gls_sync_end_read(&packet->data.sync_end, fd, validate);
-		break;
-	default:
-		flub = g_flub_toss("Unknown packet type: '%u'",
-			packet->header.event);
-		break;
+static struct flub* gls_connect_reject_check(
+	struct gls_connect_reject_wire* reject) {
+	struct flub* flub;
+
+	if ((flub = gls_connect_validate(gls_be32_get(&reject->from),
+		gls_be32_get(&reject->to)))) {
+		return flub;
 	}
-	if (flub) {
+	return gls_reason_check(reject->reason,
+		GLS_CONNECT_REJECT_REASON_LENGTH);
+}
+
+static struct flub* gls_connect_try_check(
+	struct gls_connect_try_wire* connect) {
+	return gls_connect_validate(gls_be32_get(&connect->from),
+		gls_be32_get(&connect->to));
+}
+
+static struct flub* gls_die_place_check(struct gls_die_place_wire* die) {
+	uint32_t color;
+	struct flub* flub;
+	uint32_t number;
+
+	color = gls_be32_get(&die->color);
+	number = gls_be32_get(&die->die);
+	if ((flub = gls_location_validate(die->location))) {
+		return flub;
+	} else if (color > GLS_COLOR_MAX || color == GLS_COLOR_NULL) {
+		return g_flub_toss("Invalid die color '%u'", color);
+	} else if ((flub = gls_nick_validate(die->nick, 0))) {
 		return flub;
+	} else if (number >= GLS_DIE_MAX) {
+		return g_flub_toss("Invalid die number '%u'", number);
 	}
 	return NULL;
 }
 
-struct flub* gls_packet_write(struct gls_packet* packet, int fd) {
+static struct flub* gls_die_place_reject_check(
+	struct gls_die_place_reject_wire* die) {
+	uint32_t color;
 	struct flub* flub;
 
-	// Write the packet.
-	switch(packet->header.event) {
-	case GLS_EVENT_DIE_PLACE:
-		flub = gls_die_place_write(&packet->data.die_place, fd);
-		break;
-	case GLS_EVENT_DIE_PLACE_REJECT:
-		flub = gls_die_place_reject_write(
-			&packet->data.die_place_reject, fd);
-		break;
-	case GLS_EVENT_DIE_PLACE_TRY:
-		flub = gls_die_place_try_write(&packet->data.die_place_try, fd);
-		break;
-	case GLS_EVENT_PROTOVER:
-		flub = gls_protover_write(&packet->data.protover, fd);
-		break;
-	case GLS_EVENT_PROTOVERACK:
-		flub = gls_protoverack_write(&packet->data.protoverack, fd);
-		break;
-	case GLS_EVENT_NICK_REQ:
-		flub = gls_nick_req_write(&packet->data.nick_req, fd);
-		break;
-	case GLS_EVENT_NICK_SET:
-		flub = gls_nick_set_write(&packet->data.nick_set, fd);
-		break;
-	case GLS_EVENT_NICK_CHANGE:
-		flub = gls_nick_change_write(&packet->data.nick_change, fd);
-		break;
-	case GLS_EVENT_PLAYER_JOIN:
-		flub = gls_player_join_write(&packet->data.player_join, fd);
-		break;
-	case GLS_EVENT_PLAYER_PART:
-		flub = gls_player_part_write(&packet->data.player_part, fd);
-		break;
-	case GLS_EVENT_SHUTDOWN:
-		flub = gls_shutdown_write(&packet->data.shutdown, fd);
-		break;
-	case GLS_EVENT_SAY1:
-		flub = gls_say1_write(&packet->data.say1, fd);
-		break;
-	case GLS_EVENT_SAY2:
-		flub = gls_say2_write(&packet->data.say2, fd);
-		break;
-	case GLS_EVENT_SYNC_END:
-		flub = gls_sync_end_write(&packet->data.sync_end, fd);
-		break;
-	default:
-		flub = g_flub_toss("Unknown packet type: '%u'",
-			packet->header.event);
-		break;
+	color = gls_be32_get(&die->color);
+	if ((flub = gls_location_validate(die->location))) {
+		return flub;
+	} else if (color == GLS_COLOR_NULL || color > GLS_COLOR_MAX) {
+		return g_flub_toss("Invalid die color '%u'", color);
 	}
-	if (flub) {
+	return gls_reason_check(die->reason,
+		GLS_DIE_PLACE_REJECT_REASON_LENGTH);
+}
+
+static struct flub* gls_die_place_try_check(
+	struct gls_die_place_try_wire* die) {
+	uint32_t color;
+	struct flub* flub;
+
+	color = gls_be32_get(&die->color);
+	if ((flub = gls_location_validate(die->location))) {
 		return flub;
+	} else if (color == GLS_COLOR_NULL || color > GLS_COLOR_MAX) {
+		return g_flub_toss("Invalid color '%u'", color);
 	}
 	return NULL;
 }
 
-struct flub* gls_plate_place_read(struct gls_plate_place* plate, int fd,
-	int validate) {
-	int i = 0;
-	struct iovec iovs[5];
-	ssize_t len;
+static struct flub* gls_history_check(struct gls_history_wire* history) {
+	uint32_t connections;
+	uint32_t dice;
 
-	// Read packet.
-	memset(plate, 0, sizeof(struct gls_plate_place));
-	len = 0;
-	iovs[0].iov_base = plate->abbrev;
-	len += iovs[0].iov_len = GLS_PLATE_ABBREV_LENGTH;
-	iovs[1].iov_base = plate->description;
-	len += iovs[1].iov_len = GLS_PLATE_DESCRIPTION_LENGTH;
-	iovs[2].iov_base = plate->name;
-	len += iovs[2].iov_len = GLS_PLATE_NAME_LENGTH;
-	iovs[3].iov_base = plate->loc;
-	len += iovs[3].iov_len = GLS_LOCATION_LENGTH;
-	iovs[4].iov_base = &plate->flags;
-	len += iovs[4].iov_len = sizeof(uint32_t);
-	if (gls_readvn(fd, iovs, sizeof(iovs) / sizeof(struct iovec)) < len) {
-		return g_flub_toss("Unable to read plate_place packet: '%s'",
-			g_serr(errno));
+	dice = gls_be32_get(&history->dice);
+	connections = gls_be32_get(&history->connections);
+	if (dice > GLS_DIE_MAX) {
+		return g_flub_toss("Invalid history die count '%u'", dice);
+	} else if (connections >= GLS_DIE_MAX) {
+		return g_flub_toss("Invalid history connection count '%u'",
+			connections);
 	}
-	plate->flags = be32toh(plate->flags);
+	return NULL;
+}
 
-	// Validate packet.
-	// TODO: Refactor ugly mess.
-	if (!validate) {
-		return NULL;
+static struct flub* gls_history_req_check(struct gls_history_req_wire* req) {
+	// Any version may be requested.
+	return NULL;
+}
+
+static struct flub* gls_nick_change_check(
+	struct gls_nick_change_wire* change) {
+	struct flub* flub;
+
+	if ((flub = gls_nick_validate(change->old, 0))) {
+		return flub_append(flub, "validating old nick");
+	} else if ((flub = gls_nick_validate(change->new, 0))) {
+		return flub_append(flub, "validating new nick");
 	}
-	for (i = 0; i < GLS_PLATE_ABBREV_LENGTH; i++) {
-		if (plate->abbrev[i] == '\0') {
-			break;
-		} else if (!isprint(plate->abbrev[i])) {
-			return g_flub_toss("Invalid abbrev char at index '%i'",
-				i);
-		}
+	return NULL;
+}
+
+static struct flub* gls_nick_req_check(struct gls_nick_req_wire* req) {
+	return gls_nick_validate(req->nick, 0);
+}
+
+static struct flub* gls_nick_set_check(struct gls_nick_set_wire* set) {
+	struct flub* flub;
+	size_t i;
+
+	if ((flub = gls_nick_validate(set->nick, 1))) {
+		return flub;
 	}
+	set->reason[GLS_NICK_SET_REASON - 1] = '\0';
+	i = gls_span(set->reason, GLS_NICK_SET_REASON, GLS_SPAN_PRINT);
+	if (set->reason[i] != '\0') {
+		return g_flub_toss("Invalid character in nick set failure "
+			"reason");
+	}
+	return NULL;
+}
+
+static struct flub* gls_plate_place_check(
+	struct gls_plate_place_wire* plate) {
+	uint32_t flags;
+	struct flub* flub;
+	size_t i;
+
+	flags = gls_be32_get(&plate->flags);
+	i = gls_span(plate->abbrev, GLS_PLATE_ABBREV_LENGTH, GLS_SPAN_PRINT);
 	if (i == GLS_PLATE_ABBREV_LENGTH) {
 		return g_flub_toss("Plate abbreviation too long");
-	} else if (!i && (!(plate->flags & GLS_PLATE_FLAG_EMPTY))) {
+	} else if (plate->abbrev[i] != '\0') {
+		return g_flub_toss("Invalid abbrev char at index '%i'",
+			(int)i);
+	} else if (!i && (!(flags & GLS_PLATE_FLAG_EMPTY))) {
 		return g_flub_toss("Empty plate abbreviation");
 	}
-	for (i = 0; i < GLS_PLATE_DESCRIPTION_LENGTH; i++) {
-		if (plate->description[i] == '\0') {
-			break;
-		} else if (!isprint(plate->description[i])) {
-			return g_flub_toss("Invalid plate desc char at index "
-				"'%i'", i);
-		}
-	}
+	i = gls_span(plate->description, GLS_PLATE_DESCRIPTION_LENGTH,
+		GLS_SPAN_PRINT);
 	if (i == GLS_PLATE_DESCRIPTION_LENGTH) {
 		return g_flub_toss("Plate description too long");
+	} else if (plate->description[i] != '\0') {
+		return g_flub_toss("Invalid plate desc char at index '%i'",
+			(int)i);
 	}
-	for (i = 0; i < GLS_PLATE_NAME_LENGTH; i++) {
-		if (plate->name[i] == '\0') {
-			break;
-		} else if (!isprint(plate->name[i])) {
-			return g_flub_toss("Invalid plate name char at index "
-				"'%i'", i);
-		}
+	i = gls_span(plate->name, GLS_PLATE_NAME_LENGTH, GLS_SPAN_PRINT);
+	if (i < GLS_PLATE_NAME_LENGTH && plate->name[i] != '\0') {
+		return g_flub_toss("Invalid plate name char at index '%i'",
+			(int)i);
 	}
-	if (!i && (!(plate->flags & GLS_PLATE_FLAG_EMPTY))) {
+	if (!i && (!(flags & GLS_PLATE_FLAGS))) {
 		return g_flub_toss("Emply plate name");
 	}
-	if (!isupper(plate->loc[0])) {
-		return g_flub_toss("Invalid plate row specifier");
-	} else if (plate->loc[0] - 'A' < 0) {
-		return g_flub_toss("Plate row specifier too small");
-	} else if (plate->loc[0] - 'A' >= GLS_BOARD_ROW_COUNT) {
-		return g_flub_toss("Plate row specifier too large");
-	} else if (!isdigit(plate->loc[1])) {
-		return g_flub_toss("Invalid plate column specifier");
-	} else if (plate->loc[1] - '1' < 0) {
-		return g_flub_toss("Plate column specifier too small");
-	} else if (plate->loc[1] - '1' >= GLS_BOARD_COLUMN_COUNT) {
-		return g_flub_toss("Plate column specified too large");
-	} else if (plate->loc[2] != '\0') {
-		return g_flub_toss("Expected null byte in loc specifier");
+	if ((flub = gls_location_validate(plate->loc))) {
+		return flub;
 	}
-	if (plate->flags & (~GLS_PLATE_FLAG_EMPTY)) {
+	if (flags & (~GLS_PLATE_FLAGS)) {
 		return g_flub_toss("Unknown flag is set");
 	}
 	return NULL;
 }
 
-struct flub* gls_plate_place_write(struct gls_plate_place* plate, int fd) {
-	char* buf;
-	char* cur;
-	ssize_t len;
-	uint32_t flags;
-
-	// Get buffer.
-	if (!(cur = buf = pthread_getspecific(gls_key))) {
-		return g_flub_toss("Unable to get gls buffer");
+static struct flub* gls_plate_detail_check(
+	struct gls_plate_detail_wire* detail) {
+	if (gls_be32_get(&detail->plate.flags) & GLS_PLATE_FLAG_BRIEF) {
+		return g_flub_toss("Brief plate detail");
 	}
+	return gls_plate_place_check(&detail->plate);
+}
 
-	// Prepare buffer.
-	len = 0;
-	gls_header_marshal(cur, GLS_EVENT_PLATE_PLACE);
-	cur += len = 4;
-	strlcpy(cur, plate->abbrev, GLS_PLATE_ABBREV_LENGTH);
-	cur += GLS_PLATE_ABBREV_LENGTH;
-	len += GLS_PLATE_ABBREV_LENGTH;
-	strlcpy(cur, plate->description, GLS_PLATE_DESCRIPTION_LENGTH);
-	cur += GLS_PLATE_DESCRIPTION_LENGTH;
-	len += GLS_PLATE_DESCRIPTION_LENGTH;
-	strlcpy(cur, plate->name, GLS_PLATE_NAME_LENGTH);
-	cur += GLS_PLATE_NAME_LENGTH;
-	len += GLS_PLATE_NAME_LENGTH;
-	strlcpy(cur, plate->loc, GLS_LOCATION_LENGTH);
-	cur += GLS_LOCATION_LENGTH;
-	len += GLS_LOCATION_LENGTH;
-	flags = htobe32(plate->flags);
-	memcpy(cur, &flags, sizeof(flags));
-	cur += sizeof(flags);
-	len += sizeof(flags);
-
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write plate_place packet: '%s'",
-			g_serr(errno));
+static struct flub* gls_plate_detail_req_check(
+	struct gls_plate_detail_req_wire* req) {
+	return gls_location_validate(req->loc);
+}
+
+static struct flub* gls_plate_set_check(struct gls_plate_set_wire* set) {
+	uint32_t flags;
+
+	flags = gls_be32_get(&set->flags);
+	if (!gls_be64_get(&set->hash)) {
+		return g_flub_toss("Empty plate set hash");
+	} else if (flags & ~GLS_PLATE_SET_FLAGS) {
+		return g_flub_toss("Invalid plate set flags '%u'", flags);
 	}
 	return NULL;
 }
 
-struct flub* gls_player_join_read(struct gls_player_join* join, int fd,
-	int validate) {
-	struct flub* flub;
-	ssize_t size = sizeof(join->nick);
+static struct flub* gls_player_join_check(
+	struct gls_player_join_wire* join) {
+	return gls_nick_validate(join->nick, 0);
+}
 
-	// Read in data.
-	if (gls_readn(fd, join->nick, size) < size) {
-		return g_flub_toss("Unable to read player join nick: '%s'",
-			g_serr(errno));
-	}
+static struct flub* gls_player_part_check(
+	struct gls_player_part_wire* part) {
+	return gls_nick_validate(part->nick, 0);
+}
 
-	// Validate data.
-	if (!validate) {
-		return NULL;
+static struct flub* gls_protover_check(struct gls_protover_wire* pver) {
+	int i;
+
+	if (strncmp(pver->magic, "GLS", GLS_PROTOVER_MAGIC_LENGTH)) {
+		return g_flub_toss("Invalid magic in protover");
 	}
-	if ((flub = gls_nick_validate(join->nick, 0))) {
-		return flub_append(flub, "reading player join");
+	for (i = 0; i < strlen(pver->version); i++) {
+		if ((!isdigit(pver->version[i])) && (pver->version[i] != '.')) {
+			return g_flub_toss("Invalid version in protover");
+		}
+	}
+	for (i = 0; i < strlen(pver->software); i++) {
+		if ((!isalnum(pver->software[i])) &&
+			(pver->software[i] != '_')) {
+			return g_flub_toss("Invalid software in protover");
+		}
 	}
 	return NULL;
 }
 
-struct flub* gls_player_join_write(struct gls_player_join* join, int fd) {
-	char* buf;
-	char* cur;
-	int32_t len;
+static struct flub* gls_protoverack_check(
+	struct gls_protoverack_wire* pack) {
+	struct flub* flub;
+	size_t i;
 
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+	if ((flub = gls_protover_check(&pack->pver))) {
+		return flub;
 	}
+	i = gls_span(pack->reason, GLS_PROTOVER_REASON_LENGTH, GLS_SPAN_PRINT);
+	if (i < GLS_PROTOVER_REASON_LENGTH && pack->reason[i]) {
+		return g_flub_toss("Invalid reason in protover ack");
+	}
+	return NULL;
+}
 
-	// Prepare header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_PLAYER_JOIN);
-	cur += len = sizeof(len);
+static struct flub* gls_say1_check(struct gls_say1_wire* say) {
+	return gls_say_message_validate(say->message);
+}
 
-	// Prepare player join.
-	memcpy(cur, join->nick, sizeof(join->nick));
-	len += sizeof(join->nick);
+static struct flub* gls_say2_check(struct gls_say2_wire* say) {
+	struct flub* flub;
 
-	// Write data.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write player join: '%s'",
-			g_serr(errno));
+	if ((flub = gls_nick_validate(say->nick, 0))) {
+		return flub;
 	}
-	return NULL;
+	return gls_say_message_validate(say->message);
 }
 
-struct flub* gls_player_part_read(struct gls_player_part* part, int fd,
-	int validate) {
+static struct flub* gls_score_check(struct gls_score_wire* score) {
+	uint32_t color;
 	struct flub* flub;
-	ssize_t size = sizeof(part->nick);
 
-	// Read in data.
-	if (gls_readn(fd, part->nick, size) < size) {
-		return g_flub_toss("Unable to read player part nick: '%s'",
-			g_serr(errno));
+	color = gls_be32_get(&score->color);
+	if ((flub = gls_nick_validate(score->nick, 0))) {
+		return flub;
+	} else if (color > GLS_COLOR_MAX) {
+		return g_flub_toss("Invalid score color '%u'", color);
 	}
+	return NULL;
+}
 
-	// Validate data.
-	if (!validate) {
-		return NULL;
-	}
-	if ((flub = gls_nick_validate(part->nick, 0))) {
-		return flub_append(flub, "reading player part");
+static struct flub* gls_shutdown_check(struct gls_shutdown_wire* shutdown) {
+	size_t i;
+
+	shutdown->reason[GLS_SHUTDOWN_REASON_LENGTH - 1] = '\0';
+	i = gls_span(shutdown->reason, GLS_SHUTDOWN_REASON_LENGTH,
+		GLS_SPAN_PRINT);
+	if (shutdown->reason[i] != '\0') {
+		return g_flub_toss("Invalid shutdown reason char at '%i'",
+			(int)i);
 	}
 	return NULL;
 }
 
-struct flub* gls_player_part_write(struct gls_player_part* part, int fd) {
-	char* buf;
-	char* cur;
-	int32_t len;
+static struct flub* gls_subscribe_check(
+	struct gls_subscribe_wire* subscribe) {
+	uint32_t flags;
+	struct flub* flub;
 
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+	flags = gls_be32_get(&subscribe->flags);
+	if (flags & ~GLS_SUBSCRIBE_FLAGS) {
+		return g_flub_toss("Invalid subscribe flags '%u'", flags);
+	} else if (flags & GLS_SUBSCRIBE_FLAG_ALL) {
+		return NULL;
+	} else if ((flub = gls_location_validate(subscribe->from)) ||
+		(flub = gls_location_validate(subscribe->to))) {
+		return flub;
 	}
+	return NULL;
+}
 
-	// Prepare header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_PLAYER_PART);
-	cur += len = sizeof(len);
+static struct flub* gls_sync_end_check(struct gls_sync_end_wire* sync_end) {
+	return gls_motd_validate(sync_end->motd);
+}
 
-	// Prepare player part.
-	memcpy(cur, part->nick, sizeof(part->nick));
-	len += sizeof(part->nick);
+static struct flub* gls_sync_req_check(struct gls_sync_req_wire* req) {
+	uint32_t flags;
 
-	// Write data.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write player part: '%s'",
-			g_serr(errno));
+	flags = gls_be32_get(&req->flags);
+	if (flags & ~GLS_SYNC_REQ_FLAGS) {
+		return g_flub_toss("Invalid sync req flags '%u'", flags);
 	}
 	return NULL;
 }
 
-struct flub* gls_protover_read(struct gls_protover* pver, int fd,
-	int validate) {
-	struct iovec iovs[3];
-	int i;
-	ssize_t len;
+// Wire packet helpers, generated from 'gls.def'.  Terminate the terminated
+// strings of a wire packet.
+#define GLS_PACKET(event, name) \
+static void gls_##name##_terminate(struct gls_##name##_wire* wire) {
+#define GLS_STRZ(field, length) wire->field[length - 1] = '\0';
+#define GLS_NEST(field, name) gls_##name##_terminate(&wire->field);
+#define GLS_END(name) }
+#include "gls.def"
+
+// Expand a compact packet body into its wire form, returning the end of the
+// consumed body or NULL if it is malformed.
+#define GLS_PACKET(event, name) \
+static char* gls_##name##_expand(struct gls_##name##_wire* wire, char* cur, \
+	char* end) {
+#define GLS_U16(field) cur = gls_compact_get_u16(cur, end, &wire->field);
+#define GLS_U32(field) cur = gls_compact_get_u32(cur, end, &wire->field);
+#define GLS_U64(field) cur = gls_compact_get_u64(cur, end, &wire->field);
+#define GLS_STR(field, length) \
+	cur = gls_compact_get_string(cur, end, wire->field, length);
+#define GLS_STRZ(field, length) GLS_STR(field, length)
+#define GLS_LOC(field) cur = gls_compact_get_location(cur, end, wire->field);
+#define GLS_NEST(field, name) cur = gls_##name##_expand(&wire->field, cur, end);
+#define GLS_END(name) return cur; }
+#include "gls.def"
+
+// Read a wire packet's body with one call, or expand its compact body, then
+// validate it in place.
+#define GLS_PACKET(event, name) \
+static struct flub* gls_##name##_wire_read(struct gls_##name##_wire* wire, \
+	int fd, int validate) { \
+	char* body; \
+	char* end; \
+	struct flub* flub; \
+	if (gls_protocol_get(fd)) { \
+		if ((flub = gls_compact_read(fd, &body, &end))) { \
+			return flub_append(flub, "reading " #name " packet"); \
+		} else if (gls_##name##_expand(wire, body, end) != end) { \
+			return g_flub_toss("Malformed " #name " packet"); \
+		} \
+	} else if (gls_readn(fd, wire, sizeof(*wire)) < sizeof(*wire)) { \
+		return g_flub_toss("Unable to read " #name " packet: '%s'", \
+			g_serr(errno)); \
+	} \
+	gls_##name##_terminate(wire); \
+	if (validate && (flub = gls_##name##_check(wire))) { \
+		return flub_append(flub, "reading " #name " packet"); \
+	} \
+	return NULL; \
+}
+#include "gls.def"
+
+// Encode a packet into its wire form, NUL-padding its strings.
+#define GLS_PACKET(event, name) \
+static void gls_##name##_encode(struct gls_##name##_wire* wire, \
+	struct gls_##name* packet) {
+#define GLS_U16(field) gls_be16_set(&wire->field, packet->field);
+#define GLS_U32(field) gls_be32_set(&wire->field, packet->field);
+#define GLS_U64(field) gls_be64_set(&wire->field, packet->field);
+#define GLS_STR(field, length) strncpy(wire->field, packet->field, length);
+#define GLS_STRZ(field, length) GLS_STR(field, length)
+#define GLS_LOC(field) GLS_STR(field, GLS_LOCATION_LENGTH)
+#define GLS_NEST(field, name) gls_##name##_encode(&wire->field, &packet->field);
+#define GLS_END(name) }
+#include "gls.def"
+
+// Encode a packet into its compact form, returning the end of the encoded
+// body or NULL if a field can't be encoded.
+#define GLS_PACKET(event, name) \
+static char* gls_##name##_compact(char* cur, struct gls_##name* packet) {
+#define GLS_U16(field) cur = gls_compact_put(cur, packet->field);
+#define GLS_U32(field) cur = gls_compact_put(cur, packet->field);
+#define GLS_U64(field) cur = gls_compact_put(cur, packet->field);
+#define GLS_STR(field, length) \
+	cur = gls_compact_put_string(cur, packet->field, length);
+#define GLS_STRZ(field, length) GLS_STR(field, length)
+#define GLS_LOC(field) cur = gls_compact_put_location(cur, packet->field);
+#define GLS_NEST(field, name) cur = gls_##name##_compact(cur, &packet->field);
+#define GLS_END(name) return cur; }
+#include "gls.def"
 
-	// Read protover.
-	memset(pver, 0, sizeof(struct gls_protover));
-	iovs[0].iov_base = &pver->magic;
-	iovs[0].iov_len = GLS_PROTOVER_MAGIC_LENGTH;
-	iovs[1].iov_base = &pver->version;
-	iovs[1].iov_len = GLS_PROTOVER_VERSION_LENGTH;
-	iovs[2].iov_base = &pver->software;
-	iovs[2].iov_len = GLS_PROTOVER_SOFTWARE_LENGTH;
-	len = GLS_PROTOVER_MAGIC_LENGTH + GLS_PROTOVER_VERSION_LENGTH +
-		GLS_PROTOVER_SOFTWARE_LENGTH;
-	if (gls_readvn(fd, iovs, 3) < len) {
-		return g_flub_toss("Unable to read protover: '%s'",
-			g_serr(errno));
+// Library functions.
+void gls_batch_close(int fd) {
+	struct gls_batch* batch;
+
+	// Discard batch.
+	if (!(batch = gls_batch_get(fd))) {
+		return;
 	}
-	pver->magic[GLS_PROTOVER_MAGIC_LENGTH - 1] = '\0';
-	pver->version[GLS_PROTOVER_VERSION_LENGTH - 1] = '\0';
-	pver->software[GLS_PROTOVER_SOFTWARE_LENGTH - 1] = '\0';
+	free(batch->data);
+	memset(batch, 0, sizeof(struct gls_batch));
+}
 
-	// Validate protover.
-	if (!validate) {
+struct flub* gls_batch_flush(int fd) {
+	struct gls_batch* batch;
+	struct gls_frame frame;
+	ssize_t len;
+
+	// Check for held packets.
+	if (!(batch = gls_batch_get(fd)) || !batch->count) {
 		return NULL;
 	}
-	if (strncmp(pver->magic, "GLS", GLS_PROTOVER_MAGIC_LENGTH)) {
-		return g_flub_toss("Invalid magic in protover");
-	}
-	for (i = 0; i < strlen(pver->version); i++) {
-		if ((!isdigit(pver->version[i])) && (pver->version[i] != '.')) {
-			return g_flub_toss("Invalid version in protover");
+	frame.count = batch->count;
+	frame.length = batch->length;
+	batch->count = 0;
+	batch->length = 0;
+
+	// A lone packet needs no frame.
+	if (frame.count == 1) {
+		len = frame.length;
+		if (gls_send(fd, batch->data, len) < len) {
+			return g_flub_toss("Unable to write batched packet: "
+				"%s", g_serr(errno));
 		}
+		return NULL;
 	}
-	for (i = 0; i < strlen(pver->software); i++) {
-		if ((!isalnum(pver->software[i])) &&
-			(pver->software[i] != '_')) {
-			return g_flub_toss("Invalid software in protover");
-		}
+	return gls_frame_write(&frame, batch->data, fd);
+}
+
+size_t gls_batch_length(int fd) {
+	struct gls_batch* batch;
+
+	// Get held bytes.
+	if (!(batch = gls_batch_get(fd))) {
+		return 0;
+	}
+	return batch->length;
+}
+
+struct flub* gls_batch_open(int fd) {
+	struct gls_descriptor* descriptor;
+	struct flub* flub;
+
+	// Open batch.
+	if ((flub = gls_descriptor_get(fd, &descriptor))) {
+		return flub_append(flub, "opening batch");
 	}
+	descriptor->batch.open = 1;
 	return NULL;
 }
 
-struct flub* gls_protover_write(struct gls_protover* pver, int fd) {
-	char* buf;
-	char* cur;
-	ssize_t len;
+void gls_compress_stats(int fd, struct gls_compress_stats* sent,
+	struct gls_compress_stats* received) {
+	struct gls_descriptor* descriptor;
 
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+	// Copy counters.
+	if (!(descriptor = gls_descriptor_find(fd)) || !descriptor->compress) {
+		memset(sent, 0, sizeof(struct gls_compress_stats));
+		memset(received, 0, sizeof(struct gls_compress_stats));
+		return;
 	}
+	memcpy(sent, &descriptor->compress->sent,
+		sizeof(struct gls_compress_stats));
+	memcpy(received, &descriptor->compress->received,
+		sizeof(struct gls_compress_stats));
+}
 
-	// Prepare data.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_PROTOVER);
-	cur += 4;
-	len = 4;
-	memcpy(cur, pver->magic, GLS_PROTOVER_MAGIC_LENGTH);
-	len += GLS_PROTOVER_MAGIC_LENGTH;
-	cur += GLS_PROTOVER_MAGIC_LENGTH;
-	memcpy(cur, pver->version, GLS_PROTOVER_VERSION_LENGTH);
-	len += GLS_PROTOVER_VERSION_LENGTH;
-	cur += GLS_PROTOVER_VERSION_LENGTH;
-	memcpy(cur, pver->software, GLS_PROTOVER_SOFTWARE_LENGTH);
-	len += GLS_PROTOVER_SOFTWARE_LENGTH;
-
-	// Write packet.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write full protover");
+struct flub* gls_connect_validate(uint32_t from, uint32_t to) {
+	if (from >= GLS_DIE_MAX) {
+		return g_flub_toss("Invalid die number '%u'", from);
+	} else if (to >= GLS_DIE_MAX) {
+		return g_flub_toss("Invalid die number '%u'", to);
+	} else if (from == to) {
+		return g_flub_toss("Die '%u' connected to itself", from);
 	}
 	return NULL;
 }
 
-struct flub* gls_protoverack_read(struct gls_protoverack* pack, int fd,
-	int validate) {
-	struct flub* flub;
+void gls_descriptor_destructor(void* v_descriptors) {
+	struct gls_descriptors* descriptors;
 	int i;
-	struct iovec iovs[2];
-	ssize_t len;
 
-	// Read in first part.
-	memset(pack, 0, sizeof(struct gls_protoverack));
-	iovs[0].iov_base = &pack->ack;
-	len = iovs[0].iov_len = sizeof(uint16_t);
-	iovs[1].iov_base = &pack->reason;
-	len += iovs[1].iov_len = GLS_PROTOVER_REASON_LENGTH;
-	if (gls_readvn(fd, iovs, 2) < len) {
-		return g_flub_toss("Unable to read ack header: '%s'",
-			g_serr(errno));
+	// Free descriptor state.
+	descriptors = (struct gls_descriptors*)v_descriptors;
+	for (i = 0; i < descriptors->size; i++) {
+		free(descriptors->descriptors[i].batch.data);
+		if (descriptors->descriptors[i].compress) {
+			gls_compress_free(descriptors->descriptors[i].compress);
+		}
 	}
-	pack->ack = ntohs(pack->ack);
-	pack->reason[GLS_PROTOVER_REASON_LENGTH - 1] = '\0';
+	free(descriptors->descriptors);
+	free(descriptors);
+}
 
-	// Read in protover.
-	flub = gls_protover_read(&pack->pver, fd, validate);
-	if (flub) {
-		return flub_append(flub, "unable to read protoack");
+uint32_t gls_event_length(uint32_t event) {
+	// Find the event's fixed data length.
+	switch(event) {
+#define GLS_PACKET(event, name) \
+	case GLS_EVENT_##event: \
+		return sizeof(struct gls_##name##_wire);
+#include "gls.def"
+	case GLS_EVENT_FRAME:
+		return 2 * sizeof(uint32_t);
+	default:
+		return GLS_LENGTH_UNKNOWN;
 	}
+}
 
-	// Validate reason.
+struct flub* gls_frame_read(struct gls_frame* frame, int fd, int validate) {
+	char* body;
+	char* cur;
+	char* end;
+	struct flub* flub;
+	struct iovec iovs[2];
+	ssize_t len;
+	uint32_t shortest;
+	uint64_t count;
+	uint64_t length;
+
+	// Read packet.
+	memset(frame, 0, sizeof(struct gls_frame));
+	if (gls_protocol_get(fd)) {
+		if ((flub = gls_compact_read(fd, &body, &end))) {
+			return flub_append(flub, "reading frame packet");
+		}
+		cur = gls_compact_get(body, end, &count);
+		cur = gls_compact_get(cur, end, &length);
+		if (cur != end || count > UINT32_MAX || length > UINT32_MAX) {
+			return g_flub_toss("Malformed frame packet");
+		}
+		frame->count = count;
+		frame->length = length;
+		shortest = 2;
+	} else {
+		len = 0;
+		iovs[0].iov_base = &frame->count;
+		len += iovs[0].iov_len = sizeof(uint32_t);
+		iovs[1].iov_base = &frame->length;
+		len += iovs[1].iov_len = sizeof(uint32_t);
+		if (gls_readvn(fd, iovs, sizeof(iovs) / sizeof(struct iovec)) <
+			len) {
+			return g_flub_toss("Unable to read frame packet: %s",
+				g_serr(errno));
+		}
+		frame->count = be32toh(frame->count);
+		frame->length = be32toh(frame->length);
+		shortest = sizeof(uint32_t);
+	}
+
+	// Validate packet.
 	if (!validate) {
 		return NULL;
-	}
-	for (i = 0; i < GLS_PROTOVER_REASON_LENGTH; i++) {
-		if (pack->reason[i] && (!isprint(pack->reason[i]))) {
-			return g_flub_toss("Invalid reason in protover ack");
-		}
+	} else if (frame->length > GLS_FRAME_LENGTH_MAX) {
+		return g_flub_toss("Frame length '%u' exceeds '%u'",
+			frame->length, GLS_FRAME_LENGTH_MAX);
+	} else if (!frame->count || frame->count > frame->length / shortest) {
+		return g_flub_toss("Invalid frame packet count '%u'",
+			frame->count);
 	}
 	return NULL;
 }
 
-struct flub* gls_protoverack_write(struct gls_protoverack* pack, int fd) {
+struct flub* gls_frame_write(struct gls_frame* frame, char* data, int fd) {
 	char* buf;
 	char* cur;
+	struct iovec iovs[2];
 	ssize_t len;
-	uint16_t tmp;
+	uint32_t tmp32;
 
 	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
+	if (!(cur = buf = pthread_getspecific(gls_key))) {
 		return g_flub_toss("Unable to get buffer");
 	}
 
-	// Prepare ack and reason.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_PROTOVERACK);
-	cur += 4;
-	len = 4;
-	tmp = htons(pack->ack);
-	memcpy(cur, &tmp, sizeof(uint16_t));
-	len += sizeof(uint16_t);
-	cur += sizeof(uint16_t);
-	memcpy(cur, pack->reason, GLS_PROTOVER_REASON_LENGTH);
-	len += GLS_PROTOVER_REASON_LENGTH;
-	cur += GLS_PROTOVER_REASON_LENGTH;
-	memcpy(cur, pack->pver.magic, GLS_PROTOVER_MAGIC_LENGTH);
-	len += GLS_PROTOVER_MAGIC_LENGTH;
-	cur += GLS_PROTOVER_MAGIC_LENGTH;
-	memcpy(cur, pack->pver.version, GLS_PROTOVER_VERSION_LENGTH);
-	len += GLS_PROTOVER_VERSION_LENGTH;
-	cur += GLS_PROTOVER_VERSION_LENGTH;
-	memcpy(cur, pack->pver.software, GLS_PROTOVER_SOFTWARE_LENGTH);
-	len += GLS_PROTOVER_SOFTWARE_LENGTH;
-
-	// Write packet.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write protoverack pt1: '%s'",
+	if (gls_protocol_get(fd)) {
+		// Encode compact frame.
+		cur = gls_compact_put(buf + GLS_COMPACT_HEADER_LENGTH,
+			frame->count);
+		cur = gls_compact_put(cur, frame->length);
+		iovs[0].iov_base = gls_compact_header(buf, GLS_EVENT_FRAME,
+			cur);
+		len = cur - (char*)iovs[0].iov_base;
+	} else {
+		// Marshal header.
+		gls_header_marshal(cur, GLS_EVENT_FRAME);
+		cur += len = 4;
+
+		// Prepare buffer.
+		tmp32 = htobe32(frame->count);
+		memcpy(cur, &tmp32, sizeof(uint32_t));
+		cur += sizeof(uint32_t);
+		len += sizeof(uint32_t);
+		tmp32 = htobe32(frame->length);
+		memcpy(cur, &tmp32, sizeof(uint32_t));
+		cur += sizeof(uint32_t);
+		len += sizeof(uint32_t);
+		iovs[0].iov_base = buf;
+	}
+
+	// Write frame along with its packets.
+	iovs[0].iov_len = len;
+	iovs[1].iov_base = data;
+	len += iovs[1].iov_len = frame->length;
+	if (gls_writevn(fd, iovs, 2) < len) {
+		return g_flub_toss("Unable to write frame: %s",
 			g_serr(errno));
 	}
 	return NULL;
 }
 
-ssize_t gls_readn(int fd, void* buffer, size_t count) {
-	return gls_rdwrn(fd, buffer, count, read);
+void gls_header_marshal(char* buffer, uint32_t event) {
+	uint32_t tmp;
+
+	// Write header data.
+	tmp = htonl(event);
+	memcpy(buffer, &tmp, sizeof(uint32_t));
 }
 
-ssize_t gls_readvn(int fd, struct iovec* iov, int iovcnt) {
-	return gls_rdwrvn(fd, iov, iovcnt, readv);
+struct flub* gls_header_read(struct gls_header* header, int fd) {
+	struct gls_descriptor* descriptor;
+
+	// Read compact header.
+	if ((descriptor = gls_descriptor_find(fd)) && descriptor->protocol) {
+		return gls_compact_header_read(header, fd, descriptor);
+	}
+
+	// Read header.
+	if (gls_readn(fd, &header->event, sizeof(uint32_t)) <
+		sizeof(uint32_t)) {
+		// Failed/partial read.
+		return g_flub_toss("Unable to read header: '%s'",
+			g_serr(errno));
+	}
+	header->event = ntohl(header->event);
+	header->length = gls_event_length(header->event);
+	header->size = sizeof(uint32_t);
+	return NULL;
 }
 
-struct flub* gls_say_message_validate(char* message) {
-	int i;
+struct flub* gls_init() {
+	char* buffer;
+	struct flub* flub;
+	static int key_created = 0;
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	int ret;
 
-	// Validate message.
-	for (i = 0; i < GLS_SAY_MESSAGE_LENGTH; i++) {
-		if (message[i] == '\0') {
-			break;
+	// Initialize key.
+	flub = NULL;
+	ret = pthread_mutex_lock(&mutex);
+	if (ret) {
+		return g_flub_toss("Unable to lock mutex: '%s'",
+			g_serr(ret));
+	}
+	if (!key_created) {
+		ret = pthread_key_create(&gls_key, gls_init_destructor);
+		if (ret) {
+			flub = g_flub_toss("Unable to create key: '%s'",
+				g_serr(ret));
+			goto unlock;
+		}
+		ret = pthread_key_create(&gls_descriptor_key,
+			gls_descriptor_destructor);
+		if (ret) {
+			flub = g_flub_toss("Unable to create descriptor key: "
+				"'%s'", g_serr(ret));
+			goto unlock;
 		}
-		if (!isprint(message[i])) {
-			return g_flub_toss("Invalid Say message character at "
-				"index '%i'", i);
+		key_created = 1;
+
+		// Validate strings with the widest vectors available.
+#ifdef __x86_64__
+		if (__builtin_cpu_supports("avx2")) {
+			gls_span = gls_span_avx2;
 		}
+#endif
 	}
-	if (i == GLS_SAY_MESSAGE_LENGTH) {
-		return g_flub_toss("Unterminated message");
-	} else if (!i) {
-		return g_flub_toss("Empty message");
+unlock:
+	ret = pthread_mutex_unlock(&mutex);
+	if (ret && flub) {
+		flub_append(flub, "Mutex unlock failed: '%s'",
+			g_serr(ret));
+	} else if (ret) {
+		flub = g_flub_toss("Mutex unlock failed: '%s'",
+			g_serr(ret));
+	}
+	if (flub) {
+		return flub;
+	}
+
+	// Initialize buffer.
+	buffer = (char*)malloc(GLS_BUFFER_SIZE);
+	if (!buffer) {
+		return g_flub_toss("Unable to allocate buffer");
+	}
+
+	// Set buffer.
+	ret = pthread_setspecific(gls_key, buffer);
+	if (ret) {
+		return g_flub_toss("Unable to set pthread buffer: '%s'",
+			g_serr(ret));
 	}
 	return NULL;
 }
 
-struct flub* gls_say1_read(struct gls_say1* say, int fd, int validate) {
-	struct flub* flub;
+void gls_init_destructor(void* buffer) {
+	free(buffer);
+}
 
-	// Read packet.
-	memset(say, 0, sizeof(struct gls_say1));
-	if (gls_readn(fd, say->message, GLS_SAY_MESSAGE_LENGTH) <
-		GLS_SAY_MESSAGE_LENGTH) {
-		return g_flub_toss("Unable to read Say1 packet: '%s'",
-			g_serr(errno));
+void gls_location_format(char* location, uint32_t row, uint32_t column) {
+	int i;
+	int j;
+	char letters[GLS_LOCATION_LENGTH];
+
+	// Convert the row to bijective base-26 letters, least significant
+	// letter first ("A" through "Z", then "AA" and so on).
+	i = 0;
+	row++;
+	do {
+		row--;
+		letters[i++] = 'A' + row % 26;
+		row /= 26;
+	} while (row);
+
+	// Write the row letters followed by the one-based column number.
+	for (j = 0; j < i; j++) {
+		location[j] = letters[i - j - 1];
 	}
+	snprintf(&location[j], GLS_LOCATION_LENGTH - j, "%u", column + 1);
+}
 
-	// Validate data.
-	if (!validate) {
+struct flub* gls_location_parse(char* location, uint32_t* row,
+	uint32_t* column) {
+	uint32_t c;
+	int i;
+	uint32_t r;
+	int start;
+
+	// Fast path for the single letter, single digit locations that make
+	// up the default board.
+	if (isupper(location[0]) && location[1] >= '1' && location[1] <= '9'
+		&& location[2] == '\0') {
+		(*row) = location[0] - 'A';
+		(*column) = location[1] - '1';
 		return NULL;
 	}
-	if ((flub = gls_say_message_validate(say->message))) {
-		return flub_append(flub, "reading say1 packet");
+
+	// Parse row letters.
+	r = 0;
+	for (i = 0; i < GLS_LOCATION_LENGTH && isupper(location[i]); i++) {
+		r = r * 26 + (location[i] - 'A' + 1);
+		if (r > GLS_BOARD_ROW_MAX) {
+			return g_flub_toss("Plate row specifier too large");
+		}
+	}
+	if (!i) {
+		return g_flub_toss("Invalid plate row specifier");
 	}
+
+	// Parse column digits.
+	c = 0;
+	start = i;
+	if (i < GLS_LOCATION_LENGTH && location[i] == '0') {
+		return g_flub_toss("Invalid plate column specifier");
+	}
+	for ( ; i < GLS_LOCATION_LENGTH && isdigit(location[i]); i++) {
+		c = c * 10 + (location[i] - '0');
+		if (c > GLS_BOARD_COLUMN_MAX) {
+			return g_flub_toss("Plate column specified too large");
+		}
+	}
+	if (i == start) {
+		return g_flub_toss("Invalid plate column specifier");
+	} else if (i == GLS_LOCATION_LENGTH || location[i] != '\0') {
+		return g_flub_toss("Expected null byte in loc specifier");
+	}
+	(*row) = r - 1;
+	(*column) = c - 1;
 	return NULL;
 }
 
-struct flub* gls_say1_write(struct gls_say1* say, int fd) {
-	char* buf;
-	char* cur;
-	size_t len;
+struct flub* gls_location_validate(char* location) {
+	uint32_t column;
+	uint32_t row;
 
-	// Get buffer.
-	if (!(buf = pthread_getspecific(gls_key))) {
-		return g_flub_toss("Unable to get buffer");
-	}
+	return gls_location_parse(location, &row, &column);
+}
+
+struct flub* gls_motd_validate(char* message) {
+	size_t i;
 
-	// Marshal header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_SAY1);
-	cur += len = 4;
+	i = gls_span(message, GLS_MOTD_LENGTH, GLS_SPAN_PRINT);
+	if (i == GLS_MOTD_LENGTH) {
+		return g_flub_toss("MotD too long");
+	} else if (message[i] != '\0') {
+		return g_flub_toss("Invalid MotD char at index '%i'", (int)i);
+	}
+	return NULL;
+}
 
-	// Prepare buffer.
-	strlcpy(cur, say->message, GLS_SAY_MESSAGE_LENGTH);
-	cur += GLS_SAY_MESSAGE_LENGTH;
-	len += GLS_SAY_MESSAGE_LENGTH;
+struct flub* gls_nick_validate(char* nick, int empty) {
+	size_t i;
 
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write Say1 packet");
+	// Validate nick characters.
+	i = gls_span(nick, GLS_NICK_LENGTH, GLS_SPAN_ALNUM);
+	if (i == GLS_NICK_LENGTH) {
+		return g_flub_toss("Nick exceeded '%i' characters",
+			GLS_NICK_LENGTH - 1);
+	} else if (nick[i] != '\0') {
+		return g_flub_toss("Invalid character in nick at index '%i'",
+			(int)i);
+	}
+	if (!empty && !i) {
+		return g_flub_toss("Empty nick");
 	}
 	return NULL;
 }
 
-struct flub* gls_say2_read(struct gls_say2* say, int fd, int validate) {
+struct flub* gls_packet_read(struct gls_packet* packet, int fd, int validate) {
 	struct flub* flub;
-	struct iovec iovs[3];
-	size_t len;
 
-	len = 0;
-	iovs[0].iov_base = &say->nick;
-	len += iovs[0].iov_len = GLS_NICK_LENGTH;
-	iovs[1].iov_base = &say->tval;
-	len += iovs[1].iov_len = sizeof(uint64_t);
-	iovs[2].iov_base = &say->message;
-	len += iovs[2].iov_len = GLS_SAY_MESSAGE_LENGTH;
-
-	// Read in data.
-	memset(say, 0, sizeof(struct gls_say2));
-	if (gls_readvn(fd, iovs, 3) < len) {
-		return g_flub_toss("Unable to read Say2 packet: '%s'",
-			g_serr(errno));
+	// Read in packet header.  The packet itself isn't cleared, as its
+	// reader sets every field.
+	flub = gls_header_read(&packet->header, fd);
+	if (flub) {
+		return flub;
 	}
-	say->tval = be64toh(say->tval);
 
-	// Validate data.
-	if (!validate) {
-		return NULL;
-	}
-	if ((flub = gls_nick_validate(say->nick, 0))) {
-		return flub_append(flub, "reading Say2 packet");
+	// Read in actual packet.
+	switch(packet->header.event) {
+#define GLS_PACKET(event, name) \
+	case GLS_EVENT_##event: \
+		flub = gls_##name##_read(&packet->data.name, fd, validate); \
+		break;
+#include "gls.def"
+	case GLS_EVENT_FRAME:
+		flub = gls_frame_read(&packet->data.frame, fd, validate);
+		break;
+	default:
+		// Skip packets of newer events when their length is given.
+		if (packet->header.length != GLS_LENGTH_UNKNOWN) {
+			flub = gls_packet_skip(&packet->header, fd);
+			break;
+		}
+		flub = g_flub_toss("Unknown packet type: '%u'",
+			packet->header.event);
+		break;
 	}
-	if ((flub = gls_say_message_validate(say->message))) {
-		return flub_append(flub, "reading Say2 packet");
+	if (flub) {
+		return flub;
 	}
 	return NULL;
 }
 
-struct flub* gls_say2_write(struct gls_say2* say, int fd) {
+struct flub* gls_packet_skip(struct gls_header* header, int fd) {
 	char* buf;
-	char* cur;
+	struct gls_descriptor* descriptor;
+	size_t left;
 	size_t len;
-	uint64_t time;
 
 	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+	if (header->length == GLS_LENGTH_UNKNOWN) {
+		return g_flub_toss("Unable to skip packet '%u' of unknown "
+			"length", header->event);
+	} else if (!(buf = pthread_getspecific(gls_key))) {
+		return g_flub_toss("Unable to get gls buffer");
 	}
-	cur = buf;
 
-	// Marshal header.
-	gls_header_marshal(cur, GLS_EVENT_SAY2);
-	cur += len = 4;
+	// Discard packet data.
+	if ((descriptor = gls_descriptor_find(fd))) {
+		descriptor->length = 0;
+	}
+	for (left = header->length; left; left -= len) {
+		len = left < GLS_BUFFER_SIZE ? left : GLS_BUFFER_SIZE;
+		if (gls_readn(fd, buf, len) < len) {
+			return g_flub_toss("Unable to skip packet '%u': '%s'",
+				header->event, g_serr(errno));
+		}
+	}
+	return NULL;
+}
 
-	// Prepare buffer.
-	strlcpy(cur, say->nick, GLS_NICK_LENGTH);
-	cur += GLS_NICK_LENGTH;
-	len += GLS_NICK_LENGTH;
-	time = htobe64(say->tval);
-	memcpy(cur, &time, sizeof(uint64_t));
-	cur += sizeof(uint64_t);
-	len += sizeof(uint64_t);
-	strlcpy(cur, say->message, GLS_SAY_MESSAGE_LENGTH);
-	len += GLS_SAY_MESSAGE_LENGTH;
+struct flub* gls_packet_write(struct gls_packet* packet, int fd) {
+	struct flub* flub;
 
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write Say2 packet");
+	// Write the packet.
+	switch(packet->header.event) {
+#define GLS_PACKET(event, name) \
+	case GLS_EVENT_##event: \
+		flub = gls_##name##_write(&packet->data.name, fd); \
+		break;
+#include "gls.def"
+	default:
+		flub = g_flub_toss("Unknown packet type: '%u'",
+			packet->header.event);
+		break;
+	}
+	if (flub) {
+		return flub;
 	}
 	return NULL;
 }
 
-struct flub* gls_shutdown_read(struct gls_shutdown* shutdown, int fd,
-	int validate) {
-	int i;
-	size_t len;
+size_t gls_pending(int fd) {
+	struct gls_descriptor* descriptor;
 
-	// Read in data.
-	memset(shutdown, 0, sizeof(struct gls_shutdown));
-	if (gls_readn(fd, &shutdown->reason, GLS_SHUTDOWN_REASON_LENGTH) <
-		GLS_SHUTDOWN_REASON_LENGTH) {
-		return g_flub_toss("Unable to read Shutdown packet: '%s'",
-			g_serr(errno));
+	// Count inflated bytes not yet read.
+	if (!(descriptor = gls_descriptor_find(fd)) || !descriptor->compress) {
+		return 0;
 	}
+	return descriptor->compress->plain_end -
+		descriptor->compress->plain_start;
+}
 
-	// Validate data.
-	if (!validate) {
-		return NULL;
-	}
-	shutdown->reason[GLS_SHUTDOWN_REASON_LENGTH - 1] = '\0';
-	if (!(len = strlen(shutdown->reason))) {
-		return NULL;
+uint32_t gls_protocol_get(int fd) {
+	struct gls_descriptor* descriptor;
+
+	// Get descriptor's protocol.
+	if (!(descriptor = gls_descriptor_find(fd))) {
+		return GLS_PROTOCOL_0;
 	}
-	for (i = 0; i < len; i++) {
-		if (!isprint(shutdown->reason[i])) {
-			return g_flub_toss("Invalid shutdown reason char at "
-				"'%i'", i);
+	return descriptor->protocol;
+}
+
+struct flub* gls_protocol_parse(char* version, uint32_t* protocol) {
+	uint32_t i;
+
+	// Find protocol speaking version.
+	for (i = 0; i <= GLS_PROTOCOL_MAX; i++) {
+		if (!strncmp(version, gls_protocol_versions[i],
+			GLS_PROTOVER_VERSION_LENGTH)) {
+			*protocol = i;
+			return NULL;
 		}
 	}
-	return NULL;
+	return g_flub_toss("Unsupported protocol version '%.*s'",
+		GLS_PROTOVER_VERSION_LENGTH, version);
 }
 
-struct flub* gls_shutdown_write(struct gls_shutdown* shutdown, int fd) {
-	char* buf;
-	char* cur;
-	int32_t len;
+struct flub* gls_protocol_set(int fd, uint32_t protocol, int level) {
+	struct gls_descriptor* descriptor;
+	struct flub* flub;
 
-	// Get buffer.
-	buf = pthread_getspecific(gls_key);
-	if (!buf) {
-		return g_flub_toss("Unable to get buffer");
+	// Set descriptor's protocol.
+	if (protocol > GLS_PROTOCOL_MAX) {
+		return g_flub_toss("Invalid protocol '%u'", protocol);
+	} else if ((flub = gls_descriptor_get(fd, &descriptor))) {
+		return flub_append(flub, "setting protocol");
 	}
+	descriptor->protocol = protocol;
+	descriptor->length = 0;
 
-	// Prepare header.
-	cur = buf;
-	gls_header_marshal(cur, GLS_EVENT_SHUTDOWN);
-	cur += len = sizeof(len);
+	// Start or stop stream compression.
+	if (protocol == GLS_PROTOCOL_2 && !descriptor->compress) {
+		if (!(descriptor->compress = gls_compress_open(level))) {
+			return g_flub_toss("Unable to start compression at "
+				"level '%i'", level);
+		}
+	} else if (protocol != GLS_PROTOCOL_2 && descriptor->compress) {
+		gls_compress_free(descriptor->compress);
+		descriptor->compress = NULL;
+	}
+	return NULL;
+}
 
-	// Prepare player part.
-	memcpy(cur, shutdown->reason, GLS_SHUTDOWN_REASON_LENGTH);
-	len += GLS_SHUTDOWN_REASON_LENGTH;
+ssize_t gls_readn(int fd, void* buffer, size_t count) {
+	struct gls_descriptor* descriptor;
+	struct iovec iov;
 
-	// Write data.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write shutdown: '%s'",
-			g_serr(errno));
+	// Read through the descriptor's inflate stream.
+	if ((descriptor = gls_descriptor_find(fd)) && descriptor->compress) {
+		iov.iov_base = buffer;
+		iov.iov_len = count;
+		return gls_compress_readv(descriptor->compress, fd, &iov, 1);
 	}
-	return NULL;
+	return gls_rdwrn(fd, buffer, count, read);
 }
 
-struct flub* gls_sync_end_read(struct gls_sync_end* sync_end, int fd,
-	int validate) {
-	struct flub* flub;
+ssize_t gls_readvn(int fd, struct iovec* iov, int iovcnt) {
+	struct gls_descriptor* descriptor;
 
-	// Read in packet.
-	memset(sync_end, 0, sizeof(struct gls_sync_end));
-	if (gls_readn(fd, sync_end->motd, GLS_MOTD_LENGTH) <
-		GLS_MOTD_LENGTH) {
-		return g_flub_toss("Unable to read sync_end packet: '%s'",
-			g_serr(errno));
+	// Read through the descriptor's inflate stream.
+	if ((descriptor = gls_descriptor_find(fd)) && descriptor->compress) {
+		return gls_compress_readv(descriptor->compress, fd, iov,
+			iovcnt);
 	}
+	return gls_rdwrvn(fd, iov, iovcnt, readv);
+}
 
-	// Validate data.
-	if (!validate) {
-		return NULL;
+struct flub* gls_say_message_validate(char* message) {
+	size_t i;
+
+	// Validate message.
+	i = gls_span(message, GLS_SAY_MESSAGE_LENGTH, GLS_SPAN_PRINT);
+	if (i < GLS_SAY_MESSAGE_LENGTH && message[i] != '\0') {
+		return g_flub_toss("Invalid Say message character at index "
+			"'%i'", (int)i);
 	}
-	if ((flub = gls_motd_validate(sync_end->motd))) {
-		return flub_append(flub, "validating sync_end packet");
+	if (i == GLS_SAY_MESSAGE_LENGTH) {
+		return g_flub_toss("Unterminated message");
+	} else if (!i) {
+		return g_flub_toss("Empty message");
 	}
 	return NULL;
 }
 
-struct flub* gls_sync_end_write(struct gls_sync_end* sync_end, int fd) {
-	char* buf;
-	char* cur;
-	ssize_t len;
+struct flub* gls_view_read(struct gls_view* view, int fd, int validate) {
+	struct flub* flub;
 
-	// Get buffer.
-	if (!(cur = buf = pthread_getspecific(gls_key))) {
-		return g_flub_toss("Unable to get gls buffer");
+	// Read in packet header.
+	if ((flub = gls_header_read(&view->header, fd))) {
+		return flub;
 	}
 
-	// Prepare buffer.
-	gls_header_marshal(cur, GLS_EVENT_SYNC_END);
-	cur += len = 4;
-	strlcpy(cur, sync_end->motd, GLS_MOTD_LENGTH);
-	cur += GLS_MOTD_LENGTH;
-	len += GLS_MOTD_LENGTH;
-
-	// Write buffer.
-	if (gls_writen(fd, buf, len) < len) {
-		return g_flub_toss("Unable to write sync_end packet");
+	// Read the packet's body in place.
+	switch(view->header.event) {
+#define GLS_PACKET(event, name) \
+	case GLS_EVENT_##event: \
+		return gls_##name##_wire_read(&view->data.name, fd, validate);
+#include "gls.def"
+	case GLS_EVENT_FRAME:
+		return gls_frame_read(&view->data.frame, fd, validate);
+	default:
+		return g_flub_toss("Unknown packet type: '%u'",
+			view->header.event);
 	}
-	return NULL;
 }
 
 ssize_t gls_writen(int fd, void* buffer, size_t count) {
-	return gls_rdwrn(fd, buffer, count,
-		(ssize_t(*)(int, void*, size_t))write);
+	struct gls_batch* batch;
+
+	// Hold packets written to batched descriptors.
+	if ((batch = gls_batch_get(fd))) {
+		return gls_batch_append(batch, fd, buffer, count);
+	}
+	return gls_send(fd, buffer, count);
 }
 
 ssize_t gls_writevn(int fd, struct iovec* iov, int iovcnt) {
+	struct gls_descriptor* descriptor;
+
+	// Write through the descriptor's deflate stream.
+	if ((descriptor = gls_descriptor_find(fd)) && descriptor->compress) {
+		return gls_compress_writev(descriptor->compress, fd, iov,
+			iovcnt);
+	}
 	return gls_rdwrvn(fd, iov, iovcnt, writev);
 }
+
+// Packet decoders, readers and writers, generated from 'gls.def'.
+#define GLS_PACKET(event, name) \
+void gls_##name##_decode(struct gls_##name* packet, \
+	struct gls_##name##_wire* wire) {
+#define GLS_U16(field) packet->field = gls_be16_get(&wire->field);
+#define GLS_U32(field) packet->field = gls_be32_get(&wire->field);
+#define GLS_U64(field) packet->field = gls_be64_get(&wire->field);
+#define GLS_STR(field, length) memcpy(packet->field, wire->field, length);
+#define GLS_STRZ(field, length) GLS_STR(field, length)
+#define GLS_LOC(field) GLS_STR(field, GLS_LOCATION_LENGTH)
+#define GLS_NEST(field, name) gls_##name##_decode(&packet->field, &wire->field);
+#define GLS_END(name) }
+#include "gls.def"
+
+// Read the wire packet into the thread's buffer and decode it.
+#define GLS_PACKET(event, name) \
+struct flub* gls_##name##_read(struct gls_##name* packet, int fd, \
+	int validate) { \
+	struct flub* flub; \
+	struct gls_##name##_wire* wire; \
+	if (!(wire = pthread_getspecific(gls_key))) { \
+		return g_flub_toss("Unable to get gls buffer"); \
+	} \
+	if ((flub = gls_##name##_wire_read(wire, fd, validate))) { \
+		return flub; \
+	} \
+	gls_##name##_decode(packet, wire); \
+	return NULL; \
+}
+#include "gls.def"
+
+// Encode the packet after its header in the thread's buffer and write both
+// with one call.  Compact packets are encoded first and their header placed
+// before them.
+#define GLS_PACKET(event, name) \
+struct flub* gls_##name##_write(struct gls_##name* packet, int fd) { \
+	char* buf; \
+	ssize_t len; \
+	if (!(buf = pthread_getspecific(gls_key))) { \
+		return g_flub_toss("Unable to get gls buffer"); \
+	} else if (gls_protocol_get(fd)) { \
+		return gls_compact_write(fd, GLS_EVENT_##event, buf, \
+			gls_##name##_compact(buf + GLS_COMPACT_HEADER_LENGTH, \
+			packet)); \
+	} \
+	gls_header_marshal(buf, GLS_EVENT_##event); \
+	gls_##name##_encode((struct gls_##name##_wire*)(buf + \
+		sizeof(uint32_t)), packet); \
+	len = sizeof(uint32_t) + sizeof(struct gls_##name##_wire); \
+	if (gls_writen(fd, buf, len) < len) { \
+		return g_flub_toss("Unable to write " #name " packet: '%s'", \
+			g_serr(errno)); \
+	} \
+	return NULL; \
+}
+#include "gls.def"
@@ -26,8 +26,14 @@
 #include <ctype.h>
 #include <endian.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
+#include <zlib.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
 
 #include "global.h"
 
@@ -38,11 +44,31 @@
 // Lower-limit on pipe atomicity.
 #define GLS_PIPE_BUF 4096
 
-// Board dimensions.
+// Wire protocols, selected by the Protover exchange.  Protocol 0 sends
+// fixed-size packets; protocol 1 sends compact, length-prefixed packets;
+// protocol 2 sends protocol 1 packets through a deflate stream.
+#define GLS_PROTOCOL_0 0
+#define GLS_PROTOCOL_1 1
+#define GLS_PROTOCOL_2 2
+#define GLS_PROTOCOL_MAX GLS_PROTOCOL_2
+extern const char* gls_protocol_versions[];
+// Largest body of a compact packet.
+#define GLS_COMPACT_LENGTH_MAX 4096
+// Most bytes taken by a varint.
+#define GLS_VARINT_LENGTH_MAX 10
+// Data length of a protocol 0 packet with an unknown event.
+#define GLS_LENGTH_UNKNOWN UINT32_MAX
+// Largest compressed record, and the most it may inflate to.
+#define GLS_COMPRESS_RECORD_MAX 131072
+
+// Board dimensions.  The row and column counts are the defaults; boards may
+// be configured anywhere up to the maximums.
 #define GLS_BOARD_ROW_COUNT 8
 #define GLS_BOARD_COLUMN_COUNT 8
-// Board locations.
-#define GLS_LOCATION_LENGTH 3
+#define GLS_BOARD_ROW_MAX 256
+#define GLS_BOARD_COLUMN_MAX 256
+// Board locations; row letters followed by a column number (e.g. "IV256").
+#define GLS_LOCATION_LENGTH 8
 
 // Transparency colors.
 #define GLS_COLOR_NULL		0  // a.k.a. "no color"
@@ -56,8 +82,10 @@
 #define GLS_COLOR_MIN		GLS_COLOR_RED
 extern const char* gls_color_names[];
 
-// Die definitions.
-#define GLS_DIE_MAX		25
+// Die definitions.  The count is the default number of dice on a board, the
+// maximum is the most any board may have.
+#define GLS_DIE_COUNT		25
+#define GLS_DIE_MAX		4096
 
 
 /**
@@ -66,6 +94,11 @@ extern const char* gls_color_names[];
 struct gls_header {
 	// Event type.
 	uint32_t event;
+	// Length of the data following the header, as given by the header or
+	// known for the event; GLS_LENGTH_UNKNOWN otherwise.  Not written.
+	uint32_t length;
+	// Bytes the header took up when read.  Not written.
+	uint32_t size;
 };
 
 /**
@@ -95,6 +128,88 @@ struct gls_nick_set {
 	char reason[GLS_NICK_SET_REASON];
 };
 
+/**
+ * Dimensions of the game board.
+ */
+struct gls_board_size {
+	// Number of rows.
+	uint32_t rows;
+	// Number of columns.
+	uint32_t columns;
+	// Number of dice.
+	uint32_t dice;
+};
+
+/**
+ * Two dice have been connected.
+ */
+struct gls_connect {
+	// Die numbers of the connected dice.
+	uint32_t from;
+	uint32_t to;
+	// Nick of player who made the connection.
+	char nick[GLS_NICK_LENGTH];
+};
+
+/**
+ * Server rejects a connection.
+ */
+#define GLS_CONNECT_REJECT_REASON_LENGTH 64
+struct gls_connect_reject {
+	// Die numbers of the attempted connection.
+	uint32_t from;
+	uint32_t to;
+	// Reason for rejection.
+	char reason[GLS_CONNECT_REJECT_REASON_LENGTH];
+};
+
+/**
+ * Client tries to connect two dice.
+ */
+struct gls_connect_try {
+	// Die numbers to connect.
+	uint32_t from;
+	uint32_t to;
+};
+
+/**
+ * State of the board at a version of its history.
+ */
+#define GLS_HISTORY_LATEST 0xFFFFFFFF
+struct gls_history {
+	// Version described.
+	uint32_t version;
+	// Number of versions in the board's history.
+	uint32_t versions;
+	// Number of Die Place packets that follow.
+	uint32_t dice;
+	// Number of Connect packets that follow the Die Place packets.
+	uint32_t connections;
+	// Time the version was created, in seconds since the epoch.
+	uint64_t tval;
+};
+
+/**
+ * Client requests a version of the board's history.
+ */
+struct gls_history_req {
+	// Version requested, or 'GLS_HISTORY_LATEST'.
+	uint32_t version;
+};
+
+/**
+ * Run of packets sent together.  The frame is followed by 'length' bytes
+ * holding 'count' complete packets, which are handled as if each were sent on
+ * its own.
+ */
+#define GLS_FRAME_LENGTH_MAX 65536
+struct gls_frame {
+	// Number of packets in the frame.
+	uint32_t count;
+	// Number of bytes in the frame's packets.
+	uint32_t length;
+};
+
 /**
  * Die has been placed on the board.
  */
@@ -139,6 +254,9 @@ struct gls_die_place_try {
 #define GLS_PLATE_DESCRIPTION_LENGTH 256
 #define GLS_PLATE_NAME_LENGTH 64
 #define GLS_PLATE_FLAG_EMPTY 					0x00000001
+// Name and description left out; ask for them with a plate detail request.
+#define GLS_PLATE_FLAG_BRIEF 					0x00000002
+#define GLS_PLATE_FLAGS (GLS_PLATE_FLAG_EMPTY | GLS_PLATE_FLAG_BRIEF)
 struct gls_plate_place {
 	char abbrev[GLS_PLATE_ABBREV_LENGTH];
 	char description[GLS_PLATE_DESCRIPTION_LENGTH];
@@ -147,6 +265,34 @@ struct gls_plate_place {
 	uint32_t flags;
 };
 
+/**
+ * Client asks for the name and description of a plate.
+ */
+struct gls_plate_detail_req {
+	char loc[GLS_LOCATION_LENGTH];
+};
+
+/**
+ * Full plate in reply to a plate detail request.
+ */
+struct gls_plate_detail {
+	struct gls_plate_place plate;
+};
+
+/**
+ * Plates of the board being synchronized, identified by their hash.
+ */
+#define GLS_PLATE_SET_FLAG_CACHED 0x00000001
+#define GLS_PLATE_SET_FLAGS GLS_PLATE_SET_FLAG_CACHED
+struct gls_plate_set {
+	// Hash of the board's plates and their locations, never zero.
+	uint64_t hash;
+	// Number of plates on the board.
+	uint32_t plates;
+	// The client holds these plates, so no Plate Place packets follow.
+	uint32_t flags;
+};
+
 /**
  * Player joins game.
  */
@@ -197,6 +343,20 @@ struct gls_say2 {
 	char message[GLS_SAY_MESSAGE_LENGTH];
 };
 
+/**
+ * Player's score has changed.
+ */
+struct gls_score {
+	// Player whose score changed.
+	char nick[GLS_NICK_LENGTH];
+	// Player's total points.
+	uint32_t points;
+	// Color whose score changed, or 'GLS_COLOR_NULL' for none.
+	uint32_t color;
+	// Color's total points.
+	uint32_t color_points;
+};
+
 /**
  * Server shutdown packet.
  */
@@ -205,6 +365,21 @@ struct gls_shutdown {
 	char reason[GLS_SHUTDOWN_REASON_LENGTH];
 };
 
+/**
+ * Client chooses the plates whose die placements it receives.
+ */
+#define GLS_SUBSCRIBE_FLAG_ALL 0x00000001
+#define GLS_SUBSCRIBE_FLAG_ADD 0x00000002
+#define GLS_SUBSCRIBE_FLAGS (GLS_SUBSCRIBE_FLAG_ALL | GLS_SUBSCRIBE_FLAG_ADD)
+struct gls_subscribe {
+	// Subscribe to the whole board, or add the region to the current one
+	// rather than replacing it.
+	uint32_t flags;
+	// Opposite corners of the region, ignored for the whole board.
+	char from[GLS_LOCATION_LENGTH];
+	char to[GLS_LOCATION_LENGTH];
+};
+
 /**
  * Player synchronization finished packet.
  */
@@ -213,6 +388,18 @@ struct gls_sync_end {
 	char motd[GLS_MOTD_LENGTH];
 };
 
+/**
+ * Client asks for its synchronization to skip what it holds already.
+ */
+#define GLS_SYNC_REQ_FLAG_BRIEF 0x00000001
+#define GLS_SYNC_REQ_FLAGS GLS_SYNC_REQ_FLAG_BRIEF
+struct gls_sync_req {
+	// Hash of the plates the client has cached, or zero.
+	uint64_t plates;
+	// Brief plates leave out their names and descriptions.
+	uint32_t flags;
+};
+
 // Packet headers.
 #define GLS_EVENT_PROTOVER		0x00000001
 #define GLS_EVENT_PROTOVERACK		0x00000002
@@ -229,11 +416,30 @@ struct gls_sync_end {
 #define GLS_EVENT_DIE_PLACE_TRY		0x0000000D
 #define GLS_EVENT_DIE_PLACE_REJECT	0x0000000E
 #define GLS_EVENT_DIE_PLACE		0x0000000F
+#define GLS_EVENT_BOARD_SIZE		0x00000010
+#define GLS_EVENT_HISTORY_REQ		0x00000011
+#define GLS_EVENT_HISTORY		0x00000012
+#define GLS_EVENT_CONNECT_TRY		0x00000013
+#define GLS_EVENT_CONNECT		0x00000014
+#define GLS_EVENT_CONNECT_REJECT	0x00000015
+#define GLS_EVENT_SCORE			0x00000016
+#define GLS_EVENT_SUBSCRIBE		0x00000017
+#define GLS_EVENT_FRAME			0x00000018
+#define GLS_EVENT_SYNC_REQ		0x00000019
+#define GLS_EVENT_PLATE_SET		0x0000001A
+#define GLS_EVENT_PLATE_DETAIL_REQ	0x0000001B
+#define GLS_EVENT_PLATE_DETAIL		0x0000001C
 
 // Union of all packets.
 struct gls_packet {
 	struct gls_header header;
 	union {
+		struct gls_board_size board_size;
+		struct gls_connect connect;
+		struct gls_connect_reject connect_reject;
+		struct gls_connect_try connect_try;
+		struct gls_history history;
+		struct gls_history_req history_req;
 		struct gls_nick_req nick_req;
 		struct gls_nick_set nick_set;
 		struct gls_protover protover;
@@ -244,245 +450,330 @@ struct gls_packet {
 		struct gls_shutdown shutdown;
 		struct gls_say1 say1;
 		struct gls_say2 say2;
+		struct gls_score score;
+		struct gls_subscribe subscribe;
 		struct gls_sync_end sync_end;
+		struct gls_sync_req sync_req;
 		struct gls_plate_place plate_place;
+		struct gls_plate_set plate_set;
+		struct gls_plate_detail_req plate_detail_req;
+		struct gls_plate_detail plate_detail;
 		struct gls_die_place_try die_place_try;
 		struct gls_die_place_reject die_place_reject;
 		struct gls_die_place die_place;
+		struct gls_frame frame;
 	} data;
 };
 
 /**
- * Reads the specified Die Place packet from the specified file descriptor.
+ * Big-endian integers as sent on the wire, without alignment.
  */
-struct flub* gls_die_place_read(struct gls_die_place* die, int fd,
-	int validate);
+struct gls_be16 {
+	unsigned char bytes[2];
+};
+struct gls_be32 {
+	unsigned char bytes[4];
+};
+struct gls_be64 {
+	unsigned char bytes[8];
+};
 
 /**
- * Writes the specified Die Place packet to the specified file descriptor.
+ * Packets as sent on the wire, one 'struct gls_<name>_wire' for each packet
+ * in 'gls.def'.  Strings can be used in place; integers are read with
+ * 'gls_be*_get'.
  */
-struct flub* gls_die_place_write(struct gls_die_place* die, int fd);
+#define GLS_PACKET(event, name) struct gls_##name##_wire {
+#define GLS_U16(field) struct gls_be16 field;
+#define GLS_U32(field) struct gls_be32 field;
+#define GLS_U64(field) struct gls_be64 field;
+#define GLS_STR(field, length) char field[length];
+#define GLS_STRZ(field, length) char field[length];
+#define GLS_LOC(field) char field[GLS_LOCATION_LENGTH];
+#define GLS_NEST(field, name) struct gls_##name##_wire field;
+#define GLS_END(name) };
+#include "gls.def"
 
 /**
- * Reads the specified Die Place Reject packet from the specified file
- * descriptor.
+ * Packet read in place.  The packet's body is left as sent in the view's
+ * wire structure for that event, which handlers use directly instead of
+ * copying each field out.  A frame is decoded, since its packets follow it.
  */
-struct flub* gls_die_place_reject_read(struct gls_die_place_reject* die, int fd,
-	int validate);
+struct gls_view {
+	struct gls_header header;
+	union {
+#define GLS_PACKET(event, name) struct gls_##name##_wire name;
+#include "gls.def"
+		struct gls_frame frame;
+	} data;
+};
 
 /**
- * Writes the specified Die Place Reject packet to the specified file
- * descriptor.
+ * Returns the value of the specified wire integer.
  */
-struct flub* gls_die_place_reject_write(struct gls_die_place_reject* die,
-	int fd);
+static inline uint16_t gls_be16_get(struct gls_be16* be) {
+	uint16_t value;
 
-/**
- * Reads the specified Die Place Try packet from the specified file descriptor.
- */
-struct flub* gls_die_place_try_read(struct gls_die_place_try* die, int fd,
-	int validate);
+	memcpy(&value, be->bytes, sizeof(uint16_t));
+	return be16toh(value);
+}
 
-/**
- * Writes the specified Die Place Try packet to the specified file descriptor.
- */
-struct flub* gls_die_place_try_write(struct gls_die_place_try* die, int fd);
+static inline uint32_t gls_be32_get(struct gls_be32* be) {
+	uint32_t value;
 
-/**
- * Marshalls the speccified gls header data into the specified buffer.
- */
-void gls_header_marshal(char* buffer, uint32_t event);
+	memcpy(&value, be->bytes, sizeof(uint32_t));
+	return be32toh(value);
+}
 
-/**
- * Reads gls protocol data from the specified file descriptor.
- */
-struct flub* gls_header_read(struct gls_header* header, int fd);
+static inline uint64_t gls_be64_get(struct gls_be64* be) {
+	uint64_t value;
+
+	memcpy(&value, be->bytes, sizeof(uint64_t));
+	return be64toh(value);
+}
 
 /**
- * Initialize the buffer for the gls protocol.
+ * Sets the specified wire integer to the specified value.
  */
-struct flub* gls_init();
+static inline void gls_be16_set(struct gls_be16* be, uint16_t value) {
+	value = htobe16(value);
+	memcpy(be->bytes, &value, sizeof(uint16_t));
+}
+
+static inline void gls_be32_set(struct gls_be32* be, uint32_t value) {
+	value = htobe32(value);
+	memcpy(be->bytes, &value, sizeof(uint32_t));
+}
+
+static inline void gls_be64_set(struct gls_be64* be, uint64_t value) {
+	value = htobe64(value);
+	memcpy(be->bytes, &value, sizeof(uint64_t));
+}
 
 /**
- * Destructor function for the pthread-specific gls buffer.
+ * Packets held back for a batched file descriptor.
  */
-void gls_init_destructor(void* buffer);
+struct gls_batch {
+	// Marshaled packets.
+	char* data;
+	size_t length;
+	size_t size;
+	// Number of packets held.
+	uint32_t count;
+	// Descriptor is batched.
+	unsigned open:1;
+};
 
 /**
- * Return a flub if the specified location isn't valid.
+ * Stream compression counters of one direction of a file descriptor.
  */
-struct flub* gls_location_validate(char* location);
+struct gls_compress_stats {
+	// Bytes before compression.
+	uint64_t plain;
+	// Bytes on the wire.
+	uint64_t compressed;
+	// Thread CPU time spent compressing or decompressing.
+	uint64_t nanoseconds;
+};
 
 /**
- * Validate a MotD.
+ * Decoder, reader and writer of each packet in 'gls.def'.  'gls_<name>_decode'
+ * decodes the specified wire packet into 'packet'.  'gls_<name>_read' reads
+ * the specified packet, less its header, from the specified file descriptor
+ * and validates it if 'validate' is set.  'gls_<name>_write' writes the
+ * specified packet, header included, to the specified file descriptor.
  */
-struct flub* gls_motd_validate(char* message);
+#define GLS_PACKET(event, name) \
+	void gls_##name##_decode(struct gls_##name* packet, \
+		struct gls_##name##_wire* wire); \
+	struct flub* gls_##name##_read(struct gls_##name* packet, int fd, \
+		int validate); \
+	struct flub* gls_##name##_write(struct gls_##name* packet, int fd);
+#include "gls.def"
 
 /**
- * Read the nick change notification from the specified file descriptor.
+ * Stops batching packets written by the calling thread to the specified file
+ * descriptor, discarding any not yet flushed.  Does nothing if the descriptor
+ * isn't batched.
  */
-struct flub* gls_nick_change_read(struct gls_nick_change* change, int fd,
-	int validate);
+void gls_batch_close(int fd);
+
 
 /**
- * Write the nick change notification to the specified file descriptor.
+ * Writes the packets held for the specified file descriptor as a single Frame
+ * packet, or as-is if only one packet is held.
  */
-struct flub* gls_nick_change_write(struct gls_nick_change* change, int fd);
+struct flub* gls_batch_flush(int fd);
 
 /**
- * Read the nick request from the specified file descriptor.
+ * Returns the number of bytes held for the specified file descriptor.
  */
-struct flub* gls_nick_req_read(struct gls_nick_req* req, int fd, int validate);
+size_t gls_batch_length(int fd);
 
 /**
- * Write the nick request to the specified file descriptor.
+ * Starts batching packets written by the calling thread to the specified file
+ * descriptor.  Until the batch is flushed, packets written to the descriptor
+ * are held in memory rather than written; a batch about to grow past the
+ * largest frame is flushed first.
  */
-struct flub* gls_nick_req_write(struct gls_nick_req* req, int fd);
+struct flub* gls_batch_open(int fd);
 
 /**
- * Read the nick set from the specified file descriptor.
+ * Copies the calling thread's stream compression counters for the specified
+ * file descriptor, or zeroes them if it isn't compressed.
  */
-struct flub* gls_nick_set_read(struct gls_nick_set* set, int fd,
-	int validate);
+void gls_compress_stats(int fd, struct gls_compress_stats* sent,
+	struct gls_compress_stats* received);
 
 /**
- * Write the nick set to the specified file descriptor.
+ * Return a flub if the specified die numbers aren't a valid connection.
  */
-struct flub* gls_nick_set_write(struct gls_nick_set* set, int fd);
+struct flub* gls_connect_validate(uint32_t from, uint32_t to);
 
 /**
- * Return a flub if the specified nickname is not valid, NULL otherwise.  A
- * nonzero value in the 'empty' parameter specifies that the nick may be empty.
+ * Destructor function for the pthread-specific descriptor state.
  */
-struct flub* gls_nick_validate(char* nick, int empty);
+void gls_descriptor_destructor(void* descriptors);
 
 /**
- * Reads an arbitrary packet from the specified file descriptor.
+ * Returns the protocol 0 data length of packets of the specified event, or
+ * GLS_LENGTH_UNKNOWN if the event isn't known.  A frame's length doesn't
+ * include its packets.
  */
-struct flub* gls_packet_read(struct gls_packet* packet, int fd, int validate);
+uint32_t gls_event_length(uint32_t event);
 
 /**
- * Writes the specified packet to the specified file descriptor.
+ * Reads the specified Frame packet from the specified file descriptor, leaving
+ * the frame's packets to be read.
  */
-struct flub* gls_packet_write(struct gls_packet* packet, int fd);
+struct flub* gls_frame_read(struct gls_frame* frame, int fd, int validate);
 
 /**
- * Read the specified plate placement from the specified file descriptor.
+ * Writes the specified Frame packet followed by the frame's packets from
+ * 'data' to the specified file descriptor.
  */
-struct flub* gls_plate_place_read(struct gls_plate_place* plate, int fd,
-	int validate);
+struct flub* gls_frame_write(struct gls_frame* frame, char* data, int fd);
 
 /**
- * Write the specified plate placement to the specified file descriptor.
+ * Marshalls the speccified gls header data into the specified buffer.
  */
-struct flub* gls_plate_place_write(struct gls_plate_place* plate, int fd);
+void gls_header_marshal(char* buffer, uint32_t event);
 
 /**
- * Read the specified Player Join packet from the specified file descriptor.
+ * Reads gls protocol data from the specified file descriptor, along with the
+ * length of the packet data following it.
  */
-struct flub* gls_player_join_read(struct gls_player_join* join, int fd,
-	int validate);
+struct flub* gls_header_read(struct gls_header* header, int fd);
 
 /**
- * Write the specified Player Join packet to the specified file descriptor.
+ * Initialize the buffer for the gls protocol.
  */
-struct flub* gls_player_join_write(struct gls_player_join* join, int fd);
+struct flub* gls_init();
 
 /**
- * Read the specified Player Part packet from the specified file descriptor.
+ * Destructor function for the pthread-specific gls buffer.
  */
-struct flub* gls_player_part_read(struct gls_player_part* part, int fd,
-	int validate);
+void gls_init_destructor(void* buffer);
 
 /**
- * Write the specified Player Part packet to the specified file descriptor.
+ * Writes the location string for the specified zero-based row and column into
+ * 'location', which must hold at least GLS_LOCATION_LENGTH bytes.
  */
-struct flub* gls_player_part_write(struct gls_player_part* part, int fd);
+void gls_location_format(char* location, uint32_t row, uint32_t column);
 
 /**
- * Read the protocol version information from the specified file descriptor.
+ * Parses the specified location into its zero-based row and column.  Returns
+ * a flub if the location isn't valid for a board of maximum size.
  */
-struct flub* gls_protover_read(struct gls_protover* pver, int fd,
-	int validate);
+struct flub* gls_location_parse(char* location, uint32_t* row,
+	uint32_t* column);
 
 /**
- * Write the protocol version information to the specified file descriptor.
+ * Return a flub if the specified location isn't valid.
  */
-struct flub* gls_protover_write(struct gls_protover* pver, int fd);
+struct flub* gls_location_validate(char* location);
 
 /**
- * Read the protocol version information ackowledgement from the specified
- * file descriptor.
+ * Validate a MotD.
  */
-struct flub* gls_protoverack_read(struct gls_protoverack* pack, int fd,
-	int validate);
+struct flub* gls_motd_validate(char* message);
 
 /**
- * Write the protocol version information acknowledgement to the specified
- * file descriptor.
+ * Return a flub if the specified nickname is not valid, NULL otherwise.  A
+ * nonzero value in the 'empty' parameter specifies that the nick may be empty.
  */
-struct flub* gls_protoverack_write(struct gls_protoverack* pack, int fd);
+struct flub* gls_nick_validate(char* nick, int empty);
 
 /**
- * Re-attempts partial reads.
- *
- * Returns the number of bytes read, or -1 on error.
+ * Reads an arbitrary packet from the specified file descriptor.  A packet of
+ * an unknown event is skipped if its header gives its length, leaving only
+ * its header; callers may check for it with 'gls_event_length'.
  */
-ssize_t gls_readn(int fd, void* buffer, size_t count);
+struct flub* gls_packet_read(struct gls_packet* packet, int fd, int validate);
 
 /**
- * Re-attempts partial reads.
- *
- * Returns the number of bytes read, or -1 on error.
+ * Discards the data of the packet whose header was just read from the
+ * specified file descriptor.
  */
-ssize_t gls_readvn(int fd, struct iovec* iov, int iovcnt);
+struct flub* gls_packet_skip(struct gls_header* header, int fd);
 
 /**
- * Validate say message.
+ * Writes the specified packet to the specified file descriptor.  Frames are
+ * written with 'gls_frame_write' instead, as they carry their packets.
  */
-struct flub* gls_say_message_validate(char* message);
+struct flub* gls_packet_write(struct gls_packet* packet, int fd);
 
 /**
- * Read the specified Say1 packet from the specified file descriptor.
+ * Returns the number of bytes already received on the specified file
+ * descriptor and waiting to be read, which polling the descriptor won't
+ * report.  Only compressed descriptors hold any.
  */
-struct flub* gls_say1_read(struct gls_say1* say, int fd, int validate);
+size_t gls_pending(int fd);
 
 /**
- * Write the specified Say1 packet to the specified file descriptor.
+ * Returns the protocol the calling thread speaks on the specified file
+ * descriptor.  Descriptors speak protocol 0 until set otherwise.
  */
-struct flub* gls_say1_write(struct gls_say1* say, int fd);
+uint32_t gls_protocol_get(int fd);
 
 /**
- * Read the specified Say2 packet from the specified file descriptor.
+ * Parses the specified Protover version into its protocol.  Returns a flub if
+ * the version isn't supported.
  */
-struct flub* gls_say2_read(struct gls_say2* say, int fd, int validate);
+struct flub* gls_protocol_parse(char* version, uint32_t* protocol);
 
 /**
- * Write the specified Say2 packet to the specified file descriptor.
+ * Sets the protocol the calling thread speaks on the specified file
+ * descriptor, for both reading and writing.  Protocols compressing their
+ * stream deflate it at the specified zlib level.
  */
-struct flub* gls_say2_write(struct gls_say2* say, int fd);
+struct flub* gls_protocol_set(int fd, uint32_t protocol, int level);
 
 /**
- * Read the specified Shutdown packet from the specified file descriptor.
+ * Re-attempts partial reads.
+ *
+ * Returns the number of bytes read, or -1 on error.
  */
-struct flub* gls_shutdown_read(struct gls_shutdown* shutdown, int fd,
-	int validate);
+ssize_t gls_readn(int fd, void* buffer, size_t count);
 
 /**
- * Write the specified Shutdown packet to the specified file descriptor.
+ * Re-attempts partial reads.
+ *
+ * Returns the number of bytes read, or -1 on error.
  */
-struct flub* gls_shutdown_write(struct gls_shutdown* shutdown, int fd);
+ssize_t gls_readvn(int fd, struct iovec* iov, int iovcnt);
 
 /**
- * Read the specified sync end event from the specified file descriptor.
+ * Validate say message.
  */
-struct flub* gls_sync_end_read(struct gls_sync_end* sync_end, int fd,
-	int validate);
+struct flub* gls_say_message_validate(char* message);
 
 /**
- * Write the specified sync end event to the specified file descriptor.
+ * Reads an arbitrary packet from the specified file descriptor into the
+ * specified view, validating it in place if 'validate' is set.  A frame's
+ * packets are left to be read after it.
  */
-struct flub* gls_sync_end_write(struct gls_sync_end* sync_end, int fd);
+struct flub* gls_view_read(struct gls_view* view, int fd, int validate);
 
 /**
  * Re-attempts partial writes.
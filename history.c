@@ -0,0 +1,94 @@
+/**
+ *  See 'history.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "history.h"
+
+static struct flub* history_append(struct history* history, uint32_t dice,
+	uint32_t connections, uint64_t tval);
+
+void history_free(struct history* history) {
+	free(history->versions);
+	memset(history, 0, sizeof(struct history));
+}
+
+struct history_version* history_get(struct history* history,
+	uint32_t version) {
+	if (version >= history->version_count) {
+		return NULL;
+	}
+	return &history->versions[version];
+}
+
+struct flub* history_init(struct history* history, struct board* board) {
+	struct flub* flub;
+	uint32_t i;
+
+	// Add a version for the empty board, each placed die, and each
+	// connection.  Times and the interleaving of recovered placements and
+	// connections are unknown.
+	memset(history, 0, sizeof(struct history));
+	history->board = board;
+	for (i = 0; i <= board->die_placed; i++) {
+		if ((flub = history_append(history, i, 0, 0))) {
+			history_free(history);
+			return flub;
+		}
+	}
+	for (i = 1; i <= board->connection_count; i++) {
+		if ((flub = history_append(history, board->die_placed, i,
+			0))) {
+			history_free(history);
+			return flub;
+		}
+	}
+	return NULL;
+}
+
+struct flub* history_push(struct history* history) {
+	return history_append(history, history->board->die_placed,
+		history->board->connection_count, (uint64_t)time(NULL));
+}
+
+/**
+ * Appends a version with the specified number of dice and connections and
+ * the specified time.
+ */
+static struct flub* history_append(struct history* history, uint32_t dice,
+	uint32_t connections, uint64_t tval) {
+	// Grow versions.
+	if (history->version_count == history->version_size) {
+		struct history_version* versions;
+		uint32_t size;
+
+		size = history->version_size ? history->version_size * 2 : 64;
+		versions = realloc(history->versions,
+			size * sizeof(struct history_version));
+		if (!versions) {
+			return g_flub_toss("Unable to allocate history");
+		}
+		history->versions = versions;
+		history->version_size = size;
+	}
+
+	// Add version.
+	history->versions[history->version_count].dice = dice;
+	history->versions[history->version_count].connections = connections;
+	history->versions[history->version_count].tval = tval;
+	history->version_count++;
+	return NULL;
+}
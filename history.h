@@ -0,0 +1,84 @@
+/**
+ *  Versioned history of a game board.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef history_H
+#define history_H
+
+#include "include.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "board.h"
+#include "global.h"
+
+/**
+ * A version of the board: the board's plates plus its first 'dice' dice and
+ * first 'connections' connections.
+ */
+struct history_version {
+	// Number of dice placed.
+	uint32_t dice;
+	// Number of connections made.
+	uint32_t connections;
+	// Time the version was created, in seconds since the epoch.
+	uint64_t tval;
+};
+
+/**
+ * History of a board.  Plates never change once a game starts and dice are
+ * placed in order and never moved, so the board's die array is an
+ * append-only log: every version shares the plates and all of the dice of
+ * the versions before it, and a version is just a length into that log.
+ * Connections are likewise never undone and form a second such log.
+ * Recording a placement costs one version entry, and any version's state is
+ * read directly from the board without replaying.
+ */
+struct history {
+	// Board the history is of.
+	struct board* board;
+	// Versions in order; version zero has no dice.
+	struct history_version* versions;
+	uint32_t version_count;
+	uint32_t version_size;
+};
+
+/**
+ * Frees the history.
+ */
+void history_free(struct history* history);
+
+/**
+ * Returns the specified version, or NULL if there is no such version.
+ */
+struct history_version* history_get(struct history* history,
+	uint32_t version);
+
+/**
+ * Starts a history of the specified board with one version for each die
+ * already placed followed by one for each connection already made.
+ */
+struct flub* history_init(struct history* history, struct board* board);
+
+/**
+ * Records the board's current state as a new version.
+ */
+struct flub* history_push(struct history* history);
+
+#endif // history_H
@@ -0,0 +1,117 @@
+/**
+ *  See 'interest.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "interest.h"
+
+void interest_add(struct interest* interest, uint32_t slot, uint32_t row0,
+	uint32_t column0, uint32_t row1, uint32_t column1) {
+	uint32_t column;
+	uint32_t row;
+	uint32_t tmp;
+
+	// Order corners.
+	if (row0 > row1) {
+		tmp = row0;
+		row0 = row1;
+		row1 = tmp;
+	}
+	if (column0 > column1) {
+		tmp = column0;
+		column0 = column1;
+		column1 = tmp;
+	}
+
+	// Mark plates.
+	for (row = row0; row <= row1 && row < interest->rows; row++) {
+		for (column = column0; column <= column1 &&
+			column < interest->columns; column++) {
+			interest_set(&interest->cells[(row * interest->columns +
+				column) * interest->words], slot);
+		}
+	}
+}
+
+void interest_all(struct interest* interest, uint32_t slot) {
+	interest_clear(interest, slot);
+	interest_set(interest->all, slot);
+}
+
+void interest_clear(struct interest* interest, uint32_t slot) {
+	uint32_t i;
+	uint64_t mask;
+	uint32_t word;
+
+	// Clear the slot's bit in every mask, the whole-board one included.
+	mask = ~((uint64_t)1 << (slot % INTEREST_WORD_SLOTS));
+	word = slot / INTEREST_WORD_SLOTS;
+	for (i = 0; i <= interest->rows * interest->columns; i++) {
+		interest->cells[i * interest->words + word] &= mask;
+	}
+}
+
+void interest_free(struct interest* interest) {
+	free(interest->cells);
+	memset(interest, 0, sizeof(struct interest));
+}
+
+void interest_get(struct interest* interest, uint32_t row, uint32_t column,
+	uint64_t* slots) {
+	uint64_t* cell;
+	uint32_t i;
+
+	cell = &interest->cells[(row * interest->columns + column) *
+		interest->words];
+	for (i = 0; i < interest->words; i++) {
+		slots[i] = interest->all[i] | cell[i];
+	}
+}
+
+struct flub* interest_init(struct interest* interest, uint32_t rows,
+	uint32_t columns, uint32_t slots) {
+	// Allocate plate masks followed by the whole-board mask.
+	memset(interest, 0, sizeof(struct interest));
+	interest->words = INTEREST_WORDS(slots);
+	interest->cells = calloc((rows * columns + 1) * interest->words,
+		sizeof(uint64_t));
+	if (!interest->cells) {
+		return g_flub_toss("Unable to allocate interest index");
+	}
+	interest->all = &interest->cells[rows * columns * interest->words];
+	interest->rows = rows;
+	interest->columns = columns;
+	return NULL;
+}
+
+int interest_next(uint64_t* slots, uint32_t words, uint32_t* slot) {
+	uint32_t i;
+
+	for (i = 0; i < words; i++) {
+		if (slots[i]) {
+			*slot = i * INTEREST_WORD_SLOTS +
+				__builtin_ctzll(slots[i]);
+			slots[i] &= slots[i] - 1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void interest_set(uint64_t* slots, uint32_t slot) {
+	slots[slot / INTEREST_WORD_SLOTS] |=
+		(uint64_t)1 << (slot % INTEREST_WORD_SLOTS);
+}
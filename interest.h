@@ -0,0 +1,96 @@
+/**
+ *  Plates each player subscribes to.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef interest_H
+#define interest_H
+
+#include "include.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+
+// Slots in a word of a slot mask.
+#define INTEREST_WORD_SLOTS 64
+// Words in a mask of the specified number of slots.
+#define INTEREST_WORDS(slots) \
+	(((slots) + INTEREST_WORD_SLOTS - 1) / INTEREST_WORD_SLOTS)
+
+/**
+ * Subscribers of each plate on a board, one bit per player slot, so the
+ * players interested in a plate are found without visiting the others.
+ * Each mask is an array of 'words' words, enough for every slot.
+ */
+struct interest {
+	// Slots subscribed to each plate, in row-major order.
+	uint64_t* cells;
+	uint32_t rows;
+	uint32_t columns;
+	uint32_t words;
+	// Slots subscribed to the whole board.
+	uint64_t* all;
+};
+
+/**
+ * Subscribes the slot to the plates between the specified corners.
+ */
+void interest_add(struct interest* interest, uint32_t slot, uint32_t row0,
+	uint32_t column0, uint32_t row1, uint32_t column1);
+
+/**
+ * Subscribes the slot to the whole board.
+ */
+void interest_all(struct interest* interest, uint32_t slot);
+
+/**
+ * Removes each of the slot's subscriptions.
+ */
+void interest_clear(struct interest* interest, uint32_t slot);
+
+/**
+ * Frees the index.
+ */
+void interest_free(struct interest* interest);
+
+/**
+ * Outputs the mask of the slots subscribed to the specified plate.
+ */
+void interest_get(struct interest* interest, uint32_t row, uint32_t column,
+	uint64_t* slots);
+
+/**
+ * Creates an index without subscriptions for a board of the specified size
+ * and the specified number of slots.
+ */
+struct flub* interest_init(struct interest* interest, uint32_t rows,
+	uint32_t columns, uint32_t slots);
+
+/**
+ * Removes the lowest slot from the mask of 'words' words and outputs it.
+ * Returns zero once the mask is empty.
+ */
+int interest_next(uint64_t* slots, uint32_t words, uint32_t* slot);
+
+/**
+ * Adds the slot to the mask.
+ */
+void interest_set(uint64_t* slots, uint32_t slot);
+
+#endif // interest_H
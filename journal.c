@@ -0,0 +1,779 @@
+/**
+ *  See 'journal.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "journal.h"
+
+// Size of a snapshot header: magic, version, sequence number, CRC, and size.
+#define JOURNAL_SNAPSHOT_HEADER_SIZE 24
+
+static struct flub* journal_append(struct journal* journal, uint8_t type,
+	char* payload, size_t size);
+static struct flub* journal_dir_sync(char* path);
+static struct flub* journal_file_read(char* path, char** buffer,
+	size_t* size);
+static struct flub* journal_log_trim(struct journal* journal, char* tail,
+	size_t size);
+static struct flub* journal_recover(struct journal* journal,
+	struct board* board, uint64_t seq);
+static char* journal_string_get(char* payload, size_t* offset, size_t size,
+	char* string, size_t length);
+static size_t journal_string_put(char* payload, char* string);
+static void* journal_thread(void* journal);
+static struct flub* journal_snapshot_write(struct journal* journal,
+	char* snapshot, size_t size, uint64_t seq);
+
+void journal_close(struct journal* journal) {
+	int ret;
+
+	// Stop writer thread.
+	if (journal->running) {
+		pthread_mutex_lock(&journal->mutex);
+		journal->running = 0;
+		pthread_cond_signal(&journal->cond);
+		pthread_mutex_unlock(&journal->mutex);
+		if ((ret = pthread_join(journal->thread, NULL))) {
+			g_log_warn("Unable to join journal thread: '%s'",
+				g_serr(ret));
+		}
+	}
+
+	// Free resources.
+	if (journal->fd != -1 && close(journal->fd) == -1) {
+		g_log_warn("Unable to close journal: '%s'", g_serr(errno));
+	}
+	pthread_cond_destroy(&journal->cond);
+	pthread_mutex_destroy(&journal->mutex);
+	free(journal->pending);
+	free(journal->snapshot);
+	journal->fd = -1;
+	journal->pending = NULL;
+	journal->snapshot = NULL;
+}
+
+struct flub* journal_connect(struct journal* journal, char* nick,
+	uint32_t from, uint32_t to) {
+	char payload[JOURNAL_RECORD_PAYLOAD_MAX];
+	size_t size;
+
+	// Marshal die numbers and nick.
+	payload[0] = (from >> 8) & 0xFF;
+	payload[1] = from & 0xFF;
+	payload[2] = (to >> 8) & 0xFF;
+	payload[3] = to & 0xFF;
+	size = 4;
+	size += journal_string_put(&payload[size], nick);
+	return journal_append(journal, JOURNAL_RECORD_CONNECT, payload,
+		size);
+}
+
+struct flub* journal_die_place(struct journal* journal, char* nick,
+	char* location, uint32_t color, uint32_t die) {
+	char payload[JOURNAL_RECORD_PAYLOAD_MAX];
+	size_t size;
+
+	// Marshal die number, color, location, and nick.
+	payload[0] = (die >> 8) & 0xFF;
+	payload[1] = die & 0xFF;
+	payload[2] = color & 0xFF;
+	size = 3;
+	size += journal_string_put(&payload[size], location);
+	size += journal_string_put(&payload[size], nick);
+	return journal_append(journal, JOURNAL_RECORD_DIE_PLACE, payload,
+		size);
+}
+
+int journal_failed(struct journal* journal) {
+	int failed;
+
+	pthread_mutex_lock(&journal->mutex);
+	failed = journal->failed;
+	pthread_mutex_unlock(&journal->mutex);
+	return failed;
+}
+
+struct flub* journal_join(struct journal* journal, char* nick) {
+	char payload[JOURNAL_RECORD_PAYLOAD_MAX];
+
+	return journal_append(journal, JOURNAL_RECORD_JOIN, payload,
+		journal_string_put(payload, nick));
+}
+
+struct flub* journal_nick(struct journal* journal, char* old, char* new) {
+	char payload[JOURNAL_RECORD_PAYLOAD_MAX];
+	size_t size;
+
+	size = journal_string_put(payload, old);
+	size += journal_string_put(&payload[size], new);
+	return journal_append(journal, JOURNAL_RECORD_NICK, payload, size);
+}
+
+struct flub* journal_open(struct journal* journal, char* path,
+	uint32_t interval, struct board* board, uint64_t seq) {
+	struct flub* flub;
+	int ret;
+
+	// Initialize journal.
+	memset(journal, 0, sizeof(struct journal));
+	journal->fd = -1;
+	journal->interval = interval;
+	if (snprintf(journal->path, PATH_MAX, "%s", path) >= PATH_MAX ||
+		snprintf(journal->snapshot_path, PATH_MAX, "%s.snap", path)
+		>= PATH_MAX) {
+		return g_flub_toss("Journal path too long");
+	}
+	if ((ret = pthread_mutex_init(&journal->mutex, NULL))) {
+		return g_flub_toss("Unable to create journal mutex: '%s'",
+			g_serr(ret));
+	}
+	if ((ret = pthread_cond_init(&journal->cond, NULL))) {
+		pthread_mutex_destroy(&journal->mutex);
+		return g_flub_toss("Unable to create journal condition: '%s'",
+			g_serr(ret));
+	}
+
+	// Recover game state.
+	if ((flub = journal_recover(journal, board, seq))) {
+		journal_close(journal);
+		return flub_append(flub, "recovering journal '%s'", path);
+	}
+
+	// Start writer thread.
+	journal->running = 1;
+	if ((ret = pthread_create(&journal->thread, NULL, journal_thread,
+		(void*)journal))) {
+		journal->running = 0;
+		journal_close(journal);
+		return g_flub_toss("Unable to create journal thread: '%s'",
+			g_serr(ret));
+	}
+	return NULL;
+}
+
+struct flub* journal_part(struct journal* journal, char* nick) {
+	char payload[JOURNAL_RECORD_PAYLOAD_MAX];
+
+	return journal_append(journal, JOURNAL_RECORD_PART, payload,
+		journal_string_put(payload, nick));
+}
+
+struct flub* journal_snapshot(struct journal* journal, struct board* board) {
+	char* buffer;
+	struct flub* flub;
+	size_t size;
+
+	// Check interval.
+	if (journal->since_snapshot < journal->interval) {
+		return NULL;
+	}
+
+	// Queue the board behind the records already appended.
+	if ((flub = board_marshal(board, &buffer, &size))) {
+		return flub_append(flub, "snapshotting board");
+	}
+	pthread_mutex_lock(&journal->mutex);
+	free(journal->snapshot);
+	journal->snapshot = buffer;
+	journal->snapshot_size = size;
+	journal->snapshot_seq = journal->seq;
+	journal->since_snapshot = 0;
+	pthread_cond_signal(&journal->cond);
+	pthread_mutex_unlock(&journal->mutex);
+	return NULL;
+}
+
+/**
+ * Appends a record with the specified type and payload to the pending batch.
+ */
+static struct flub* journal_append(struct journal* journal, uint8_t type,
+	char* payload, size_t size) {
+	uint32_t crc;
+	char* record;
+	uint64_t seq;
+	uint32_t tmp;
+
+	// Check journal.
+	pthread_mutex_lock(&journal->mutex);
+	if (journal->failed) {
+		pthread_mutex_unlock(&journal->mutex);
+		return g_flub_toss("Journal failed");
+	}
+
+	// Grow pending batch.
+	if (journal->pending_count + JOURNAL_RECORD_HEADER_SIZE + size >
+		journal->pending_size) {
+		char* pending;
+		size_t pending_size;
+
+		pending_size = journal->pending_size ?
+			journal->pending_size * 2 : 4096;
+		if (!(pending = realloc(journal->pending, pending_size))) {
+			pthread_mutex_unlock(&journal->mutex);
+			return g_flub_toss("Unable to allocate journal batch");
+		}
+		journal->pending = pending;
+		journal->pending_size = pending_size;
+	}
+
+	// Marshal record.
+	record = &journal->pending[journal->pending_count];
+	tmp = htobe32(size);
+	memcpy(record, &tmp, sizeof(uint32_t));
+	seq = htobe64(++journal->seq);
+	memcpy(&record[8], &seq, sizeof(uint64_t));
+	record[16] = type;
+	memcpy(&record[JOURNAL_RECORD_HEADER_SIZE], payload, size);
+	crc = htobe32(g_crc32(0, &record[8], 9 + size));
+	memcpy(&record[4], &crc, sizeof(uint32_t));
+	journal->pending_count += JOURNAL_RECORD_HEADER_SIZE + size;
+	journal->since_snapshot++;
+
+	// Wake writer.
+	pthread_cond_signal(&journal->cond);
+	pthread_mutex_unlock(&journal->mutex);
+	return NULL;
+}
+
+/**
+ * Syncs the directory holding the file at the specified path, so a rename
+ * into it survives a crash.
+ */
+static struct flub* journal_dir_sync(char* path) {
+	char dir[PATH_MAX];
+	int fd;
+	struct flub* flub;
+	char* slash;
+
+	// Find directory.
+	snprintf(dir, sizeof(dir), "%s", path);
+	if (!(slash = strrchr(dir, '/'))) {
+		snprintf(dir, sizeof(dir), ".");
+	} else {
+		slash[slash == dir ? 1 : 0] = '\0';
+	}
+
+	// Sync it.
+	if ((fd = open(dir, O_RDONLY | O_DIRECTORY)) == -1) {
+		return g_flub_toss("Unable to open '%s': '%s'", dir,
+			g_serr(errno));
+	}
+	flub = NULL;
+	if (fsync(fd) == -1) {
+		flub = g_flub_toss("Unable to sync '%s': '%s'", dir,
+			g_serr(errno));
+	}
+	if (close(fd) == -1 && !flub) {
+		flub = g_flub_toss("Unable to close '%s': '%s'", dir,
+			g_serr(errno));
+	}
+	return flub;
+}
+
+/**
+ * Reads the entire file at the specified path into a newly-allocated buffer.
+ * Outputs a NULL buffer if the file does not exist.
+ */
+static struct flub* journal_file_read(char* path, char** buffer,
+	size_t* size) {
+	int fd;
+	struct flub* flub;
+	struct stat st;
+
+	// Open file.
+	(*buffer) = NULL;
+	(*size) = 0;
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		if (errno == ENOENT) {
+			return NULL;
+		}
+		return g_flub_toss("Unable to open '%s': '%s'", path,
+			g_serr(errno));
+	}
+
+	// Read contents.
+	flub = NULL;
+	if (fstat(fd, &st) == -1) {
+		flub = g_flub_toss("Unable to stat '%s': '%s'", path,
+			g_serr(errno));
+	} else if (!((*buffer) = malloc(st.st_size ? st.st_size : 1))) {
+		flub = g_flub_toss("Unable to allocate buffer for '%s'", path);
+	} else if (gls_readn(fd, *buffer, st.st_size) < st.st_size) {
+		flub = g_flub_toss("Unable to read '%s': '%s'", path,
+			g_serr(errno));
+		free(*buffer);
+		(*buffer) = NULL;
+	} else {
+		(*size) = st.st_size;
+	}
+	if (close(fd) == -1) {
+		g_log_warn("Unable to close '%s': '%s'", path, g_serr(errno));
+	}
+	return flub;
+}
+
+/**
+ * Cuts the log back to the specified records, which follow the latest
+ * snapshot.  Any records are written to a new log that replaces the old one,
+ * so a crash leaves one log or the other whole.
+ */
+static struct flub* journal_log_trim(struct journal* journal, char* tail,
+	size_t size) {
+	int fd;
+	struct flub* flub;
+	char path[PATH_MAX + 4];
+
+	// Empty log.
+	if (!size) {
+		if (ftruncate(journal->fd, 0) == -1) {
+			return g_flub_toss("Unable to truncate journal: '%s'",
+				g_serr(errno));
+		}
+		return NULL;
+	}
+
+	// Write and sync new log.
+	snprintf(path, sizeof(path), "%s.tmp", journal->path);
+	if ((fd = open(path, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND,
+		0644)) == -1) {
+		return g_flub_toss("Unable to create '%s': '%s'", path,
+			g_serr(errno));
+	}
+	flub = NULL;
+	if (gls_writen(fd, tail, size) < size) {
+		flub = g_flub_toss("Unable to write journal: '%s'",
+			g_serr(errno));
+	} else if (fdatasync(fd) == -1) {
+		flub = g_flub_toss("Unable to sync journal: '%s'",
+			g_serr(errno));
+	} else if (rename(path, journal->path) == -1) {
+		flub = g_flub_toss("Unable to rename journal: '%s'",
+			g_serr(errno));
+	}
+	if (flub) {
+		close(fd);
+		unlink(path);
+		return flub;
+	}
+
+	// Append to new log.
+	if (close(journal->fd) == -1) {
+		g_log_warn("Unable to close journal: '%s'", g_serr(errno));
+	}
+	journal->fd = fd;
+	return journal_dir_sync(journal->path);
+}
+
+/**
+ * Loads the latest snapshot into the board if it is newer than 'board_seq'
+ * then replays the log records that follow.  A torn or corrupt tail of the
+ * log is truncated.
+ */
+static struct flub* journal_recover(struct journal* journal,
+	struct board* board, uint64_t board_seq) {
+	char* buffer;
+	struct catalog* catalog;
+	uint32_t color;
+	uint32_t crc;
+	uint32_t die;
+	struct flub* flub;
+	char location[GLS_LOCATION_LENGTH];
+	char nick[GLS_NICK_LENGTH];
+	char nick2[GLS_NICK_LENGTH];
+	size_t offset;
+	size_t payload;
+	uint32_t replayed;
+	uint64_t seq;
+	size_t size;
+	uint64_t snapshot_seq;
+	uint32_t tmp;
+	uint8_t type;
+
+	// Load snapshot.
+	snapshot_seq = 0;
+	if ((flub = journal_file_read(journal->snapshot_path, &buffer,
+		&size))) {
+		return flub;
+	}
+	if (buffer) {
+		if (size < JOURNAL_SNAPSHOT_HEADER_SIZE ||
+			memcmp(buffer, JOURNAL_SNAPSHOT_MAGIC, 4)) {
+			free(buffer);
+			return g_flub_toss("Bad snapshot header");
+		}
+		memcpy(&tmp, &buffer[4], sizeof(uint32_t));
+		if (be32toh(tmp) != JOURNAL_SNAPSHOT_VERSION) {
+			free(buffer);
+			return g_flub_toss("Unsupported snapshot version '%u'",
+				be32toh(tmp));
+		}
+		memcpy(&seq, &buffer[8], sizeof(uint64_t));
+		memcpy(&crc, &buffer[16], sizeof(uint32_t));
+		memcpy(&tmp, &buffer[20], sizeof(uint32_t));
+		if (be32toh(tmp) != size - JOURNAL_SNAPSHOT_HEADER_SIZE ||
+			be32toh(crc) != g_crc32(0,
+			&buffer[JOURNAL_SNAPSHOT_HEADER_SIZE],
+			size - JOURNAL_SNAPSHOT_HEADER_SIZE)) {
+			free(buffer);
+			return g_flub_toss("Corrupt snapshot");
+		}
+		snapshot_seq = be64toh(seq);
+		if (snapshot_seq <= board_seq) {
+			// Board is at least as new as the snapshot.
+			free(buffer);
+			buffer = NULL;
+		}
+	}
+	if (buffer) {
+		catalog = board->catalog;
+		board_free(board);
+		flub = board_unmarshal(board, catalog,
+			&buffer[JOURNAL_SNAPSHOT_HEADER_SIZE],
+			size - JOURNAL_SNAPSHOT_HEADER_SIZE);
+		free(buffer);
+		if (flub) {
+			return flub_append(flub, "loading snapshot");
+		}
+		g_log_info("Loaded snapshot at record '%llu'",
+			(unsigned long long)snapshot_seq);
+	}
+	if (board_seq > snapshot_seq) {
+		snapshot_seq = board_seq;
+	}
+	journal->seq = snapshot_seq;
+
+	// Replay log records after the snapshot.
+	if ((flub = journal_file_read(journal->path, &buffer, &size))) {
+		return flub;
+	}
+	replayed = 0;
+	for (offset = 0; buffer && offset + JOURNAL_RECORD_HEADER_SIZE <= size;
+		offset += JOURNAL_RECORD_HEADER_SIZE + payload) {
+		char* record;
+
+		// Check record.
+		record = &buffer[offset];
+		memcpy(&tmp, record, sizeof(uint32_t));
+		payload = be32toh(tmp);
+		if (payload > JOURNAL_RECORD_PAYLOAD_MAX ||
+			offset + JOURNAL_RECORD_HEADER_SIZE + payload > size) {
+			break;
+		}
+		memcpy(&crc, &record[4], sizeof(uint32_t));
+		if (be32toh(crc) != g_crc32(0, &record[8], 9 + payload)) {
+			break;
+		}
+		memcpy(&seq, &record[8], sizeof(uint64_t));
+		seq = be64toh(seq);
+		if (seq <= snapshot_seq) {
+			continue;
+		} else if (seq != journal->seq + 1) {
+			free(buffer);
+			return g_flub_toss("Journal record '%llu' out of "
+				"sequence", (unsigned long long)seq);
+		}
+		journal->seq = seq;
+		replayed++;
+
+		// Apply record.
+		type = record[16];
+		record += JOURNAL_RECORD_HEADER_SIZE;
+		if (type == JOURNAL_RECORD_DIE_PLACE && payload >= 3) {
+			size_t i;
+			uint32_t placed;
+
+			die = ((uint8_t)record[0] << 8) | (uint8_t)record[1];
+			color = (uint8_t)record[2];
+			i = 3;
+			if (!journal_string_get(record, &i, payload, location,
+				GLS_LOCATION_LENGTH) ||
+				!journal_string_get(record, &i, payload, nick,
+				GLS_NICK_LENGTH)) {
+				free(buffer);
+				return g_flub_toss("Malformed die record "
+					"'%llu'", (unsigned long long)seq);
+			}
+			if ((flub = board_die_place(board, nick, location,
+				&color, &placed))) {
+				free(buffer);
+				return flub_append(flub, "replaying record "
+					"'%llu'", (unsigned long long)seq);
+			} else if (placed != die) {
+				free(buffer);
+				return g_flub_toss("Replayed die '%u' placed "
+					"as '%u'", die, placed);
+			}
+		} else if (type == JOURNAL_RECORD_CONNECT && payload >= 4) {
+			size_t i;
+			uint32_t from;
+			uint32_t to;
+
+			from = ((uint8_t)record[0] << 8) | (uint8_t)record[1];
+			to = ((uint8_t)record[2] << 8) | (uint8_t)record[3];
+			i = 4;
+			if (!journal_string_get(record, &i, payload, nick,
+				GLS_NICK_LENGTH)) {
+				free(buffer);
+				return g_flub_toss("Malformed connection "
+					"record '%llu'",
+					(unsigned long long)seq);
+			}
+			if ((flub = board_connect(board, nick, from, to))) {
+				free(buffer);
+				return flub_append(flub, "replaying record "
+					"'%llu'", (unsigned long long)seq);
+			}
+		} else if (type == JOURNAL_RECORD_NICK) {
+			size_t i;
+
+			i = 0;
+			if (journal_string_get(record, &i, payload, nick,
+				GLS_NICK_LENGTH) && journal_string_get(record,
+				&i, payload, nick2, GLS_NICK_LENGTH)) {
+				g_log_debug("Replayed nick '%s' to '%s'", nick,
+					nick2);
+			}
+		} else if (type == JOURNAL_RECORD_JOIN ||
+			type == JOURNAL_RECORD_PART) {
+			size_t i;
+
+			i = 0;
+			if (journal_string_get(record, &i, payload, nick,
+				GLS_NICK_LENGTH)) {
+				g_log_debug("Replayed %s of '%s'",
+					type == JOURNAL_RECORD_JOIN ?
+					"join" : "part", nick);
+			}
+		} else {
+			free(buffer);
+			return g_flub_toss("Unknown journal record type "
+				"'%u'", type);
+		}
+	}
+	free(buffer);
+	journal->since_snapshot = replayed;
+
+	// Open log, dropping any torn tail.
+	if ((journal->fd = open(journal->path, O_WRONLY | O_CREAT | O_APPEND,
+		0644)) == -1) {
+		return g_flub_toss("Unable to open journal: '%s'",
+			g_serr(errno));
+	}
+	if (offset < size) {
+		g_log_warn("Truncating journal tail at byte '%zu'", offset);
+		if (ftruncate(journal->fd, offset) == -1) {
+			return g_flub_toss("Unable to truncate journal: '%s'",
+				g_serr(errno));
+		}
+	}
+	g_log_info("Replayed '%u' journal records", replayed);
+	return NULL;
+}
+
+/**
+ * Reads a length-prefixed string at the specified offset of a payload into
+ * 'string', advancing the offset.  Returns NULL if the string is malformed.
+ */
+static char* journal_string_get(char* payload, size_t* offset, size_t size,
+	char* string, size_t length) {
+	size_t len;
+
+	// Read length then bytes.
+	if ((*offset) >= size) {
+		return NULL;
+	}
+	len = (uint8_t)payload[(*offset)++];
+	if (len >= length || (*offset) + len > size) {
+		return NULL;
+	}
+	memcpy(string, &payload[*offset], len);
+	string[len] = '\0';
+	(*offset) += len;
+	return string;
+}
+
+/**
+ * Writes the string with a one-byte length prefix, returning the bytes
+ * written.
+ */
+static size_t journal_string_put(char* payload, char* string) {
+	size_t len;
+
+	len = strlen(string);
+	payload[0] = len;
+	memcpy(&payload[1], string, len);
+	return len + 1;
+}
+
+/**
+ * Writer thread; commits pending records in batches and writes queued
+ * snapshots.
+ */
+static void* journal_thread(void* v_journal) {
+	char* batch;
+	size_t batch_count;
+	size_t batch_size;
+	struct flub* flub;
+	struct journal* journal = (struct journal*)v_journal;
+	size_t offset;
+	uint64_t seq;
+	char* snapshot;
+	size_t snapshot_size;
+	uint64_t snapshot_seq;
+	uint32_t tmp;
+
+	// Initialize thread-specific data.
+	if (g_serr_init()) {
+		g_log_error("Unable to setup system error buffer");
+		return NULL;
+	}
+	if (g_flub_init()) {
+		g_log_error("Unable to initialize flub");
+		return NULL;
+	}
+
+	// Commit batches until stopped with nothing left to write.
+	batch = NULL;
+	batch_size = 0;
+	while (1) {
+		// Take pending records and snapshot.
+		pthread_mutex_lock(&journal->mutex);
+		while (journal->running && !journal->pending_count &&
+			!journal->snapshot) {
+			pthread_cond_wait(&journal->cond, &journal->mutex);
+		}
+		if (!journal->running && !journal->pending_count &&
+			!journal->snapshot) {
+			pthread_mutex_unlock(&journal->mutex);
+			break;
+		}
+		batch_count = journal->pending_count;
+		{
+			char* tmp;
+			size_t tmp_size;
+
+			tmp = batch;
+			tmp_size = batch_size;
+			batch = journal->pending;
+			batch_size = journal->pending_size;
+			journal->pending = tmp;
+			journal->pending_size = tmp_size;
+			journal->pending_count = 0;
+		}
+		snapshot = journal->snapshot;
+		snapshot_size = journal->snapshot_size;
+		snapshot_seq = journal->snapshot_seq;
+		journal->snapshot = NULL;
+		pthread_mutex_unlock(&journal->mutex);
+
+		// Commit records.  Their moves may already be acknowledged,
+		// so a failed commit fails the journal rather than carrying on
+		// without them.
+		if (batch_count && (gls_writen(journal->fd, batch,
+			batch_count) < batch_count ||
+			fdatasync(journal->fd) == -1)) {
+			g_log_error("Unable to commit journal: '%s'",
+				g_serr(errno));
+			free(snapshot);
+			pthread_mutex_lock(&journal->mutex);
+			journal->failed = 1;
+			pthread_mutex_unlock(&journal->mutex);
+			break;
+		}
+
+		// Write snapshot then drop the records it covers.  Records
+		// appended after it was queued are all in this batch.
+		if (snapshot) {
+			for (offset = 0; offset < batch_count;
+				offset += JOURNAL_RECORD_HEADER_SIZE +
+				be32toh(tmp)) {
+				memcpy(&tmp, &batch[offset], sizeof(uint32_t));
+				memcpy(&seq, &batch[offset + 8],
+					sizeof(uint64_t));
+				if (be64toh(seq) > snapshot_seq) {
+					break;
+				}
+			}
+			if ((flub = journal_snapshot_write(journal, snapshot,
+				snapshot_size, snapshot_seq))) {
+				g_log_error("Unable to write snapshot: '%s'",
+					flub->message);
+			} else if ((flub = journal_log_trim(journal,
+				&batch[offset], batch_count - offset))) {
+				g_log_error("Unable to trim journal: '%s'",
+					flub->message);
+			}
+			free(snapshot);
+		}
+	}
+	free(batch);
+	return NULL;
+}
+
+/**
+ * Writes the snapshot to a temporary file then moves it into place.
+ */
+static struct flub* journal_snapshot_write(struct journal* journal,
+	char* snapshot, size_t size, uint64_t seq) {
+	int fd;
+	struct flub* flub;
+	char header[JOURNAL_SNAPSHOT_HEADER_SIZE];
+	struct iovec iovs[2];
+	char path[PATH_MAX + 4];
+	uint32_t tmp;
+
+	// Prepare header.
+	memcpy(header, JOURNAL_SNAPSHOT_MAGIC, 4);
+	tmp = htobe32(JOURNAL_SNAPSHOT_VERSION);
+	memcpy(&header[4], &tmp, sizeof(uint32_t));
+	seq = htobe64(seq);
+	memcpy(&header[8], &seq, sizeof(uint64_t));
+	tmp = htobe32(g_crc32(0, snapshot, size));
+	memcpy(&header[16], &tmp, sizeof(uint32_t));
+	tmp = htobe32(size);
+	memcpy(&header[20], &tmp, sizeof(uint32_t));
+
+	// Write and sync temporary file.
+	snprintf(path, sizeof(path), "%s.tmp", journal->snapshot_path);
+	if ((fd = open(path, O_CREAT | O_TRUNC | O_WRONLY, 0644)) == -1) {
+		return g_flub_toss("Unable to create '%s': '%s'", path,
+			g_serr(errno));
+	}
+	iovs[0].iov_base = header;
+	iovs[0].iov_len = sizeof(header);
+	iovs[1].iov_base = snapshot;
+	iovs[1].iov_len = size;
+	flub = NULL;
+	if (gls_writevn(fd, iovs, 2) < sizeof(header) + size) {
+		flub = g_flub_toss("Unable to write snapshot: '%s'",
+			g_serr(errno));
+	} else if (fsync(fd) == -1) {
+		flub = g_flub_toss("Unable to sync snapshot: '%s'",
+			g_serr(errno));
+	}
+	if (close(fd) == -1 && !flub) {
+		flub = g_flub_toss("Unable to close snapshot: '%s'",
+			g_serr(errno));
+	}
+	if (!flub && rename(path, journal->snapshot_path) == -1) {
+		flub = g_flub_toss("Unable to rename snapshot: '%s'",
+			g_serr(errno));
+	}
+	if (!flub) {
+		flub = journal_dir_sync(journal->snapshot_path);
+	}
+	return flub;
+}
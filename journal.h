@@ -0,0 +1,152 @@
+/**
+ *  Write-ahead log of game events with periodic board snapshots.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef journal_H
+#define journal_H
+
+#include "include.h"
+
+#include <endian.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "global.h"
+#include "gls.h"
+
+// Snapshot file magic and format version.
+#define JOURNAL_SNAPSHOT_MAGIC "GLSS"
+#define JOURNAL_SNAPSHOT_VERSION 2
+// Default number of records between snapshots.
+#define JOURNAL_SNAPSHOT_INTERVAL 1024
+
+// Journal record types.
+#define JOURNAL_RECORD_DIE_PLACE 0x01
+#define JOURNAL_RECORD_NICK 0x02
+#define JOURNAL_RECORD_JOIN 0x03
+#define JOURNAL_RECORD_PART 0x04
+#define JOURNAL_RECORD_CONNECT 0x05
+
+// Size of a record header: payload size, CRC, sequence number, and type.
+#define JOURNAL_RECORD_HEADER_SIZE 17
+// Largest record payload.
+#define JOURNAL_RECORD_PAYLOAD_MAX (5 + 2 * GLS_NICK_LENGTH + \
+	GLS_LOCATION_LENGTH)
+
+/**
+ * Write-ahead event log.  Records are appended to an in-memory batch by the
+ * game thread and written by a separate writer thread, which commits every
+ * record queued since its last pass with a single 'fdatasync'.  A snapshot
+ * of the board is queued behind the records that precede it; once it is
+ * durable the log is cut back to the records that follow it, so recovery
+ * replays at most one snapshot interval of records.  Moves are acknowledged
+ * before their records are durable, so a failed commit fails the journal
+ * and the server shuts down instead of accepting moves it can't keep.
+ */
+struct journal {
+	// Log file.
+	int fd;
+	char path[PATH_MAX];
+	// Snapshot file.
+	char snapshot_path[PATH_MAX];
+	// Writer thread.
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	// Records waiting to be written.
+	char* pending;
+	size_t pending_count;
+	size_t pending_size;
+	// Board snapshot waiting to be written.
+	char* snapshot;
+	size_t snapshot_size;
+	uint64_t snapshot_seq;
+	// Sequence number of the last appended record.
+	uint64_t seq;
+	// Records appended since the last snapshot.
+	uint32_t since_snapshot;
+	// Records between snapshots.
+	uint32_t interval;
+	// A commit failed; the writer has stopped and appends fail.
+	int failed;
+	// Writer thread running.
+	unsigned running:1;
+};
+
+/**
+ * Stops the writer thread after committing any queued records and frees the
+ * journal.
+ */
+void journal_close(struct journal* journal);
+
+/**
+ * Appends a die connection record.
+ */
+struct flub* journal_connect(struct journal* journal, char* nick,
+	uint32_t from, uint32_t to);
+
+/**
+ * Appends a die placement record.
+ */
+struct flub* journal_die_place(struct journal* journal, char* nick,
+	char* location, uint32_t color, uint32_t die);
+
+/**
+ * Returns nonzero once a commit has failed.  Records appended before the
+ * failure may be lost and no more may be appended, so the server must stop.
+ */
+int journal_failed(struct journal* journal);
+
+/**
+ * Appends a player join record.
+ */
+struct flub* journal_join(struct journal* journal, char* nick);
+
+/**
+ * Appends a nick change record.
+ */
+struct flub* journal_nick(struct journal* journal, char* old, char* new);
+
+/**
+ * Opens the journal at the specified path, recovers the board from the
+ * latest snapshot and the log records that follow it, and starts the writer
+ * thread.  The board must already reflect the records up to 'seq' (zero for
+ * a fresh board); it is replaced by the snapshot if the snapshot is newer.
+ * A snapshot is queued every 'interval' records.
+ */
+struct flub* journal_open(struct journal* journal, char* path,
+	uint32_t interval, struct board* board, uint64_t seq);
+
+/**
+ * Appends a player part record.
+ */
+struct flub* journal_part(struct journal* journal, char* nick);
+
+/**
+ * Queues a snapshot of the board if a snapshot interval has passed since the
+ * last one.
+ */
+struct flub* journal_snapshot(struct journal* journal, struct board* board);
+
+#endif // journal_H
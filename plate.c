@@ -22,7 +22,7 @@
 
 struct flub* plate_print(struct plate* plate, int fd) {
 	// Print plate info.
-	if (plate->empty) {
+	if (!plate) {
 		g_log_info("Location is empty");
 		return NULL;
 	}
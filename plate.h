@@ -20,25 +20,29 @@
 #ifndef plate_H
 #define plate_H
 
+#include "include.h"
+
 #include <stdlib.h>
 
 #include "global.h"
 #include "gls.h"
 
+/**
+ * View of a plate's strings; the strings are owned by the plate's catalog.
+ */
 struct plate {
 	// The plate's concept.
-	char name[GLS_PLATE_NAME_LENGTH];
+	const char* name;
 	// A short, three-letter abbreviation for the plate's name. Names are
 	// not meant to be unique.
-	char abbrev[GLS_PLATE_ABBREV_LENGTH];
+	const char* abbrev;
 	// Description of the plate's concept.
-	char description[GLS_PLATE_DESCRIPTION_LENGTH];
-	// Whether or not the plate is empty.
-	uint32_t empty:1;
+	const char* description;
 };
 
 /**
- * Pretty-prints the plate to the specified file.
+ * Pretty-prints the plate to the specified file.  A NULL plate is printed as
+ * an empty location.
  */
 struct flub* plate_print(struct plate* plate, int fd);
 
@@ -18,8 +18,35 @@
  */
 #include "player.h"
 
+static struct flub* player_batch(struct player* player,
+	struct gls_frame* frame);
+static struct flub* player_forward(struct player* player, int lanes,
+	int* idle);
+static struct flub* player_lane_open(int* fds, int lane);
+static int player_place_reject(struct player* player,
+	struct gls_die_place_try* try);
+static struct flub* player_plate_detail(struct player* player,
+	struct gls_plate_detail_req* req);
+static struct flub* player_receive(struct player* player,
+	struct gls_packet* packet, int framed);
+
+int player_chat_full(struct player* player) {
+	int fd;
+	int queued;
+
+	// Check for room for the largest packet, counting chat held back for
+	// the next frame.
+	fd = player->lanes[PLAYER_LANE_CHAT][1];
+	if (ioctl(fd, FIONREAD, &queued) == -1) {
+		return 0;
+	}
+	return queued + gls_batch_length(fd) >
+		G_PLAYER_CHAT_PIPE_SIZE - GLS_PIPE_BUF;
+}
+
 void player_free(struct player* player, struct flub* status) {
 	struct flub* flub;
+	int i;
 	int ret;
 
 	// Join player thread.
@@ -38,15 +65,15 @@ void player_free(struct player* player, struct flub* status) {
 			g_serr(errno));
 	}
 
-	// Close from-server pipe.
-	if (close(player->pipe_server_from[0]) == -1) {
-		g_log_warn("Unable to close from-server read end: '%s'",
-			g_serr(errno));
-	}
-	if (!player->killed) { // Server "kills" player by closing write end.
-		if (close(player->pipe_server_from[1]) == -1) {
-			g_log_warn("Unable to close from-server write end: "
-				"'%s'", g_serr(errno));
+	// Close outbound lane write ends; the player thread closed the read
+	// ends.
+	for (i = 0; i < PLAYER_LANE_COUNT &&
+		!__atomic_load_n(&player->killed, __ATOMIC_ACQUIRE); i++) {
+		// Server "kills" player by closing write ends.
+		gls_batch_close(player->lanes[i][1]);
+		if (close(player->lanes[i][1]) == -1) {
+			g_log_warn("Unable to close lane write end: '%s'",
+				g_serr(errno));
 		}
 	}
 
@@ -59,9 +86,11 @@ void player_free(struct player* player, struct flub* status) {
 	memset((void*)player, 0, sizeof(struct player));
 }
 
-struct flub* player_init(struct player* player, int fd) {
+struct flub* player_init(struct player* player, int fd, struct board* board,
+	int compression) {
 	int flags;
 	struct flub* flub;
+	int i;
 	int ret;
 	long size;
 	const struct timeval timeval = {60, 0};
@@ -72,6 +101,9 @@ struct flub* player_init(struct player* player, int fd) {
 	// Set socket.
 	player->sockfd = fd;
 	player->connected = 1;
+	player->board = board;
+	player->compression = compression;
+	i = 0;
 	if (setsockopt(player->sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeval,
 		sizeof(timeval)) == -1) {
 		flub = g_flub_toss("Unable to set socket recieve timeout: "
@@ -79,46 +111,12 @@ struct flub* player_init(struct player* player, int fd) {
 		goto out;
 	}
 
-	// Create from-server pipe.
-	if (pipe(player->pipe_server_from) == -1) {
-		flub = g_flub_toss("Unable to create from-server pipe: "
-			"'%s'", g_serr(errno));
-		goto out;
-	}
-	ret = fcntl(player->pipe_server_from[1], F_GETPIPE_SZ);
-	if (ret != G_PLAYER_PIPE_WRITE_SIZE) {
-		// Resize pipe.
-		if (fcntl(player->pipe_server_from[1], F_SETPIPE_SZ,
-			G_PLAYER_PIPE_WRITE_SIZE) == -1) {
-			flub = g_flub_toss("Unable to set from-server pipe "
-				"size to '%u': '%s'", G_PLAYER_PIPE_WRITE_SIZE,
-				g_serr(errno));
+	// Create outbound lanes.
+	for (; i < PLAYER_LANE_COUNT; i++) {
+		if ((flub = player_lane_open(player->lanes[i], i))) {
 			goto out2;
 		}
 	}
-	errno = 0;
-	size = fpathconf(player->pipe_server_from[1], _PC_PIPE_BUF);
-	if (size == -1 && errno) {
-		flub = g_flub_toss("Unable to check from-server atomicity: "
-			"'%s'", g_serr(errno));
-		goto out2;
-	} else if (size != -1 && size < GLS_PIPE_BUF) {
-		flub = g_flub_toss("From-server pipe atomicity too small, "
-			"was '%li', >='%u' expected", size, GLS_PIPE_BUF);
-		goto out2;
-	}
-	flags = fcntl(player->pipe_server_from[1], F_GETFL);
-	if (flags == -1) {
-		flub = g_flub_toss("Unable to get from-server flags: '%s'",
-			g_serr(errno));
-		goto out2;
-	}
-	flags |= O_NONBLOCK;
-	if(fcntl(player->pipe_server_from[1], F_SETFL, flags) == -1) {
-		flub = g_flub_toss("Unable to set non-blocking on from-server "
-			"flags: '%s'", g_serr(errno));
-		goto out2;
-	}
 
 	// Create to-server pipe.
 	if (pipe(player->pipe_server_to) == -1) {
@@ -172,14 +170,16 @@ out3:
 	}
 
 out2:
-	// Close from-server pipe.
-	if (close(player->pipe_server_from[0]) == -1) {
-		flub_append(flub, "unable to close from-server read end (%s)",
-			g_serr(errno));
-	}
-	if (close(player->pipe_server_from[1]) == -1) {
-		flub_append(flub, "unable to close from-server write end(%s)",
-			g_serr(errno));
+	// Close outbound lanes.
+	while (i--) {
+		if (close(player->lanes[i][0]) == -1) {
+			flub_append(flub, "unable to close lane read end "
+				"(%s)", g_serr(errno));
+		}
+		if (close(player->lanes[i][1]) == -1) {
+			flub_append(flub, "unable to close lane write end "
+				"(%s)", g_serr(errno));
+		}
 	}
 
 out:
@@ -194,11 +194,21 @@ out:
 
 struct flub* player_kill(struct player* player) {
 	int flags;
+	int i;
 
-	// Close from-server pipe write end.
-	if (close(player->pipe_server_from[1]) == -1) {
-		g_log_warn("Unable to close from-server write end: '%s'",
-			g_serr(errno));
+	// Already killed.
+	if (__atomic_load_n(&player->killed, __ATOMIC_ACQUIRE)) {
+		return NULL;
+	}
+
+	// Close outbound lane write ends.
+	for (i = 0; i < PLAYER_LANE_COUNT; i++) {
+		gls_batch_close(player->lanes[i][1]);
+		if (close(player->lanes[i][1]) == -1) {
+			g_log_warn("Unable to close lane write end: '%s'",
+				g_serr(errno));
+		}
+		player->lanes[i][1] = -1;
 	}
 
 	// Set socket to non-blocking.
@@ -214,7 +224,7 @@ struct flub* player_kill(struct player* player) {
 	}
 
 	// Set killed flag.
-	player->killed = 1;
+	__atomic_store_n(&player->killed, 1, __ATOMIC_RELEASE);
 	return NULL;
 }
 
@@ -244,12 +254,14 @@ char* player_name(struct player* player) {
 }
 
 void* player_thread(void* v_player) {
-	const int FD_PIPE = 0;
-	const int FD_SOCKET = 1;
+	const int FD_LANE = 1;
+	const int FD_SOCKET = 0;
 	struct flub* flub;
+	int i;
+	int idle;
 	struct gls_packet packet;
 	struct player* player = (struct player*)v_player;
-	struct pollfd pollfds[2];
+	struct pollfd pollfds[1 + PLAYER_LANE_COUNT];
 	int ret;
 
 	// Initialize thread-specific data.
@@ -269,25 +281,35 @@ void* player_thread(void* v_player) {
 			flub->message);
 		goto out;
 	}
+	if (!(player->frame = malloc(GLS_FRAME_LENGTH_MAX))) {
+		flub = g_flub_toss("Unable to allocate frame buffer");
+		goto out;
+	}
 
 	// Run the event loop.
 	flub = NULL;
 	while (1) {
 		// Check for io events.
 		memset(pollfds, 0, sizeof(pollfds));
-		pollfds[FD_PIPE].fd = player->pipe_server_from[0];
-		pollfds[FD_PIPE].events = POLLIN | POLLRDHUP;
 		pollfds[FD_SOCKET].fd = player->sockfd;
 		pollfds[FD_SOCKET].events = POLLIN | POLLRDHUP;
-		if (poll(pollfds, 2, -1) == -1) {
+		for (i = 0; i < PLAYER_LANE_COUNT; i++) {
+			pollfds[FD_LANE + i].fd = player->lanes[i][0];
+			pollfds[FD_LANE + i].events = POLLIN | POLLRDHUP;
+		}
+		// Packets already inflated don't wait on the socket.
+		if (poll(pollfds, 1 + PLAYER_LANE_COUNT,
+			gls_pending(player->sockfd) ? 0 : -1) == -1) {
 			flub = g_flub_toss("Unable to poll fds: '%s'",
 				g_serr(errno));
 			break;
 		}
 		// Data from socket.
-		if (pollfds[FD_SOCKET].revents & POLLIN) {
+		if ((pollfds[FD_SOCKET].revents & POLLIN) ||
+			gls_pending(player->sockfd)) {
 			// Check for disconnect.
-			if (pollfds[FD_SOCKET].revents &
+			if (!gls_pending(player->sockfd) &&
+				pollfds[FD_SOCKET].revents &
 				(POLLHUP | POLLRDHUP)) {
 				// Finish reading from socket.
 				if (ioctl(player->sockfd, FIONREAD, &ret)
@@ -307,8 +329,12 @@ void* player_thread(void* v_player) {
 			if (flub) {
 				break;
 			}
-			flub = gls_packet_write(&packet,
-				player->pipe_server_to[1]);
+			if (packet.header.event == GLS_EVENT_FRAME) {
+				flub = player_batch(player,
+					&packet.data.frame);
+			} else {
+				flub = player_receive(player, &packet, 0);
+			}
 			if (flub) {
 				break;
 			}
@@ -319,37 +345,29 @@ void* player_thread(void* v_player) {
 			break;
 		}
 		// Data from server.
-		if (pollfds[FD_PIPE].revents & (POLLIN | POLLHUP)) {
-			// Check for server kill.
-			if (pollfds[FD_SOCKET].revents & POLLHUP) {
-				// Finish reading from server pipe.
-				if (ioctl(player->pipe_server_from[0], FIONREAD,
-					&ret)
-					== -1) {
-					flub = g_flub_toss("Unable to check "
-						"for bytes after kill: '%s'",
-						g_serr(errno));
-					break;
-				} if (!ret) {
-					// End of data.
-					break;
-				}
-			}
-
-			// Move data from server to socket.
-			flub = gls_packet_read(&packet,
-				player->pipe_server_from[0], 0);
-			if (flub) {
-				break;
-			}
-			flub = gls_packet_write(&packet, player->sockfd);
-			if (flub) {
+		for (i = 0; i < PLAYER_LANE_COUNT; i++) {
+			if (pollfds[FD_LANE + i].revents &
+				(POLLERR | POLLNVAL)) {
+				// Pipe polling error.
+				flub = g_flub_toss("Lane polling error: '%s'",
+					g_serr(errno));
 				break;
 			}
-		} else if (pollfds[FD_PIPE].revents & (POLLERR | POLLNVAL)) {
-			// Pipe polling error.
-			flub = g_flub_toss("Pipe polling error: '%s'",
-				g_serr(errno));
+		}
+		if (flub) {
+			break;
+		}
+		do {
+			// Move data from server to socket, most important
+			// first.
+			flub = player_forward(player, PLAYER_LANE_COUNT,
+				&idle);
+		} while (!flub && !idle);
+		if (flub) {
+			break;
+		}
+		if (pollfds[FD_LANE + PLAYER_LANE_GAME].revents & POLLHUP) {
+			// Server kill and all lanes drained.
 			break;
 		}
 	}
@@ -360,6 +378,22 @@ out:
 		g_log_warn("Unable to close write-end of to-server pipe");
 	}
 
+	// Keep compression counters past the thread's descriptor state.
+	gls_compress_stats(player->sockfd, &player->sent, &player->received);
+
+	// Free frame buffer.
+	free(player->frame);
+	player->frame = NULL;
+
+	// Close outbound lane read ends, so the server can't block on a lane
+	// nobody drains.
+	for (i = 0; i < PLAYER_LANE_COUNT; i++) {
+		if (close(player->lanes[i][0]) == -1) {
+			g_log_warn("Unable to close lane read end: '%s'",
+				g_serr(errno));
+		}
+	}
+
 	// Return success/failure.
 	if (flub) {
 		// The thread-specific data for the flub may be cleaned when this
@@ -369,3 +403,328 @@ out:
 	}
 	return NULL;
 }
+
+/**
+ * Moves the packets of a frame from the socket to the server in as few
+ * frames as fit the to-server pipe's atomic size, so the server reads each
+ * whole and handles its packets together.
+ */
+static struct flub* player_batch(struct player* player,
+	struct gls_frame* frame) {
+	uint32_t count;
+	int fd;
+	struct flub* flub;
+	uint32_t length;
+	uint32_t size;
+	struct gls_packet packet;
+
+	// Frames follow the synchronization.
+	if (!__atomic_load_n(&player->synchronized, __ATOMIC_ACQUIRE)) {
+		return g_flub_toss("Frame before synchronization");
+	}
+
+	// Move frame's packets.
+	fd = player->pipe_server_to[1];
+	if ((flub = gls_batch_open(fd))) {
+		return flub;
+	}
+	length = 0;
+	for (count = 0; !flub && count < frame->count; count++) {
+		if ((flub = gls_packet_read(&packet, player->sockfd, 1))) {
+			break;
+		} else if (packet.header.event == GLS_EVENT_FRAME) {
+			flub = g_flub_toss("Frame within frame");
+			break;
+		}
+		length += packet.header.size + packet.header.length;
+		if (length > frame->length) {
+			flub = g_flub_toss("Frame packets exceed its length "
+				"'%u'", frame->length);
+			break;
+		}
+
+		// Pipe frames are protocol 0: a frame header of three
+		// integers and packets of a header and fixed-size data.
+		size = gls_event_length(packet.header.event);
+		if (size != GLS_LENGTH_UNKNOWN && gls_batch_length(fd) +
+			4 * sizeof(uint32_t) + size > GLS_PIPE_BUF) {
+			flub = gls_batch_flush(fd);
+		}
+		if (!flub) {
+			flub = player_receive(player, &packet, 1);
+		}
+	}
+	if (!flub && length != frame->length) {
+		flub = g_flub_toss("Frame packets took '%u' bytes, not '%u'",
+			length, frame->length);
+	}
+	if (!flub) {
+		flub = gls_batch_flush(fd);
+	}
+	gls_batch_close(fd);
+	return flub;
+}
+
+/**
+ * Forwards a single packet to the player connection from the most important
+ * of the first 'lanes' outbound lanes holding one.  Sets 'idle' if none do.
+ * The server writes each packet to a lane with a single atomic write, so a
+ * lane holding any bytes holds at least one whole packet; the rest of a frame
+ * larger than the pipe's atomic size is still being written by the server.
+ * Lanes always carry protocol 0, so a frame bound for a connection speaking
+ * another protocol has its packets re-encoded into a new frame.
+ */
+static struct flub* player_forward(struct player* player, int lanes,
+	int* idle) {
+	int bytes;
+	uint32_t count;
+	struct flub* flub;
+	int i;
+	struct gls_packet packet;
+	uint32_t protocol;
+
+	// Find the most important lane holding a packet.
+	*idle = 1;
+	for (i = 0; i < lanes; i++) {
+		if (ioctl(player->lanes[i][0], FIONREAD, &bytes) == -1) {
+			return g_flub_toss("Unable to check lane for packets: "
+				"'%s'", g_serr(errno));
+		}
+		if (bytes) {
+			break;
+		}
+	}
+	if (i == lanes) {
+		return NULL;
+	}
+
+	// Move packet from lane to socket.
+	*idle = 0;
+	if ((flub = gls_packet_read(&packet, player->lanes[i][0], 0))) {
+		return flub;
+	} else if (packet.header.event == GLS_EVENT_PROTOVERACK &&
+		packet.data.protoverack.ack) {
+		// Speak the accepted protocol from here on.
+		if ((flub = gls_packet_write(&packet, player->sockfd)) ||
+			(flub = gls_protocol_parse(
+			packet.data.protoverack.pver.version, &protocol))) {
+			return flub;
+		}
+		return gls_protocol_set(player->sockfd, protocol,
+			player->compression);
+	} else if (packet.header.event != GLS_EVENT_FRAME) {
+		return gls_packet_write(&packet, player->sockfd);
+	} else if (gls_protocol_get(player->sockfd)) {
+		// Re-encode frame's packets into a compact frame.
+		if ((flub = gls_batch_open(player->sockfd))) {
+			return flub;
+		}
+		count = packet.data.frame.count;
+		while (!flub && count--) {
+			if (!(flub = gls_packet_read(&packet,
+				player->lanes[i][0], 0))) {
+				flub = gls_packet_write(&packet,
+					player->sockfd);
+			}
+		}
+		if (!flub) {
+			flub = gls_batch_flush(player->sockfd);
+		}
+		gls_batch_close(player->sockfd);
+		return flub;
+	}
+
+	// Move frame's packets along with it.
+	if (gls_readn(player->lanes[i][0], player->frame,
+		packet.data.frame.length) < packet.data.frame.length) {
+		return g_flub_toss("Unable to read frame from lane: '%s'",
+			g_serr(errno));
+	}
+	return gls_frame_write(&packet.data.frame, player->frame,
+		player->sockfd);
+}
+
+/**
+ * Opens the pipe for the specified outbound lane.  Only the chat lane's write
+ * end is non-blocking, so the server can drop chat the player isn't keeping
+ * up with.
+ */
+static struct flub* player_lane_open(int* fds, int lane) {
+	int flags;
+	struct flub* flub;
+	int ret;
+	long size;
+
+	// Create pipe.
+	if (pipe(fds) == -1) {
+		return g_flub_toss("Unable to create lane pipe: '%s'",
+			g_serr(errno));
+	}
+
+	// Size pipe.
+	size = lane == PLAYER_LANE_CHAT ? G_PLAYER_CHAT_PIPE_SIZE :
+		G_PLAYER_PIPE_WRITE_SIZE;
+	ret = fcntl(fds[1], F_GETPIPE_SZ);
+	if (ret != size && fcntl(fds[1], F_SETPIPE_SZ, (int)size) == -1) {
+		flub = g_flub_toss("Unable to set lane pipe size to '%li': "
+			"'%s'", size, g_serr(errno));
+		goto out;
+	}
+	errno = 0;
+	size = fpathconf(fds[1], _PC_PIPE_BUF);
+	if (size == -1 && errno) {
+		flub = g_flub_toss("Unable to check lane atomicity: '%s'",
+			g_serr(errno));
+		goto out;
+	} else if (size != -1 && size < GLS_PIPE_BUF) {
+		flub = g_flub_toss("Lane atomicity too small, was '%li', "
+			">='%u' expected", size, GLS_PIPE_BUF);
+		goto out;
+	}
+	if (lane != PLAYER_LANE_CHAT) {
+		return NULL;
+	}
+
+	// Drop chat rather than block the server.
+	flags = fcntl(fds[1], F_GETFL);
+	if (flags == -1) {
+		flub = g_flub_toss("Unable to get lane flags: '%s'",
+			g_serr(errno));
+		goto out;
+	}
+	flags |= O_NONBLOCK;
+	if (fcntl(fds[1], F_SETFL, flags) == -1) {
+		flub = g_flub_toss("Unable to set non-blocking on lane: '%s'",
+			g_serr(errno));
+		goto out;
+	}
+	return NULL;
+
+out:
+	// Close pipe.
+	if (close(fds[0]) == -1) {
+		flub_append(flub, "unable to close lane read end (%s)",
+			g_serr(errno));
+	}
+	if (close(fds[1]) == -1) {
+		flub_append(flub, "unable to close lane write end (%s)",
+			g_serr(errno));
+	}
+	return flub;
+}
+
+/**
+ * Checks the specified placement against the board as the server last left
+ * it and, if the placement can't succeed, sends the player a Die Place
+ * Reject packet.  Dice and colors are only ever used up, so a placement
+ * rejected here would also be rejected by the server.  Returns nonzero if
+ * the placement was rejected and so must not be passed on to the server.
+ */
+static int player_place_reject(struct player* player,
+	struct gls_die_place_try* try) {
+	uint32_t color;
+	uint32_t die;
+	struct flub* flub;
+	int idle;
+	struct gls_die_place_reject reject;
+	uint32_t seq;
+
+	// Only synchronized players may place dice; leave the rest to the
+	// server.
+	if (!player->board ||
+		!__atomic_load_n(&player->synchronized, __ATOMIC_ACQUIRE)) {
+		return 0;
+	}
+
+	// Check placement.
+	memset(&reject, 0, sizeof(reject));
+	do {
+		seq = board_read_begin(player->board);
+		color = try->color;
+		flub = board_die_place_check(player->board, try->location,
+			&color, &die);
+		if (flub) {
+			strlcpy(reject.reason, flub->message,
+				GLS_DIE_PLACE_REJECT_REASON_LENGTH);
+		}
+	} while (board_read_retry(player->board, seq));
+	if (!flub) {
+		return 0;
+	}
+
+	// Send reject packet.
+	g_log_debug("Rejected placement at '%s' before the server: %s",
+		try->location, reject.reason);
+	strlcpy(reject.location, try->location, GLS_LOCATION_LENGTH);
+	reject.color = try->color;
+	do {
+		// Send game events already queued ahead of the reject,
+		// including the tail of the synchronization.
+		flub = player_forward(player, PLAYER_LANE_GAME + 1, &idle);
+	} while (!flub && !idle);
+	if (flub || (flub = gls_die_place_reject_write(&reject,
+		player->sockfd))) {
+		g_log_warn("Error sending die place reject: %s",
+			flub->message);
+	}
+	return 1;
+}
+
+static struct flub* player_plate_detail(struct player* player,
+	struct gls_plate_detail_req* req) {
+	struct gls_plate_detail detail;
+	struct flub* flub;
+	int idle;
+	uint32_t seq;
+
+	// Details follow the synchronization.
+	if (!player->board ||
+		!__atomic_load_n(&player->synchronized, __ATOMIC_ACQUIRE)) {
+		return g_flub_toss("Plate detail request before "
+			"synchronization");
+	}
+
+	// Look up plate.
+	do {
+		seq = board_read_begin(player->board);
+		flub = board_plate_detail(player->board, req->loc, &detail);
+	} while (board_read_retry(player->board, seq));
+	if (flub) {
+		return flub_append(flub, "looking up plate detail");
+	}
+
+	// Send game events already queued ahead of the detail, then the
+	// detail itself.
+	do {
+		flub = player_forward(player, PLAYER_LANE_GAME + 1, &idle);
+	} while (!flub && !idle);
+	if (flub || (flub = gls_plate_detail_write(&detail,
+		player->sockfd))) {
+		return flub_append(flub, "sending plate detail");
+	}
+	return NULL;
+}
+
+/**
+ * Moves a packet read from the socket to the server, unless the player's
+ * thread can handle it alone.  Packets of a frame always go to the server,
+ * so their replies come back in order within the frame answering it.
+ */
+static struct flub* player_receive(struct player* player,
+	struct gls_packet* packet, int framed) {
+	if (gls_event_length(packet->header.event) == GLS_LENGTH_UNKNOWN) {
+		// Skipped packet of a newer client.
+		return NULL;
+	} else if (framed) {
+		// Leave the frame's packets to the server.
+	} else if (packet->header.event == GLS_EVENT_PLATE_DETAIL_REQ) {
+		// Plates don't change, so answer directly.
+		return player_plate_detail(player,
+			&packet->data.plate_detail_req);
+	} else if (packet->header.event == GLS_EVENT_DIE_PLACE_TRY &&
+		player_place_reject(player, &packet->data.die_place_try)) {
+		// Placement rejected without the server.
+		return NULL;
+	}
+	return gls_packet_write(packet, player->pipe_server_to[1]);
+}
@@ -27,9 +27,16 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#include "board.h"
 #include "global.h"
 #include "gls.h"
 
+// Outbound lanes, in order of priority.
+#define PLAYER_LANE_GAME 0
+#define PLAYER_LANE_PRESENCE 1
+#define PLAYER_LANE_CHAT 2
+#define PLAYER_LANE_COUNT 3
+
 struct player {
 	// Thread-specific flub.
 	struct flub flub;
@@ -37,37 +44,67 @@ struct player {
 	char name[GLS_NICK_LENGTH];
 	// Player's nickname.
 	char nick[GLS_NICK_LENGTH];
-	// Pipes going to and from the server.
-	int pipe_server_from[2];
+	// Outbound lanes from the server, each a pipe holding whole packets.
+	// The player thread drains them to the connection in order of
+	// priority, so game events never queue behind presence or chat.  Only
+	// the chat lane is non-blocking; chat that doesn't fit is dropped.
+	int lanes[PLAYER_LANE_COUNT][2];
+	// Pipe going to the server.
 	int pipe_server_to[2];
-	// Player connection.
+	// Player connection; only written by the player thread.
 	int sockfd;
+	// Chat messages dropped because the chat lane was full.
+	uint32_t chat_dropped;
+	// Buffer for packets of frames moved from the lanes to the connection.
+	char* frame;
+	// Game board, read by the player thread to reject placements that
+	// can't succeed without waiting on the server.
+	struct board* board;
+	// Deflate level if the player asks for compression.
+	int compression;
+	// Compression counters of the connection, set when the thread exits.
+	struct gls_compress_stats sent;
+	struct gls_compress_stats received;
+	// Plates the player has cached, if it asked for a plate set.
+	struct gls_sync_req sync_req;
 	// Thread identifier.
 	pthread_t thread;
+	// Killed by server.  Set by the server thread and read by the
+	// player's, so it is a whole int accessed with atomics.
+	int killed;
+	// Game state synchronized.  Shared like 'killed'.
+	int synchronized;
 	// Authentication status.
 	unsigned authenticated:1;
 	// Connection open.
 	unsigned connected:1;
-	// Killed by server.
-	unsigned killed:1;
 	// Protover verified.
 	unsigned protoverokay:1;
-	// Game state synchronized.
-	unsigned synchronized:1;
+	// Synchronization requested before the nick.
+	unsigned sync_requested:1;
 };
 
+/**
+ * Returns nonzero if the player's chat lane may not have room for another
+ * packet, in which case chat for the player should be dropped.
+ */
+int player_chat_full(struct player* player);
+
 /**
  * Free possibly disconnected player.
  */
 void player_free(struct player* player, struct flub* status);
 
 /**
- * Initialize newly-connected player.
+ * Initialize newly-connected player playing on the specified board,
+ * compressing the connection at the specified deflate level if asked.
  */
-struct flub* player_init(struct player* player, int fd);
+struct flub* player_init(struct player* player, int fd, struct board* board,
+	int compression);
 
 /**
- * Force player to prepare for player_free.
+ * Force player to prepare for player_free.  Closes the player's outbound
+ * lanes, so any packets already queued are still sent.
  */
 struct flub* player_kill(struct player* player);
 
@@ -0,0 +1,112 @@
+/**
+ *  See 'registry.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "registry.h"
+
+static uint32_t registry_find(struct registry* registry, char* nick);
+
+struct flub* registry_add(struct registry* registry, char* nick,
+	struct player* player) {
+	uint32_t i;
+
+	// Find slot.
+	i = registry_find(registry, nick);
+	if (registry->entries[i].nick[0]) {
+		return g_flub_toss("Already in use");
+	} else if (registry->entry_count + 1 >= registry->entry_size) {
+		// Keep an empty slot to end probes.
+		return g_flub_toss("Nick registry full");
+	}
+
+	// Add entry.
+	strlcpy(registry->entries[i].nick, nick, GLS_NICK_LENGTH);
+	registry->entries[i].player = player;
+	registry->entry_count++;
+	return NULL;
+}
+
+void registry_free(struct registry* registry) {
+	free(registry->entries);
+	memset(registry, 0, sizeof(struct registry));
+}
+
+struct player* registry_get(struct registry* registry, char* nick) {
+	struct registry_entry* entry;
+
+	entry = &registry->entries[registry_find(registry, nick)];
+	return entry->nick[0] ? entry->player : NULL;
+}
+
+struct flub* registry_init(struct registry* registry, uint32_t capacity) {
+	uint32_t size;
+
+	// Size table to a power of two at least twice the capacity.
+	memset(registry, 0, sizeof(struct registry));
+	for (size = 16; size < 2 * capacity; size *= 2);
+	registry->entries = calloc(size, sizeof(struct registry_entry));
+	if (!registry->entries) {
+		return g_flub_toss("Unable to allocate nick registry");
+	}
+	registry->entry_size = size;
+	return NULL;
+}
+
+void registry_remove(struct registry* registry, char* nick) {
+	uint32_t home;
+	uint32_t i;
+	uint32_t j;
+	uint32_t mask;
+
+	// Find entry.
+	i = registry_find(registry, nick);
+	if (!registry->entries[i].nick[0]) {
+		return;
+	}
+	registry->entry_count--;
+
+	// Shift back any following entry whose probe passes through the freed
+	// slot.
+	mask = registry->entry_size - 1;
+	for (j = (i + 1) & mask; registry->entries[j].nick[0];
+		j = (j + 1) & mask) {
+		home = g_hash(registry->entries[j].nick,
+			strlen(registry->entries[j].nick)) & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			registry->entries[i] = registry->entries[j];
+			i = j;
+		}
+	}
+	memset(&registry->entries[i], 0, sizeof(struct registry_entry));
+}
+
+/**
+ * Returns the slot holding the specified nick, or the empty slot it would be
+ * added to.
+ */
+static uint32_t registry_find(struct registry* registry, char* nick) {
+	uint32_t i;
+	uint32_t mask;
+
+	mask = registry->entry_size - 1;
+	i = g_hash(nick, strlen(nick)) & mask;
+	while (registry->entries[i].nick[0] &&
+		strncmp(registry->entries[i].nick, nick, GLS_NICK_LENGTH)) {
+		i = (i + 1) & mask;
+	}
+	return i;
+}
@@ -0,0 +1,83 @@
+/**
+ *  Index of players by nick.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef registry_H
+#define registry_H
+
+#include "include.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "gls.h"
+#include "player.h"
+
+/**
+ * A registered nick.
+ */
+struct registry_entry {
+	// Nick, or empty for an unused slot.
+	char nick[GLS_NICK_LENGTH];
+	// Player holding the nick.
+	struct player* player;
+};
+
+/**
+ * Open-addressed table of the nicks in use, each mapped to the player
+ * holding it.  The table is sized for twice the player capacity so that it
+ * stays about half full even while a nick change holds both the old and new
+ * nick, and removal shifts later entries back into the freed slot instead of
+ * leaving tombstones, so lookups stay short no matter how often players
+ * join, part, and change nicks.
+ */
+struct registry {
+	struct registry_entry* entries;
+	uint32_t entry_count;
+	uint32_t entry_size;
+};
+
+/**
+ * Registers the specified nick to the specified player.  Returns a flub if
+ * the nick is already registered or the registry is full.
+ */
+struct flub* registry_add(struct registry* registry, char* nick,
+	struct player* player);
+
+/**
+ * Frees the registry.
+ */
+void registry_free(struct registry* registry);
+
+/**
+ * Returns the player holding the specified nick, or NULL if the nick isn't
+ * registered.
+ */
+struct player* registry_get(struct registry* registry, char* nick);
+
+/**
+ * Prepares a registry for the nicks of up to 'capacity' players.
+ */
+struct flub* registry_init(struct registry* registry, uint32_t capacity);
+
+/**
+ * Unregisters the specified nick if it is registered.
+ */
+void registry_remove(struct registry* registry, char* nick);
+
+#endif // registry_H
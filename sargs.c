@@ -0,0 +1,247 @@
+/**
+ *  Implementation of Dunbar's "Glass Plate Game" game, which is based off of
+ *  Herman Hesse's novel, "The Glass Bead Game".
+ *
+ *  Argument definitions and parser for the server.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "sargs.h"
+
+/**
+ * Parses the specified unsigned number into 'value', which must lie within
+ * the inclusive range from 'min' to 'max'.
+ */
+static struct flub* sargs_uint32(char* arg, uint32_t* value, uint32_t min,
+	uint32_t max) {
+	char* end;
+	unsigned long tmp;
+
+	errno = 0;
+	tmp = strtoul(arg, &end, 10);
+	if (errno || *end != '\0' || end == arg) {
+		return g_flub_toss("Invalid number '%s'", arg);
+	} else if (tmp < min || tmp > max) {
+		return g_flub_toss("Number '%s' not within '%u' to '%u'", arg,
+			min, max);
+	}
+	(*value) = (uint32_t)tmp;
+	return NULL;
+}
+
+void sargs_help(struct sargs* args, struct flub* flub) {
+	FILE* out;
+
+	// Print error.
+	if (flub) {
+		out = stderr;
+		fprintf(out, "ERROR: '%s'\n\n", flub->message);
+	} else {
+		out = stdout;
+	}
+
+	// Print usage.
+	fprintf(out, "glsd [ARGS]\n\nARGS:\n");
+	fprintf(out, "\t-C --catalog         Map plates from catalog file "
+		"(cur: '%s')\n", args->catalog ? args->catalog : "");
+	fprintf(out, "\t-c --columns         Number of board columns (default: "
+		"'%u', cur: '%u')\n", GLS_BOARD_COLUMN_COUNT, args->columns);
+	fprintf(out, "\t-z --compression     Deflate level for compressing "
+		"connections, 0 to refuse (default: '%u', cur: '%u')\n",
+		SARGS_COMPRESSION, args->compression);
+	fprintf(out, "\t-k --checkpoint      Checkpoint the board to and start "
+		"from file (cur: '%s')\n",
+		args->checkpoint ? args->checkpoint : "");
+	fprintf(out, "\t-K --checkpoint-interval  Seconds between checkpoints "
+		"(default: '%u', cur: '%u')\n", CHECKPOINT_INTERVAL,
+		args->checkpoint_interval);
+	fprintf(out, "\t-d --dice            Number of dice, at most one per "
+		"color (max: '%u', default: '%u', cur: '%u')\n", GLS_COLOR_MAX,
+		GLS_DIE_COUNT, args->dice);
+	fprintf(out, "\t-h --help            Print this usage message\n");
+	fprintf(out, "\t-I --catalog-import  Build catalog from tab-separated "
+		"'abbrev, name, description' lines\n");
+	fprintf(out, "\t-j --journal         Record and recover game events "
+		"with journal file (cur: '%s')\n",
+		args->journal ? args->journal : "");
+	fprintf(out, "\t-P --primary         Replicate the game from the "
+		"primary's replica socket (cur: '%s')\n",
+		args->primary ? args->primary : "");
+	fprintf(out, "\t-r --rows            Number of board rows (default: "
+		"'%u', cur: '%u')\n", GLS_BOARD_ROW_COUNT, args->rows);
+	fprintf(out, "\t-s --snapshot-interval  Journal records between "
+		"snapshots (default: '%u', cur: '%u')\n",
+		JOURNAL_SNAPSHOT_INTERVAL, args->snapshot_interval);
+	fprintf(out, "\t-S --spectator-port  Accept read-only spectators on "
+		"port (cur: '%u')\n", args->spectator_port);
+	fprintf(out, "\t-t --tick            Batch events into frames sent "
+		"every tick milliseconds (cur: '%u')\n", args->tick);
+	fprintf(out, "\t-U --replica-socket  Accept replicas on unix socket "
+		"(cur: '%s')\n", args->replica_socket ?
+		args->replica_socket : "");
+	fprintf(out, "\t-W --catalog-write   Write catalog file then exit\n");
+
+	// Exit program.
+	if (flub) {
+		exit(EXIT_FAILURE);
+	} else {
+		exit(EXIT_SUCCESS);
+	}
+}
+
+struct flub* sargs_parse(struct sargs* args, int argc, char* argv[]) {
+	struct flub* flub;
+	struct option longopts[] = {
+		{"catalog", 1, NULL, 'C'},
+		{"catalog-import", 1, NULL, 'I'},
+		{"catalog-write", 1, NULL, 'W'},
+		{"checkpoint", 1, NULL, 'k'},
+		{"checkpoint-interval", 1, NULL, 'K'},
+		{"columns", 1, NULL, 'c'},
+		{"dice", 1, NULL, 'd'},
+		{"help", 0, NULL, 'h'},
+		{"journal", 1, NULL, 'j'},
+		{"primary", 1, NULL, 'P'},
+		{"replica-socket", 1, NULL, 'U'},
+		{"rows", 1, NULL, 'r'},
+		{"snapshot-interval", 1, NULL, 's'},
+		{"spectator-port", 1, NULL, 'S'},
+		{"tick", 1, NULL, 't'},
+		{"compression", 1, NULL, 'z'},
+		{0, 0, 0, 0}
+	};
+	int ret;
+
+	// Set defaults.
+	memset(args, 0, sizeof(struct sargs));
+	args->checkpoint_interval = CHECKPOINT_INTERVAL;
+	args->columns = GLS_BOARD_COLUMN_COUNT;
+	args->compression = SARGS_COMPRESSION;
+	args->dice = GLS_DIE_COUNT;
+	args->rows = GLS_BOARD_ROW_COUNT;
+	args->snapshot_interval = JOURNAL_SNAPSHOT_INTERVAL;
+
+	// Parse arguments.
+	while((ret = getopt_long(argc, argv,
+		":C:c:d:hI:j:k:K:P:r:s:S:t:U:W:z:", longopts, NULL)) != -1) {
+		switch(ret) {
+		case 'C':
+			args->catalog = optarg;
+			break;
+		case 'c':
+			if ((flub = sargs_uint32(optarg, &args->columns, 1,
+				GLS_BOARD_COLUMN_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 'd':
+			// Each color places a single die.
+			if ((flub = sargs_uint32(optarg, &args->dice, 1,
+				GLS_COLOR_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 'h':
+			sargs_help(args, NULL);
+		case 'I':
+			args->catalog_import = optarg;
+			break;
+		case 'j':
+			args->journal = optarg;
+			break;
+		case 'k':
+			args->checkpoint = optarg;
+			break;
+		case 'K':
+			if ((flub = sargs_uint32(optarg,
+				&args->checkpoint_interval, 0, UINT32_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 'P':
+			args->primary = optarg;
+			break;
+		case 'r':
+			if ((flub = sargs_uint32(optarg, &args->rows, 1,
+				GLS_BOARD_ROW_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 's':
+			if ((flub = sargs_uint32(optarg,
+				&args->snapshot_interval, 1, UINT32_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 'S':
+			if ((flub = sargs_uint32(optarg,
+				&args->spectator_port, 1, UINT16_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 't':
+			if ((flub = sargs_uint32(optarg, &args->tick, 0,
+				SARGS_TICK_MAX))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 'U':
+			args->replica_socket = optarg;
+			break;
+		case 'z':
+			if ((flub = sargs_uint32(optarg, &args->compression, 0,
+				Z_BEST_COMPRESSION))) {
+				sargs_help(args, flub);
+			}
+			break;
+		case 'W':
+			args->catalog_write = optarg;
+			break;
+		case ':':
+			flub = g_flub_toss("Missing argument after '%c'",
+				optopt);
+			sargs_help(args, flub);
+		case '?':
+			// Unknown option.
+			if (optopt) {
+				flub = g_flub_toss("Unknown argument '%c'",
+					optopt);
+			} else {
+				flub = g_flub_toss("Unknown longopt at index "
+					"'%i'", optind);
+			}
+			sargs_help(args, flub);
+		default:
+			// Error!
+			flub = g_flub_toss("Unable to parse arguments");
+			sargs_help(args, flub);
+		}
+	}
+	if (args->catalog && args->catalog_import) {
+		flub = g_flub_toss("Cannot both map and import a catalog");
+		sargs_help(args, flub);
+	}
+	if (args->primary && (args->journal || args->checkpoint)) {
+		flub = g_flub_toss("Replicas cannot journal or checkpoint");
+		sargs_help(args, flub);
+	}
+	if (args->primary && !args->spectator_port && !args->replica_socket) {
+		flub = g_flub_toss("Replicas need spectators or replicas to "
+			"serve");
+		sargs_help(args, flub);
+	}
+	return NULL;
+}
@@ -0,0 +1,84 @@
+/**
+ *  Implementation of Dunbar's "Glass Plate Game" game, which is based off of
+ *  Herman Hesse's novel, "The Glass Bead Game".
+ *
+ *  Argument definitions and parser for the server.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef sargs_H
+#define sargs_H
+
+#include "include.h"
+
+#include <getopt.h>
+
+#include "checkpoint.h"
+#include "gls.h"
+#include "journal.h"
+
+// Default deflate level of compressing connections.
+#define SARGS_COMPRESSION 6
+// Longest tick between frames, in milliseconds.
+#define SARGS_TICK_MAX 1000
+
+// Server arguments.
+struct sargs {
+	// Path to a catalog file to map, or NULL for the default catalog.
+	char* catalog;
+	// Path to a plate text file to import into the catalog, or NULL.
+	char* catalog_import;
+	// Path to write the catalog to before exiting, or NULL.
+	char* catalog_write;
+	// Path to the checkpoint file, or NULL to run without one.
+	char* checkpoint;
+	// Seconds between checkpoints.
+	uint32_t checkpoint_interval;
+	// Number of board columns.
+	uint32_t columns;
+	// Deflate level for connections asking for compression, or zero to
+	// refuse compression.
+	uint32_t compression;
+	// Number of dice on the board.
+	uint32_t dice;
+	// Path to the game journal, or NULL to run without one.
+	char* journal;
+	// Number of board rows.
+	uint32_t rows;
+	// Path to the primary's replica socket to replicate from, or NULL to
+	// run the game.
+	char* primary;
+	// Path to a unix socket to accept replicas on, or NULL.
+	char* replica_socket;
+	// Journal records between board snapshots.
+	uint32_t snapshot_interval;
+	// Port to accept spectators on, or zero to run without spectators.
+	uint32_t spectator_port;
+	// Milliseconds between frames of batched events, or zero to send each
+	// event as it happens.
+	uint32_t tick;
+};
+
+// Print help message for server arguments then exit the program.
+// If a flub is specified then output is sent to stderr instead of stdout
+// and the program exits with failure rather than success.
+void sargs_help(struct sargs* args, struct flub* flub);
+
+// Parse server arguments.
+struct flub* sargs_parse(struct sargs* args, int argc, char* argv[]);
+
+#endif // sargs_H
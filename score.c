@@ -0,0 +1,100 @@
+/**
+ *  See 'score.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "score.h"
+
+static struct score_player* score_find(struct score* score, char* nick);
+
+struct flub* score_add(struct score* score, char* nick, uint32_t points,
+	uint32_t* total) {
+	struct score_player* player;
+
+	// Grow table to keep it at most half full.
+	if (score->player_size < 2 * (score->player_count + 1)) {
+		struct score_player* players;
+		uint32_t i;
+		uint32_t j;
+		uint32_t size;
+
+		size = score->player_size ? score->player_size * 2 : 64;
+		players = calloc(size, sizeof(struct score_player));
+		if (!players) {
+			return g_flub_toss("Unable to allocate scores");
+		}
+		for (i = 0; i < score->player_size; i++) {
+			if (!score->players[i].nick[0]) {
+				continue;
+			}
+			j = g_hash(score->players[i].nick,
+				strlen(score->players[i].nick)) & (size - 1);
+			while (players[j].nick[0]) {
+				j = (j + 1) & (size - 1);
+			}
+			players[j] = score->players[i];
+		}
+		free(score->players);
+		score->players = players;
+		score->player_size = size;
+	}
+
+	// Add points.
+	player = score_find(score, nick);
+	if (!player->nick[0]) {
+		strlcpy(player->nick, nick, GLS_NICK_LENGTH);
+		score->player_count++;
+	}
+	player->points += points;
+	(*total) = player->points;
+	return NULL;
+}
+
+void score_free(struct score* score) {
+	free(score->players);
+	memset(score, 0, sizeof(struct score));
+}
+
+uint32_t score_get(struct score* score, char* nick) {
+	struct score_player* player;
+
+	if (!score->player_size) {
+		return 0;
+	}
+	player = score_find(score, nick);
+	return player->nick[0] ? player->points : 0;
+}
+
+void score_init(struct score* score) {
+	memset(score, 0, sizeof(struct score));
+}
+
+/**
+ * Returns the slot holding the specified player, or the empty slot the player
+ * would be added to.  The table must not be empty.
+ */
+static struct score_player* score_find(struct score* score, char* nick) {
+	uint32_t i;
+	uint32_t mask;
+
+	mask = score->player_size - 1;
+	i = g_hash(nick, strlen(nick)) & mask;
+	while (score->players[i].nick[0] &&
+		strncmp(score->players[i].nick, nick, GLS_NICK_LENGTH)) {
+		i = (i + 1) & mask;
+	}
+	return &score->players[i];
+}
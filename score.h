@@ -0,0 +1,77 @@
+/**
+ *  Running per-player and per-color game scores.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef score_H
+#define score_H
+
+#include "include.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "gls.h"
+
+/**
+ * A player's score.
+ */
+struct score_player {
+	// Player, or empty for an unused slot.
+	char nick[GLS_NICK_LENGTH];
+	// Points scored.
+	uint32_t points;
+};
+
+/**
+ * Scores of a game, kept as running totals so that each move costs a
+ * constant amount of work instead of a rescan of the board.  Players are
+ * held in an open-addressed table keyed by nick which is kept at most half
+ * full.  Scores follow the nick a move was made under.
+ */
+struct score {
+	// Player table.
+	struct score_player* players;
+	uint32_t player_count;
+	uint32_t player_size;
+	// Points scored with each color.
+	uint32_t colors[GLS_COLOR_MAX + 1];
+};
+
+/**
+ * Adds points to the specified player's score, adding the player if needed,
+ * and outputs the player's new total.
+ */
+struct flub* score_add(struct score* score, char* nick, uint32_t points,
+	uint32_t* total);
+
+/**
+ * Frees the scores.
+ */
+void score_free(struct score* score);
+
+/**
+ * Returns the specified player's score, or zero if the player hasn't scored.
+ */
+uint32_t score_get(struct score* score, char* nick);
+
+/**
+ * Starts an empty set of scores.
+ */
+void score_init(struct score* score);
+
+#endif // score_H
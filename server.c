@@ -31,12 +31,129 @@ void server_handler(int sig) {
 	}
 }
 
-struct flub* server_init(struct server* server) {
+struct flub* server_catalog(struct catalog* catalog, struct sargs* args) {
+	struct flub* flub;
+
+	// Map, import, or build the catalog.
+	if (args->catalog) {
+		flub = catalog_map(catalog, args->catalog);
+	} else if (args->catalog_import) {
+		catalog_init(catalog);
+		flub = catalog_import(catalog, args->catalog_import);
+	} else {
+		flub = catalog_default(catalog);
+	}
+	if (flub) {
+		catalog_free(catalog);
+		return flub_append(flub, "loading catalog");
+	}
+	return NULL;
+}
+
+struct flub* server_init(struct server* server, struct sargs* args) {
+	struct flub* flub;
+	int loaded;
+	uint64_t seq;
 	int sockfd;
 
+	// Load plate catalog; replicas learn their plates from the primary.
+	if (args->primary) {
+		catalog_init(&server->catalog);
+	} else if ((flub = server_catalog(&server->catalog, args))) {
+		return flub;
+	}
+
 	// Create a new game.
-	board_init(&server->board);
+	if ((flub = board_init(&server->board, &server->catalog, args->rows,
+		args->columns, args->dice))) {
+		return flub_append(flub, "creating board");
+	}
+	if (!args->primary && (flub = board_deck(&server->board))) {
+		return flub_append(flub, "creating board");
+	}
+
+	// Resume game from the last checkpoint.
+	seq = 0;
+	server->checkpointing = 0;
+	if (args->checkpoint) {
+		if ((flub = checkpoint_open(&server->checkpoint,
+			args->checkpoint, args->checkpoint_interval,
+			&server->board, &seq, &loaded))) {
+			return flub;
+		}
+		server->checkpointing = 1;
+	}
+
+	// Recover game from journal.
+	server->journaling = 0;
+	if (args->journal) {
+		if ((flub = journal_open(&server->journal, args->journal,
+			args->snapshot_interval, &server->board, seq))) {
+			return flub_append(flub, "opening journal");
+		}
+		server->journaling = 1;
+	}
+
+	// Start history from the recovered board.
+	if ((flub = history_init(&server->history, &server->board))) {
+		return flub_append(flub, "starting history");
+	}
 	memset(server->players, 0, sizeof(struct player) * SERVER_PLAYER_MAX);
+	if ((flub = registry_init(&server->registry, SERVER_PLAYER_MAX))) {
+		return flub;
+	}
+	if ((flub = interest_init(&server->interest, server->board.rows,
+		server->board.columns, SERVER_PLAYER_MAX))) {
+		return flub;
+	}
+
+	// Batch events into frames and compress connections asking for it.
+	server->compression = args->compression;
+	server->tick = args->tick;
+	if (clock_gettime(CLOCK_MONOTONIC, &server->ticked) == -1) {
+		return g_flub_toss("Unable to get tick time: '%s'",
+			g_serr(errno));
+	}
+
+	// Accept spectators and replicas.
+	server->spectating = 0;
+	if (args->spectator_port || args->replica_socket) {
+		if ((flub = spectator_open(&server->spectator,
+			args->spectator_port, args->replica_socket))) {
+			return flub;
+		}
+		server->spectating = 1;
+	}
+
+	// Connect to the primary instead of accepting players.
+	server->primary = -1;
+	server->replicating = 0;
+	server->sockfd = -1;
+	server->running = 0;
+	if (args->primary) {
+		struct sockaddr_un sockaddr_un;
+
+		memset(&sockaddr_un, 0, sizeof(struct sockaddr_un));
+		sockaddr_un.sun_family = AF_UNIX;
+		if (strlcpy(sockaddr_un.sun_path, args->primary,
+			sizeof(sockaddr_un.sun_path)) >=
+			sizeof(sockaddr_un.sun_path)) {
+			return g_flub_toss("Primary socket path too long");
+		}
+		server->primary = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC,
+			0);
+		if (server->primary == -1) {
+			return g_flub_toss("Unable to create primary socket: "
+				"'%s'", g_serr(errno));
+		}
+		if (connect(server->primary, (struct sockaddr*)&sockaddr_un,
+			sizeof(struct sockaddr_un)) == -1) {
+			return g_flub_toss("Unable to connect to primary "
+				"'%s': '%s'", args->primary, g_serr(errno));
+		}
+		server->replicating = 1;
+		return NULL;
+	}
 
 	// Set up socket.
 	sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
@@ -59,8 +176,6 @@ struct flub* server_init(struct server* server) {
 			g_serr(errno));
 	}
 
-	// Not running.
-	server->running = 0;
 	return NULL;
 }
 
@@ -68,31 +183,38 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 	struct gls_packet packet_in;
 	struct gls_packet packet_out;
 	struct flub* flub;
+	struct gls_view view;
 
-	// Get player's packet.
-	memset(&packet_in, 0, sizeof(struct gls_packet));
-	flub = gls_packet_read(&packet_in, player->pipe_server_to[0], 0);
+	// Get player's packet in place; its thread already validated it.
+	flub = gls_view_read(&view, player->pipe_server_to[0], 0);
 	if (flub) {
 		return flub;
+	} else if (view.header.event == GLS_EVENT_FRAME) {
+		// The player's thread only frames packets of synchronized
+		// players, never frames themselves.
+		return server_player_batch(server, player, &view.data.frame);
 	}
 
 	// Handle client data.
 	if (!player->protoverokay) { // Protocol version exchange.
-		char* protocol = "0.0";
-		struct gls_protover* pver;
+		struct gls_protover_wire* pver;
 		struct gls_protoverack* pack;
+		uint32_t protocol;
 		int accepted;
 
 		// Validate client protover.
-		if (packet_in.header.event != GLS_EVENT_PROTOVER) {
+		if (view.header.event != GLS_EVENT_PROTOVER) {
 			return g_flub_toss("Expected protover event, got '%u'",
-				packet_in.header.event);
+				view.header.event);
 		}
-		pver = &packet_in.data.protover;
+		pver = &view.data.protover;
 		accepted = 1;
-		if (strncmp(pver->version, protocol,
-			GLS_PROTOVER_VERSION_LENGTH)) {
+		if ((flub = gls_protocol_parse(pver->version, &protocol))) {
 			accepted = 0;
+			protocol = GLS_PROTOCOL_0;
+		} else if (protocol == GLS_PROTOCOL_2 && !server->compression) {
+			// Offer the same packets uncompressed.
+			protocol = GLS_PROTOCOL_1;
 		}
 
 		// Return protover ack.
@@ -101,107 +223,85 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 		pack = &packet_out.data.protoverack;
 		pack->ack = accepted;
 		if (!accepted) {
-			snprintf(pack->reason, GLS_PROTOVER_REASON_LENGTH,
-				"Invalid protocol version '%s' (expected '%s')",
-				pver->version, protocol);
+			strlcpy(pack->reason, flub->message,
+				GLS_PROTOVER_REASON_LENGTH);
 		}
 		strlcpy(pack->pver.magic, "GLS", GLS_PROTOVER_MAGIC_LENGTH);
-		strlcpy(pack->pver.version, "0.0", GLS_PROTOVER_VERSION_LENGTH);
+		strlcpy(pack->pver.version, gls_protocol_versions[protocol],
+			GLS_PROTOVER_VERSION_LENGTH);
 		strlcpy(pack->pver.software, "glsd",
 			GLS_PROTOVER_SOFTWARE_LENGTH);
-		flub = gls_packet_write(&packet_out, player->sockfd);
+		flub = gls_packet_write(&packet_out,
+			player->lanes[PLAYER_LANE_GAME][1]);
 		if (!accepted) {
 			return g_flub_toss("Protcol version not accepted: %s",
 				pack->reason);
 		}
 		player->protoverokay = 1;
 	} else if (!player->authenticated) { // Expect nick request.
-		int i;
-		int j;
-		struct gls_sync_end sync;
+		int fd;
+		int lane;
+
+		// Note the plates the player has cached.
+		if (view.header.event == GLS_EVENT_SYNC_REQ) {
+			gls_sync_req_decode(&player->sync_req,
+				&view.data.sync_req);
+			player->sync_requested = 1;
+			return NULL;
+		}
 
 		// Read nick request.
-		if (packet_in.header.event != GLS_EVENT_NICK_REQ) {
+		if (view.header.event != GLS_EVENT_NICK_REQ) {
 			return g_flub_toss("Expected nick request during "
 				"protoverokay phase");
 		}
 
 		// Process nick request (updates player to auth).
+		gls_nick_req_decode(&packet_in.data.nick_req,
+			&view.data.nick_req);
 		flub = server_player_nick(server, player,
 			&packet_in.data.nick_req);
 		if (flub) {
 			return flub_append(flub, "processing player data");
 		}
 
-		// Synchronize game state.
-		// Send plates.
-		for (i = 0; i < GLS_BOARD_ROW_COUNT; i++) {
-			for (j = 0; j < GLS_BOARD_COLUMN_COUNT; j++) {
-				struct gls_plate_place place;
-				struct plate* plate;
-				char loc[3];
-
-				// Prepare packet.
-				memset(&place, 0, sizeof(place));
-				plate = &server->board.plates[i][j];
-				strlcpy(place.abbrev, plate->abbrev,
-					GLS_PLATE_ABBREV_LENGTH);
-				strlcpy(place.description, plate->description,
-					GLS_PLATE_DESCRIPTION_LENGTH);
-				strlcpy(place.name, plate->name,
-					GLS_PLATE_NAME_LENGTH);
-				loc[0] = 'A' + i;
-				loc[1] = '1' + j;
-				loc[2] = '\0';
-				strlcpy(place.loc, loc, GLS_LOCATION_LENGTH);
-				place.flags = plate->empty ?
-					GLS_PLATE_FLAG_EMPTY : 0;
-
-				// Send packet.
-				if ((flub = gls_plate_place_write(&place,
-					player->sockfd))) {
-					return flub_append(flub, "sending plate");
-
-				}
-			}
+		// Synchronize game state in as few frames as fit.
+		fd = player->lanes[PLAYER_LANE_GAME][1];
+		if ((flub = gls_batch_open(fd)) ||
+			(flub = server_sync(server, fd, player->sync_requested ?
+			&player->sync_req : NULL)) ||
+			(flub = gls_batch_flush(fd))) {
+			return flub;
 		}
-		// Send die placements.
-		for (i = 0; i < GLS_DIE_MAX; i++) {
-			if (!strlen(server->board.dice[i].location)) {
-				// Die not placed.
-				continue;
-			}
-			struct gls_die_place place;
-			struct die* die = &server->board.dice[i];
-			memset(&place, 0, sizeof(place));
-			strlcpy(place.location, die->location,
-				GLS_LOCATION_LENGTH);
-			strlcpy(place.nick, die->nick, GLS_NICK_LENGTH);
-			place.color = die->color;
-			place.die = i;
-			if ((flub = gls_die_place_write(&place,
-				player->sockfd))) {
-				return flub_append(flub, "placing die");
+		gls_batch_close(fd);
+		// The player's thread rejects placements itself only once the
+		// synchronization is queued ahead of its rejects.
+		__atomic_store_n(&player->synchronized, 1, __ATOMIC_RELEASE);
+
+		// Batch further events into frames.
+		for (lane = 0; server->tick && lane < PLAYER_LANE_COUNT;
+			lane++) {
+			if ((flub = gls_batch_open(player->lanes[lane][1]))) {
+				return flub;
 			}
 		}
-		// Sync end.
-		memset(&sync, 0, sizeof(struct gls_sync_end));
-		strlcpy(sync.motd, "Welcome to the Glass Plate Game test "
-			"server!", GLS_MOTD_LENGTH);
-		if ((flub = gls_sync_end_write(&sync, player->sockfd))) {
-			return flub_append(flub, "synchronizing player");
-		}
-		player->synchronized = 1;
 	} else { // Client generated packet.
+		uint32_t color;
+		uint32_t column;
 		uint32_t die;
-		int i;
+		uint32_t dropped;
+		uint32_t i;
+		uint64_t interested[INTEREST_WORDS(SERVER_PLAYER_MAX)];
+		uint32_t row;
 		struct gls_die_place* place;
-		struct gls_say1* say1;
 		struct gls_say2* say2;
+		struct gls_die_place_try_wire* try;
 
-		switch(packet_in.header.event) {
+		switch(view.header.event) {
 		case GLS_EVENT_NICK_REQ:
 			// Process nick request.
+			gls_nick_req_decode(&packet_in.data.nick_req,
+				&view.data.nick_req);
 			flub = server_player_nick(server, player,
 				&packet_in.data.nick_req);
 			if (flub) {
@@ -209,9 +309,54 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 					"data");
 			}
 			break;
+		case GLS_EVENT_CONNECT_TRY:
+			// Connect dice.
+			gls_connect_try_decode(&packet_in.data.connect_try,
+				&view.data.connect_try);
+			if ((flub = server_player_connect(server, player,
+				&packet_in.data.connect_try))) {
+				return flub_append(flub, "processing player "
+					"data");
+			}
+			break;
+		case GLS_EVENT_SUBSCRIBE:
+			// Change subscription.
+			gls_subscribe_decode(&packet_in.data.subscribe,
+				&view.data.subscribe);
+			if ((flub = server_player_subscribe(server, player,
+				&packet_in.data.subscribe))) {
+				return flub_append(flub, "processing player "
+					"data");
+			}
+			break;
+		case GLS_EVENT_HISTORY_REQ:
+			// Send history.
+			gls_history_req_decode(&packet_in.data.history_req,
+				&view.data.history_req);
+			if ((flub = server_player_history(server, player,
+				&packet_in.data.history_req))) {
+				return flub_append(flub, "processing player "
+					"data");
+			}
+			break;
+		case GLS_EVENT_PLATE_DETAIL_REQ:
+			// Answer a detail request sent in a frame; the
+			// player's thread answers the rest itself.
+			gls_plate_detail_req_decode(
+				&packet_in.data.plate_detail_req,
+				&view.data.plate_detail_req);
+			if ((flub = board_plate_detail(&server->board,
+				packet_in.data.plate_detail_req.loc,
+				&packet_out.data.plate_detail)) ||
+				(flub = gls_plate_detail_write(
+				&packet_out.data.plate_detail,
+				player->lanes[PLAYER_LANE_GAME][1]))) {
+				return flub_append(flub, "answering plate "
+					"detail request");
+			}
+			break;
 		case GLS_EVENT_SAY1:
 			// Prepare say2 packet.
-			say1 = &packet_in.data.say1;
 			say2 = &packet_out.data.say2;
 			memset(say2, 0, sizeof(struct gls_say2));
 			strlcpy(say2->nick, player->nick, GLS_NICK_LENGTH);
@@ -220,7 +365,7 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 				return g_flub_toss("Unable to get time for "
 					"Say2 packet: '%s'", g_serr(errno));
 			}
-			strlcpy(say2->message, say1->message,
+			strlcpy(say2->message, view.data.say1.message,
 				GLS_SAY_MESSAGE_LENGTH);
 
 			// Send say2 packets.
@@ -229,8 +374,23 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 				if (!server->players[i].authenticated) {
 					continue;
 				}
-				if ((flub = gls_say2_write(say2,
-					server->players[i].sockfd))) {
+				if (player_chat_full(&server->players[i])) {
+					// Player not keeping up with chat;
+					// drop the message.
+					dropped = ++server->players[i]
+						.chat_dropped;
+					if (!(dropped & (dropped - 1))) {
+						g_log_debug("Dropped %u "
+							"messages for player "
+							"'%s'", dropped,
+							player_name(&server->
+							players[i]));
+					}
+					continue;
+				}
+				flub = gls_say2_write(say2, server->players[i]
+					.lanes[PLAYER_LANE_CHAT][1]);
+				if (flub) {
 					g_log_warn("Unable to message player "
 						"'%s': '%s'",
 						player_name(&server->players[i]),
@@ -238,28 +398,34 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 					player_kill(&server->players[i]);
 				}
 			}
+			if (server->spectating && ((flub = gls_say2_write(
+				say2, server->spectator.events)) ||
+				(flub = spectator_publish(
+				&server->spectator)))) {
+				g_log_error("Unable to message spectators: "
+					"'%s'", flub->message);
+			}
 			break;
 		case GLS_EVENT_DIE_PLACE_TRY:
 			// Place die on board.
+			try = &view.data.die_place_try;
+			color = gls_be32_get(&try->color);
 			if ((flub = board_die_place(&server->board,
-				player->nick,
-				packet_in.data.die_place_try.location,
-				&packet_in.data.die_place_try.color, &die))) {
+				player->nick, try->location, &color, &die))) {
 				// Die not valid; send reject packet.
 				struct gls_die_place_reject* reject;
 				reject = &packet_out.data.die_place_reject;
 				memset(&packet_out, 0, sizeof(packet_out));
 				packet_out.header.event =
 					GLS_EVENT_DIE_PLACE_REJECT;
-				strlcpy(reject->location,
-					packet_in.data.die_place_try.location,
+				strlcpy(reject->location, try->location,
 					GLS_LOCATION_LENGTH);
-				reject->color =
-					packet_in.data.die_place_try.color;
+				reject->color = color;
 				strlcpy(reject->reason, flub->message,
 					GLS_DIE_PLACE_REJECT_REASON_LENGTH);
-				if ((flub = gls_die_place_reject_write(reject,
-					player->sockfd))) {
+				flub = gls_die_place_reject_write(reject,
+					player->lanes[PLAYER_LANE_GAME][1]);
+				if (flub) {
 					// Unable to send reject packet.
 					g_log_warn("Error sending die place "
 						"reject to player '%s': %s",
@@ -271,23 +437,44 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 				break;
 			}
 
+			// Record placed die.
+			if ((flub = history_push(&server->history))) {
+				g_log_error("Unable to record history: '%s'",
+					flub->message);
+			}
+			if (server->journaling && ((flub = journal_die_place(
+				&server->journal, player->nick, try->location,
+				color, die)) ||
+				(flub = journal_snapshot(&server->journal,
+				&server->board)))) {
+				g_log_error("Unable to journal die: '%s'",
+					flub->message);
+			}
+
 			// Notify players of placed die.
 			memset(&packet_out, 0, sizeof(packet_out));
 			packet_out.header.event = GLS_EVENT_DIE_PLACE;
 			place = &packet_out.data.die_place;
-			strlcpy(place->location,
-				packet_in.data.die_place_try.location,
+			strlcpy(place->location, try->location,
 				GLS_LOCATION_LENGTH);
-			place->color = packet_in.data.die_place_try.color;
+			place->color = color;
 			strlcpy(place->nick, player->nick, GLS_NICK_LENGTH);
 			place->die = die;
-			for (i = 0; i < SERVER_PLAYER_MAX; i++) {
-				// Send place packet to each player.
+			board_location_parse(&server->board, place->location,
+				&row, &column);
+			interest_get(&server->interest, row, column,
+				interested);
+			interest_set(interested, player - server->players);
+			while (interest_next(interested,
+				INTEREST_WORDS(SERVER_PLAYER_MAX), &i)) {
+				// Send place packet to each interested player.
 				if (!server->players[i].authenticated) {
 					continue;
 				}
-				if ((flub = gls_die_place_write(place,
-					server->players[i].sockfd))) {
+				flub = gls_die_place_write(place,
+					server->players[i]
+					.lanes[PLAYER_LANE_GAME][1]);
+				if (flub) {
 					g_log_warn("Unable to place die for "
 						"player '%s': '%s'",
 						player_name(
@@ -296,15 +483,210 @@ struct flub* server_player_data(struct server* server, struct player* player) {
 					player_kill(&server->players[i]);
 				}
 			}
+			if (server->spectating && ((flub = gls_die_place_write(
+				place, server->spectator.events)) ||
+				(flub = spectator_publish(
+				&server->spectator)))) {
+				g_log_error("Unable to place die for "
+					"spectators: '%s'", flub->message);
+			}
 			g_log_info("Player '%s' placed die '%u' (%s) at '%s'",
 				player->nick, die,
 				gls_color_names[
 					packet_out.data.die_place.color],
 				packet_out.data.die_place.location);
+			server_score(server, player->nick,
+				packet_out.data.die_place.color);
 			break;
 		default:
 			return g_flub_toss("Unsupported event type '%i' from "
-				"player", packet_in.header.event);
+				"player", view.header.event);
+		}
+	}
+	return NULL;
+}
+
+struct flub* server_player_batch(struct server* server, struct player* player,
+	struct gls_frame* frame) {
+	struct flub* flub;
+	uint32_t i;
+	int lane;
+
+	// Batch the player's lanes unless the tick already does.
+	for (lane = 0; !server->tick && lane < PLAYER_LANE_COUNT; lane++) {
+		if ((flub = gls_batch_open(player->lanes[lane][1]))) {
+			return flub;
+		}
+	}
+
+	// Process the frame's packets, then send what they caused.
+	flub = NULL;
+	for (i = 0; !flub && i < frame->count; i++) {
+		flub = server_player_data(server, player);
+	}
+	if (!flub && !server->tick) {
+		flub = server_player_frame(server, player);
+	}
+	for (lane = 0; !server->tick && lane < PLAYER_LANE_COUNT; lane++) {
+		gls_batch_close(player->lanes[lane][1]);
+	}
+	return flub;
+}
+
+void server_player_compression(struct player* player) {
+	// Log counters, so the deflate level can be tuned against them.
+	if (!player->sent.plain && !player->received.plain) {
+		return;
+	}
+	g_log_info("Player '%s' compression: sent '%llu' bytes as '%llu' in "
+		"'%llu' us, received '%llu' bytes as '%llu' in '%llu' us",
+		player->nick, (unsigned long long)player->sent.plain,
+		(unsigned long long)player->sent.compressed,
+		(unsigned long long)player->sent.nanoseconds / 1000,
+		(unsigned long long)player->received.plain,
+		(unsigned long long)player->received.compressed,
+		(unsigned long long)player->received.nanoseconds / 1000);
+}
+
+struct flub* server_player_connect(struct server* server,
+	struct player* player, struct gls_connect_try* try) {
+	struct gls_connect connect;
+	struct flub* flub;
+	int i;
+
+	// Connect dice.
+	if ((flub = board_connect(&server->board, player->nick, try->from,
+		try->to))) {
+		// Connection not valid; send reject packet.
+		struct gls_connect_reject reject;
+
+		memset(&reject, 0, sizeof(reject));
+		reject.from = try->from;
+		reject.to = try->to;
+		strlcpy(reject.reason, flub->message,
+			GLS_CONNECT_REJECT_REASON_LENGTH);
+		flub = gls_connect_reject_write(&reject,
+			player->lanes[PLAYER_LANE_GAME][1]);
+		if (flub) {
+			g_log_warn("Error sending connect reject to player "
+				"'%s': %s", player_name(player),
+				flub->message);
+			player_kill(player);
+		}
+		return NULL;
+	}
+
+	// Record connection.
+	if ((flub = history_push(&server->history))) {
+		g_log_error("Unable to record history: '%s'", flub->message);
+	}
+	if (server->journaling && ((flub = journal_connect(&server->journal,
+		player->nick, try->from, try->to)) ||
+		(flub = journal_snapshot(&server->journal, &server->board)))) {
+		g_log_error("Unable to journal connection: '%s'",
+			flub->message);
+	}
+
+	// Notify players of connection.
+	memset(&connect, 0, sizeof(connect));
+	connect.from = try->from;
+	connect.to = try->to;
+	strlcpy(connect.nick, player->nick, GLS_NICK_LENGTH);
+	for (i = 0; i < SERVER_PLAYER_MAX; i++) {
+		if (!server->players[i].authenticated) {
+			continue;
+		}
+		flub = gls_connect_write(&connect,
+			server->players[i].lanes[PLAYER_LANE_GAME][1]);
+		if (flub) {
+			g_log_warn("Unable to connect dice for player '%s': "
+				"'%s'", player_name(&server->players[i]),
+				flub->message);
+			player_kill(&server->players[i]);
+		}
+	}
+	if (server->spectating && ((flub = gls_connect_write(&connect,
+		server->spectator.events)) ||
+		(flub = spectator_publish(&server->spectator)))) {
+		g_log_error("Unable to connect dice for spectators: '%s'",
+			flub->message);
+	}
+	g_log_info("Player '%s' connected dice '%u' and '%u'", player->nick,
+		try->from, try->to);
+	server_score(server, player->nick, GLS_COLOR_NULL);
+	return NULL;
+}
+
+struct flub* server_player_frame(struct server* server,
+	struct player* player) {
+	struct flub* flub;
+	int lane;
+
+	// Flush lanes, most important first.
+	for (lane = 0; lane < PLAYER_LANE_COUNT; lane++) {
+		if ((flub = gls_batch_flush(player->lanes[lane][1]))) {
+			return flub_append(flub, "sending frame");
+		}
+	}
+	return NULL;
+}
+
+struct flub* server_player_history(struct server* server,
+	struct player* player, struct gls_history_req* req) {
+	struct flub* flub;
+	struct gls_history history;
+	uint32_t i;
+	struct history_version* version;
+
+	// Find version.
+	memset(&history, 0, sizeof(struct gls_history));
+	history.versions = server->history.version_count;
+	history.version = req->version == GLS_HISTORY_LATEST ?
+		history.versions - 1 : req->version;
+	version = history_get(&server->history, history.version);
+	if (version) {
+		history.dice = version->dice;
+		history.connections = version->connections;
+		history.tval = version->tval;
+	}
+	flub = gls_history_write(&history,
+		player->lanes[PLAYER_LANE_GAME][1]);
+	if (flub) {
+		return flub_append(flub, "sending history");
+	}
+
+	// Send dice placed as of the version.
+	for (i = 0; i < history.dice; i++) {
+		struct gls_die_place place;
+		struct die* die;
+
+		die = &server->board.dice[i];
+		memset(&place, 0, sizeof(place));
+		strlcpy(place.location, die->location, GLS_LOCATION_LENGTH);
+		strlcpy(place.nick, die->nick, GLS_NICK_LENGTH);
+		place.color = die->color;
+		place.die = i;
+		flub = gls_die_place_write(&place,
+			player->lanes[PLAYER_LANE_GAME][1]);
+		if (flub) {
+			return flub_append(flub, "sending history die");
+		}
+	}
+
+	// Send connections made as of the version.
+	for (i = 0; i < history.connections; i++) {
+		struct gls_connect connect;
+		struct board_connection* connection;
+
+		connection = &server->board.connections[i];
+		memset(&connect, 0, sizeof(connect));
+		connect.from = connection->from;
+		connect.to = connection->to;
+		strlcpy(connect.nick, connection->nick, GLS_NICK_LENGTH);
+		flub = gls_connect_write(&connect,
+			player->lanes[PLAYER_LANE_GAME][1]);
+		if (flub) {
+			return flub_append(flub, "sending history connection");
 		}
 	}
 	return NULL;
@@ -320,17 +702,14 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 	// Process nick request.
 	memset(&set, 0, sizeof(struct gls_nick_set));
 	memset(&change, 0, sizeof(struct gls_nick_change));
-	for (i = 0; i < SERVER_PLAYER_MAX; i++) {
-		if (!strncmp(server->players[i].nick, req->nick,
-			GLS_NICK_LENGTH)) {
-			// Nick already in use.
-			strlcpy(set.reason, "Already in use",
-				GLS_NICK_SET_REASON);
-			break;
-		}
-	}
-	if (i == SERVER_PLAYER_MAX) {
+	if ((flub = registry_add(&server->registry, req->nick, player))) {
+		// Nick already in use.
+		strlcpy(set.reason, flub->message, GLS_NICK_SET_REASON);
+	} else {
 		// Nick not in use.
+		if (player->authenticated) {
+			registry_remove(&server->registry, player->nick);
+		}
 		strlcpy(change.old, player->nick, GLS_NICK_LENGTH);
 		strlcpy(change.new, req->nick, GLS_NICK_LENGTH);
 		strlcpy(player->nick, req->nick, GLS_NICK_LENGTH);
@@ -340,7 +719,7 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 		player->authenticated ? set.nick[0] == '\0' ? player->nick :
 		change.old : "(unauthenticated)",
 		req->nick, set.nick[0] == '\0' ? set.reason : "accepted");
-	flub = gls_nick_set_write(&set, player->sockfd);
+	flub = gls_nick_set_write(&set, player->lanes[PLAYER_LANE_GAME][1]);
 	if (flub) {
 		return flub_append(flub, "unable to write nick set");
 	} else if (set.nick[0] == '\0') {
@@ -348,6 +727,13 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 		return NULL;
 	}
 
+	// Record join or nick change.
+	if (server->journaling && (flub = player->authenticated ?
+		journal_nick(&server->journal, change.old, change.new) :
+		journal_join(&server->journal, player->nick))) {
+		g_log_error("Unable to journal nick: '%s'", flub->message);
+	}
+
 	// Inform other players.
 	if (!player->authenticated) {
 		struct gls_player_join join;
@@ -364,8 +750,9 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 				// Not playing or is current player.
 				continue;
 			}
-			if ((flub = gls_player_join_write(&join,
-				server->players[i].sockfd))) {
+			flub = gls_player_join_write(&join, server->players[i]
+				.lanes[PLAYER_LANE_PRESENCE][1]);
+			if (flub) {
 				g_log_warn("Unable to inform player '%s' of "
 					"player join: %s",
 					player_name(&server->players[i]),
@@ -373,6 +760,12 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 				player_kill(&server->players[i]);
 			}
 		}
+		if (server->spectating && ((flub = gls_player_join_write(
+			&join, server->spectator.events)) ||
+			(flub = spectator_publish(&server->spectator)))) {
+			g_log_error("Unable to inform spectators of player "
+				"join: '%s'", flub->message);
+		}
 	} else {
 		// Send nick change to other players.
 		for (i = 0; i < SERVER_PLAYER_MAX; i++) {
@@ -381,8 +774,10 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 				// Not playing or is current player.
 				continue;
 			}
-			if ((flub = gls_nick_change_write(&change,
-				server->players[i].sockfd))) {
+			flub = gls_nick_change_write(&change,
+				server->players[i]
+				.lanes[PLAYER_LANE_PRESENCE][1]);
+			if (flub) {
 				g_log_warn("Unable to inform player '%s' of "
 					"nick change: %s",
 					player_name(&server->players[i]),
@@ -390,6 +785,403 @@ struct flub* server_player_nick(struct server* server, struct player* player,
 				player_kill(&server->players[i]);
 			}
 		}
+		if (server->spectating && ((flub = gls_nick_change_write(
+			&change, server->spectator.events)) ||
+			(flub = spectator_publish(&server->spectator)))) {
+			g_log_error("Unable to inform spectators of nick "
+				"change: '%s'", flub->message);
+		}
+	}
+	return NULL;
+}
+
+struct flub* server_player_subscribe(struct server* server,
+	struct player* player, struct gls_subscribe* subscribe) {
+	uint32_t column;
+	uint32_t column0;
+	uint32_t column1;
+	struct die* die;
+	struct flub* flub;
+	uint32_t i;
+	struct gls_die_place place;
+	uint32_t row;
+	uint32_t row0;
+	uint32_t row1;
+	uint32_t slot;
+
+	// Find region.
+	slot = player - server->players;
+	if (subscribe->flags & GLS_SUBSCRIBE_FLAG_ALL) {
+		row0 = column0 = 0;
+		row1 = server->board.rows - 1;
+		column1 = server->board.columns - 1;
+	} else if ((flub = board_location_parse(&server->board,
+		subscribe->from, &row0, &column0)) ||
+		(flub = board_location_parse(&server->board, subscribe->to,
+		&row1, &column1))) {
+		g_log_warn("Ignoring subscription of player '%s': %s",
+			player->nick, flub->message);
+		return NULL;
+	}
+
+	// Update subscription.
+	if (subscribe->flags & GLS_SUBSCRIBE_FLAG_ALL) {
+		interest_all(&server->interest, slot);
+	} else {
+		if (!(subscribe->flags & GLS_SUBSCRIBE_FLAG_ADD)) {
+			interest_clear(&server->interest, slot);
+		}
+		interest_add(&server->interest, slot, row0, column0, row1,
+			column1);
+	}
+	if (subscribe->flags & GLS_SUBSCRIBE_FLAG_ALL) {
+		g_log_debug("Player '%s' subscribed to the board",
+			player->nick);
+	} else {
+		g_log_debug("Player '%s' subscribed to '%s' through '%s'",
+			player->nick, subscribe->from, subscribe->to);
+	}
+
+	// Send the dice already placed in the region, which the player may
+	// have missed.
+	for (i = 0; i < server->board.die_placed; i++) {
+		die = &server->board.dice[i];
+		board_location_parse(&server->board, die->location, &row,
+			&column);
+		if (row < (row0 < row1 ? row0 : row1) ||
+			row > (row0 < row1 ? row1 : row0) ||
+			column < (column0 < column1 ? column0 : column1) ||
+			column > (column0 < column1 ? column1 : column0)) {
+			continue;
+		}
+		memset(&place, 0, sizeof(place));
+		strlcpy(place.location, die->location, GLS_LOCATION_LENGTH);
+		strlcpy(place.nick, die->nick, GLS_NICK_LENGTH);
+		place.color = die->color;
+		place.die = i;
+		flub = gls_die_place_write(&place,
+			player->lanes[PLAYER_LANE_GAME][1]);
+		if (flub) {
+			return flub_append(flub, "sending subscribed dice");
+		}
+	}
+	return NULL;
+}
+
+struct flub* server_replica_apply(struct server* server,
+	struct gls_packet* packet) {
+	uint32_t column;
+	struct flub* flub;
+	uint32_t id;
+	struct gls_plate_place* place;
+	uint32_t row;
+
+	switch (packet->header.event) {
+	case GLS_EVENT_PROTOVERACK:
+		if (!packet->data.protoverack.ack) {
+			return g_flub_toss("Primary refused replica: '%s'",
+				packet->data.protoverack.reason);
+		}
+		break;
+	case GLS_EVENT_BOARD_SIZE:
+		// Resize the game board.
+		board_free(&server->board);
+		if ((flub = board_init(&server->board, &server->catalog,
+			packet->data.board_size.rows,
+			packet->data.board_size.columns,
+			packet->data.board_size.dice))) {
+			return flub_append(flub, "sizing board");
+		}
+		break;
+	case GLS_EVENT_PLATE_PLACE:
+		// Copy plate to game board.
+		place = &packet->data.plate_place;
+		if ((flub = board_location_parse(&server->board, place->loc,
+			&row, &column))) {
+			return flub_append(flub, "placing plate");
+		}
+		id = CATALOG_PLATE_NONE;
+		if (!(place->flags & GLS_PLATE_FLAG_EMPTY) &&
+			(flub = catalog_plate_add(&server->catalog,
+			place->name, place->abbrev, place->description,
+			&id))) {
+			return flub_append(flub, "placing plate");
+		}
+		board_plate_set(&server->board, row, column, id);
+		break;
+	case GLS_EVENT_DIE_PLACE:
+		if ((flub = board_die_place(&server->board,
+			packet->data.die_place.nick,
+			packet->data.die_place.location,
+			&packet->data.die_place.color,
+			&packet->data.die_place.die))) {
+			return flub_append(flub, "placing die");
+		}
+		break;
+	case GLS_EVENT_CONNECT:
+		if ((flub = board_connect(&server->board,
+			packet->data.connect.nick, packet->data.connect.from,
+			packet->data.connect.to))) {
+			return flub_append(flub, "connecting dice");
+		}
+		break;
+	default:
+		// Nothing to apply.
+		break;
+	}
+	return NULL;
+}
+
+struct flub* server_replicate(struct server* server) {
+	struct flub* flub;
+	struct gls_packet packet;
+	struct pollfd pollfd;
+	int ret;
+	struct gls_shutdown shutdown;
+	int synchronized;
+
+	// Run the replica.
+	memset(&shutdown, 0, sizeof(shutdown));
+	strlcpy(shutdown.reason, "Replica shutdown",
+		GLS_SHUTDOWN_REASON_LENGTH);
+	synchronized = 0;
+	server->running = 1;
+	while (server->running) {
+		// Wait for primary events.
+		memset(&pollfd, 0, sizeof(pollfd));
+		pollfd.fd = server->primary;
+		pollfd.events = POLLIN;
+		ret = poll(&pollfd, 1, 10);
+		if (ret == -1 && errno != EINTR) {
+			return g_flub_toss("Unable to poll primary: '%s'",
+				g_serr(errno));
+		}
+
+		// Apply event and pass it on.
+		if (ret > 0) {
+			if ((flub = gls_packet_read(&packet, server->primary,
+				1)) || (flub = server_replica_apply(server,
+				&packet))) {
+				g_log_error("Lost primary: '%s'",
+					flub->message);
+				strlcpy(shutdown.reason, "Replica lost its "
+					"primary", GLS_SHUTDOWN_REASON_LENGTH);
+				break;
+			}
+			if (packet.header.event == GLS_EVENT_SYNC_END) {
+				g_log_info("Synchronized with primary");
+				synchronized = 1;
+			} else if (synchronized && server->spectating &&
+				((flub = gls_packet_write(&packet,
+				server->spectator.events)) ||
+				(flub = spectator_publish(
+				&server->spectator)))) {
+				g_log_error("Unable to pass event to "
+					"spectators: '%s'", flub->message);
+			}
+			if (packet.header.event == GLS_EVENT_SHUTDOWN) {
+				// Spectators have been told already.
+				g_log_info("Primary shut down: '%s'",
+					packet.data.shutdown.reason);
+				return NULL;
+			}
+		}
+
+		// Snapshot game for joining spectators.
+		if (synchronized && server->spectating &&
+			spectator_snapshot_wanted(&server->spectator) &&
+			(flub = server_spectator_snapshot(server))) {
+			g_log_error("Unable to snapshot game for spectators: "
+				"'%s'", flub->message);
+		}
+
+		// Check for signal.
+		if (server_sigint) {
+			g_log_info("Server received SIGINT");
+			strlcpy(shutdown.reason, "Server received SIGINT",
+				GLS_SHUTDOWN_REASON_LENGTH);
+			server->running = 0;
+		} else if (server_sigterm) {
+			g_log_info("Server received SIGTERM");
+			strlcpy(shutdown.reason, "Server received SIGTERM",
+				GLS_SHUTDOWN_REASON_LENGTH);
+			server->running = 0;
+		}
+	}
+
+	// Inform spectators.
+	if (server->spectating && ((flub = gls_shutdown_write(&shutdown,
+		server->spectator.events)) ||
+		(flub = spectator_publish(&server->spectator)))) {
+		g_log_error("Unable to inform spectators of shutdown: '%s'",
+			flub->message);
+	}
+	return NULL;
+}
+
+void server_score(struct server* server, char* nick, uint32_t color) {
+	struct flub* flub;
+	int i;
+	struct gls_score score;
+
+	// Prepare packet.
+	memset(&score, 0, sizeof(score));
+	strlcpy(score.nick, nick, GLS_NICK_LENGTH);
+	score.points = score_get(&server->board.score, nick);
+	score.color = color;
+	score.color_points = server->board.score.colors[color];
+
+	// Send packet to each player.
+	for (i = 0; i < SERVER_PLAYER_MAX; i++) {
+		if (!server->players[i].authenticated) {
+			continue;
+		}
+		flub = gls_score_write(&score,
+			server->players[i].lanes[PLAYER_LANE_GAME][1]);
+		if (flub) {
+			g_log_warn("Unable to send score to player '%s': '%s'",
+				player_name(&server->players[i]),
+				flub->message);
+			player_kill(&server->players[i]);
+		}
+	}
+	if (server->spectating && ((flub = gls_score_write(&score,
+		server->spectator.events)) ||
+		(flub = spectator_publish(&server->spectator)))) {
+		g_log_error("Unable to send score to spectators: '%s'",
+			flub->message);
+	}
+}
+
+struct flub* server_spectator_snapshot(struct server* server) {
+	int fd;
+	struct flub* flub;
+	struct gls_protoverack pack;
+
+	// Open snapshot file.
+	if ((flub = spectator_file(&fd))) {
+		return flub;
+	}
+
+	// Write protover ack and game state.
+	memset(&pack, 0, sizeof(pack));
+	pack.ack = 1;
+	strlcpy(pack.pver.magic, "GLS", GLS_PROTOVER_MAGIC_LENGTH);
+	strlcpy(pack.pver.version, gls_protocol_versions[GLS_PROTOCOL_0],
+		GLS_PROTOVER_VERSION_LENGTH);
+	strlcpy(pack.pver.software, "glsd", GLS_PROTOVER_SOFTWARE_LENGTH);
+	if ((flub = gls_protoverack_write(&pack, fd)) ||
+		(flub = server_sync(server, fd, NULL))) {
+		close(fd);
+		return flub_append(flub, "writing spectator snapshot");
+	}
+	return spectator_snapshot(&server->spectator, fd);
+}
+
+struct flub* server_sync(struct server* server, int fd,
+	struct gls_sync_req* req) {
+	struct flub* flub;
+	int i;
+	int j;
+	struct gls_plate_set set;
+	struct gls_board_size size;
+	struct gls_sync_end sync;
+
+	// Send board size.
+	size.rows = server->board.rows;
+	size.columns = server->board.columns;
+	size.dice = server->board.die_count;
+	if ((flub = gls_board_size_write(&size, fd))) {
+		return flub_append(flub, "sending board size");
+	}
+
+	// Send plate set, omitting the plates if the player has them.
+	memset(&set, 0, sizeof(set));
+	if (req) {
+		set.hash = board_plate_hash(&server->board, &set.plates);
+		if (req->plates == set.hash) {
+			set.flags |= GLS_PLATE_SET_FLAG_CACHED;
+		}
+		if ((flub = gls_plate_set_write(&set, fd))) {
+			return flub_append(flub, "sending plate set");
+		}
+	}
+
+	// Send plates.  The board size leaves every location empty, so empty
+	// locations need no packet.
+	for (i = 0; !(set.flags & GLS_PLATE_SET_FLAG_CACHED) &&
+		i < server->board.rows; i++) {
+		for (j = 0; j < server->board.columns; j++) {
+			uint32_t id;
+			struct gls_plate_place place;
+			struct plate plate;
+
+			// Prepare packet.
+			id = board_plate_get(&server->board, i, j);
+			if (id == CATALOG_PLATE_NONE) {
+				continue;
+			}
+			memset(&place, 0, sizeof(place));
+			catalog_plate(&server->catalog, id, &plate);
+			strlcpy(place.abbrev, plate.abbrev,
+				GLS_PLATE_ABBREV_LENGTH);
+			place.flags = 0;
+			gls_location_format(place.loc, i, j);
+			if (req && (req->flags & GLS_SYNC_REQ_FLAG_BRIEF)) {
+				// Details are sent on request.
+				place.flags |= GLS_PLATE_FLAG_BRIEF;
+			} else {
+				strlcpy(place.description, plate.description,
+					GLS_PLATE_DESCRIPTION_LENGTH);
+				strlcpy(place.name, plate.name,
+					GLS_PLATE_NAME_LENGTH);
+			}
+
+			// Send packet.
+			if ((flub = gls_plate_place_write(&place,
+				fd))) {
+				return flub_append(flub, "sending plate");
+
+			}
+		}
+	}
+	// Send die placements.
+	for (i = 0; i < server->board.die_placed; i++) {
+		struct gls_die_place place;
+		struct die* die = &server->board.dice[i];
+		memset(&place, 0, sizeof(place));
+		strlcpy(place.location, die->location,
+			GLS_LOCATION_LENGTH);
+		strlcpy(place.nick, die->nick, GLS_NICK_LENGTH);
+		place.color = die->color;
+		place.die = i;
+		if ((flub = gls_die_place_write(&place,
+			fd))) {
+			return flub_append(flub, "placing die");
+		}
+	}
+	// Send connections.
+	for (i = 0; i < server->board.connection_count; i++) {
+		struct gls_connect connect;
+		struct board_connection* connection;
+
+		connection = &server->board.connections[i];
+		memset(&connect, 0, sizeof(connect));
+		connect.from = connection->from;
+		connect.to = connection->to;
+		strlcpy(connect.nick, connection->nick,
+			GLS_NICK_LENGTH);
+		if ((flub = gls_connect_write(&connect,
+			fd))) {
+			return flub_append(flub, "connecting dice");
+		}
+	}
+	// Sync end.
+	memset(&sync, 0, sizeof(struct gls_sync_end));
+	strlcpy(sync.motd, "Welcome to the Glass Plate Game test "
+		"server!", GLS_MOTD_LENGTH);
+	if ((flub = gls_sync_end_write(&sync, fd))) {
+		return flub_append(flub, "synchronizing player");
 	}
 	return NULL;
 }
@@ -399,6 +1191,7 @@ struct flub* server_run(struct server* server) {
 	struct gls_shutdown shutdown;
 	int i;
 	int j;
+	int timeout;
 
 	// Run the server.
 	server->running = 1;
@@ -436,10 +1229,16 @@ struct flub* server_run(struct server* server) {
 				}
 			} else {
 				// Initialize new player.
-				flub = player_init(player, connection);
+				flub = player_init(player, connection,
+					&server->board, server->compression);
 				if (flub) {
 					g_log_warn("Unable to initialize "
 						"player: '%s'", flub->message);
+				} else {
+					// Players start watching the whole
+					// board.
+					interest_all(&server->interest,
+						player - server->players);
 				}
 			}
 		} else if (connection == -1 && errno != EWOULDBLOCK) {
@@ -466,7 +1265,9 @@ struct flub* server_run(struct server* server) {
 			}
 
 			// Call poll.
-			ret = poll(pollfds, pollfd_count, 10);
+			timeout = server->tick ? server_tick(server) : 10;
+			ret = poll(pollfds, pollfd_count, timeout < 10 ?
+				timeout : 10);
 			if (ret == -1) {
 				if (errno != EINTR) {
 					g_log_error("Unable to poll: '%s'",
@@ -504,9 +1305,26 @@ struct flub* server_run(struct server* server) {
 					strlcpy(part.nick, player->nick,
 						GLS_NICK_LENGTH);
 
+					// Record part.
+					if (server->journaling &&
+						strlen(part.nick) &&
+						(flub = journal_part(
+						&server->journal, part.nick))) {
+						g_log_error("Unable to journal "
+							"part: '%s'",
+							flub->message);
+					}
+
 					// Player thread done.
 					g_log_info("Freeing player '%s'",
 						player->nick);
+					server_player_compression(player);
+					if (registry_get(&server->registry,
+						player->nick) == player) {
+						registry_remove(
+							&server->registry,
+							player->nick);
+					}
 					player_free(player, flub);
 					if (flub) {
 						g_log_warn("Player error: '%s'",
@@ -520,14 +1338,25 @@ struct flub* server_run(struct server* server) {
 						if (!server->players[i].authenticated) {
 							continue;
 						}
-						if ((flub = gls_player_part_write(
-							&part, server->players[i].sockfd))) {
+						flub = gls_player_part_write(
+							&part, server->players[i].lanes[PLAYER_LANE_PRESENCE][1]);
+						if (flub) {
 							g_log_warn("Unable to inform player '%s' of part: %s",
 								player_name(&server->players[i]),
 								flub->message);
 							player_kill(&server->players[i]);
 						}
 					}
+					if (server->spectating && strlen(
+						part.nick) && ((flub =
+						gls_player_part_write(&part,
+						server->spectator.events)) ||
+						(flub = spectator_publish(
+						&server->spectator)))) {
+						g_log_error("Unable to inform "
+							"spectators of part: "
+							"'%s'", flub->message);
+					}
 					continue;
 				} else if (pollfd->revents & POLLNVAL) {
 					// Invalid request.
@@ -550,13 +1379,33 @@ struct flub* server_run(struct server* server) {
 			}
 		} while (ret); // Handle player data.
 
-		// Check for signal.
+		// Checkpoint board.
+		if (server->checkpointing && (flub = checkpoint_save(
+			&server->checkpoint, &server->board,
+			server->journaling ? server->journal.seq : 0, 0))) {
+			g_log_error("Unable to checkpoint: '%s'",
+				flub->message);
+		}
+
+		// Snapshot game for joining spectators.
+		if (server->spectating && spectator_snapshot_wanted(
+			&server->spectator) && (flub =
+			server_spectator_snapshot(server))) {
+			g_log_error("Unable to snapshot game for spectators: "
+				"'%s'", flub->message);
+		}
+
+		// Check for signal or a failed journal.
 		if (server_sigint) {
 			g_log_info("Server received SIGINT");
 			server->running = 0;
 		} else if (server_sigterm) {
 			g_log_info("Server received SIGTERM");
 			server->running = 0;
+		} else if (server->journaling &&
+			journal_failed(&server->journal)) {
+			g_log_error("Journal failed; shutting down");
+			server->running = 0;
 		}
 	}
 
@@ -567,6 +1416,9 @@ struct flub* server_run(struct server* server) {
 	} else if (server_sigterm) {
 		strlcpy(shutdown.reason, "Server received SIGTERM",
 			GLS_SHUTDOWN_REASON_LENGTH);
+	} else if (server->journaling && journal_failed(&server->journal)) {
+		strlcpy(shutdown.reason, "Server journal failed",
+			GLS_SHUTDOWN_REASON_LENGTH);
 	} else {
 		strlcpy(shutdown.reason, "Server shutdown",
 			GLS_SHUTDOWN_REASON_LENGTH);
@@ -579,7 +1431,11 @@ struct flub* server_run(struct server* server) {
 		if (!player->connected) {
 			continue;
 		}
-		if ((flub = gls_shutdown_write(&shutdown, player->sockfd))) {
+		if (!(flub = gls_shutdown_write(&shutdown,
+			player->lanes[PLAYER_LANE_GAME][1]))) {
+			flub = server_player_frame(server, player);
+		}
+		if (flub) {
 			g_log_error("Unable to inform player '%s' of shutdown: "
 				"'%s'", player_name(player), flub->message);
 		}
@@ -590,14 +1446,56 @@ struct flub* server_run(struct server* server) {
 		player_kill(player);
 		player_free(player, flub);
 	}
+	if (server->spectating && ((flub = gls_shutdown_write(&shutdown,
+		server->spectator.events)) ||
+		(flub = spectator_publish(&server->spectator)))) {
+		g_log_error("Unable to inform spectators of shutdown: '%s'",
+			flub->message);
+	}
 
 	return NULL;
 }
 
+int server_tick(struct server* server) {
+	int elapsed;
+	struct flub* flub;
+	int i;
+	struct timespec now;
+
+	// Wait for tick.
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+		g_log_error("Unable to get tick time: '%s'", g_serr(errno));
+		return server->tick;
+	}
+	elapsed = (now.tv_sec - server->ticked.tv_sec) * 1000 +
+		(now.tv_nsec - server->ticked.tv_nsec) / 1000000;
+	if (elapsed < server->tick) {
+		return server->tick - elapsed;
+	}
+	server->ticked = now;
+
+	// Send each player a frame.
+	for (i = 0; i < SERVER_PLAYER_MAX; i++) {
+		if (!server->players[i].synchronized ||
+			server->players[i].killed) {
+			continue;
+		}
+		if ((flub = server_player_frame(server,
+			&server->players[i]))) {
+			g_log_warn("Unable to send frame to player '%s': "
+				"'%s'", player_name(&server->players[i]),
+				flub->message);
+			player_kill(&server->players[i]);
+		}
+	}
+	return server->tick;
+}
+
 /**
  * Runs the Glass Plate Game server.
  */
 int main(int argc, char* argv[]) {
+	struct sargs args;
 	struct flub* flub;
 	struct server server;
 	struct sigaction sa;
@@ -628,6 +1526,13 @@ int main(int argc, char* argv[]) {
 		goto err;
 	}
 
+	// Parse arguments.
+	flub = sargs_parse(&args, argc, argv);
+	if (flub) {
+		g_log_error("Unable to parse arguments: '%s'", flub->message);
+		goto err;
+	}
+
 	// Ignore 'SIGPIPE' signals.
 	// Note that, according to the SIGNAL(2) man page dated 2014-08-19,
 	// this is one of the few portable uses of 'singal'; if this gets
@@ -653,8 +1558,25 @@ int main(int argc, char* argv[]) {
 		goto err;
 	}
 
+	// Write catalog file.
+	if (args.catalog_write) {
+		if (!(flub = server_catalog(&server.catalog, &args))) {
+			flub = catalog_write(&server.catalog,
+				args.catalog_write);
+			catalog_free(&server.catalog);
+		}
+		if (flub) {
+			g_log_error("Unable to write catalog: '%s'",
+				flub->message);
+			goto err;
+		}
+		g_log_info("Wrote catalog '%s'", args.catalog_write);
+		log_free(&g_log);
+		return EXIT_SUCCESS;
+	}
+
 	// Setup server.
-	flub = server_init(&server);
+	flub = server_init(&server, &args);
 	if (flub) {
 		log_error(&g_log, "Unable to initialize server: '%s'",
 			flub->message);
@@ -662,12 +1584,36 @@ int main(int argc, char* argv[]) {
 	}
 
 	// Run the server.
-	g_log_info("Running server");
-	flub = server_run(&server);
+	if (server.replicating) {
+		g_log_info("Running replica");
+		flub = server_replicate(&server);
+	} else {
+		g_log_info("Running server");
+		flub = server_run(&server);
+	}
 	if (flub) {
 		log_error(&g_log, "Error running server: '%s'", flub->message);
 		goto err;
 	}
+	if (server.spectating) {
+		spectator_close(&server.spectator);
+	}
+	if (server.journaling) {
+		journal_close(&server.journal);
+	}
+	if (server.checkpointing) {
+		if ((flub = checkpoint_save(&server.checkpoint, &server.board,
+			server.journaling ? server.journal.seq : 0, 1))) {
+			g_log_error("Unable to checkpoint: '%s'",
+				flub->message);
+		}
+		checkpoint_close(&server.checkpoint);
+	}
+	interest_free(&server.interest);
+	registry_free(&server.registry);
+	history_free(&server.history);
+	board_free(&server.board);
+	catalog_free(&server.catalog);
 
 	// Stop logging.
 	if (log_free(&g_log) == -1) {
@@ -33,12 +33,21 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "board.h"
+#include "checkpoint.h"
 #include "gls.h"
+#include "history.h"
+#include "interest.h"
+#include "journal.h"
 #include "log.h"
 #include "player.h"
+#include "registry.h"
+#include "sargs.h"
+#include "spectator.h"
 
 #define SERVER_PLAYER_MAX 64
 
@@ -46,12 +55,44 @@
  * Game server abstraction.
  */
 struct server {
+	// Plate catalog shared by the server's boards.
+	struct catalog catalog;
 	// Game board.
 	struct board board;
+	// Game event journal.
+	struct journal journal;
+	// Board checkpoints.
+	struct checkpoint checkpoint;
+	// Board history.
+	struct history history;
 	// Maximum number of players.
 	struct player players[SERVER_PLAYER_MAX];
+	// Players by nick.
+	struct registry registry;
+	// Plates each player slot subscribes to.
+	struct interest interest;
+	// Read-only spectators.
+	struct spectator spectator;
+	// Board is checkpointed.
+	unsigned checkpointing:1;
+	// Game events are journaled.
+	unsigned journaling:1;
+	// Game is replicated from a primary server.
+	unsigned replicating:1;
 	// Server currently running.
 	unsigned running:1;
+	// Spectators are accepted.
+	unsigned spectating:1;
+	// Deflate level of players asking for compression, or zero to refuse
+	// compression.
+	uint32_t compression;
+	// Milliseconds between frames of batched events, or zero to send
+	// events as they happen.
+	uint32_t tick;
+	// Time of the last frame.
+	struct timespec ticked;
+	// Primary's replica socket.
+	int primary;
 	// Incoming connections socket.
 	int sockfd;
 	// Still not sure what exactly this thing is.
@@ -68,9 +109,46 @@ static int server_sigterm = 0;
 void server_handler(int sig);
 
 /**
- * Prepare a server for running.
+ * Loads the plate catalog specified by the arguments.
  */
-struct flub* server_init(struct server* server);
+struct flub* server_catalog(struct catalog* catalog, struct sargs* args);
+
+/**
+ * Processes the packets of a frame sent by the specified player in one go,
+ * sending the player the events they cause in a frame per lane.
+ */
+struct flub* server_player_batch(struct server* server, struct player* player,
+	struct gls_frame* frame);
+
+/**
+ * Logs the compression counters of the specified player's finished
+ * connection, if it was compressed.
+ */
+void server_player_compression(struct player* player);
+
+/**
+ * Process player's attempt to connect two dice.
+ */
+struct flub* server_player_connect(struct server* server,
+	struct player* player, struct gls_connect_try* try);
+
+/**
+ * Sends the events batched for the specified player, one frame per lane.
+ */
+struct flub* server_player_frame(struct server* server,
+	struct player* player);
+
+/**
+ * Sends the requested version of the board's history to the player.
+ */
+struct flub* server_player_history(struct server* server,
+	struct player* player, struct gls_history_req* req);
+
+/**
+ * Prepare a server for running with the specified arguments.  A replica
+ * connects to its primary instead of accepting players.
+ */
+struct flub* server_init(struct server* server, struct sargs* args);
 
 /**
  * Process incoming data from the specified player.
@@ -83,9 +161,53 @@ struct flub* server_player_data(struct server* server, struct player* player);
 struct flub* server_player_nick(struct server* server, struct player* player,
 	struct gls_nick_req* req);
 
+/**
+ * Process player's subscription to part of the board.
+ */
+struct flub* server_player_subscribe(struct server* server,
+	struct player* player, struct gls_subscribe* subscribe);
+
+/**
+ * Applies a packet from the primary to the replica's board.
+ */
+struct flub* server_replica_apply(struct server* server,
+	struct gls_packet* packet);
+
+/**
+ * Replica run loop: applies the primary's events and passes them on to the
+ * replica's spectators.
+ */
+struct flub* server_replicate(struct server* server);
+
+/**
+ * Sends the specified player's score, and the specified color's score if the
+ * color isn't 'GLS_COLOR_NULL', to every player.
+ */
+void server_score(struct server* server, char* nick, uint32_t color);
+
+/**
+ * Hands the fan-out thread a snapshot of the game for joining spectators.
+ */
+struct flub* server_spectator_snapshot(struct server* server);
+
+/**
+ * Writes the game's state to the specified descriptor, ending with a sync
+ * end packet.  If a synchronization request is given, the plates are
+ * preceded by a plate set, omitted if the request names them, and sent
+ * without details if the request asks for brief plates.
+ */
+struct flub* server_sync(struct server* server, int fd,
+	struct gls_sync_req* req);
+
 /**
  * Server run loop.
  */
 struct flub* server_run(struct server* server);
 
+/**
+ * Sends every player its batched events if a tick has passed since the last
+ * frame.  Returns the milliseconds until the next tick.
+ */
+int server_tick(struct server* server);
+
 #endif // server_H
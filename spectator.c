@@ -0,0 +1,636 @@
+/**
+ *  See 'spectator.h'.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "spectator.h"
+
+static void spectator_accept(struct spectator* spectator, int sockfd,
+	off_t end);
+static void spectator_discard(struct spectator* spectator, off_t end);
+static void spectator_drop(struct spectator* spectator,
+	struct spectator_client* client);
+static void spectator_flush(struct spectator* spectator,
+	struct spectator_client* client, off_t end);
+static struct flub* spectator_listen(struct spectator* spectator,
+	uint16_t port);
+static struct flub* spectator_listen_unix(struct spectator* spectator,
+	char* path);
+static void spectator_release(struct spectator_snapshot* snapshot);
+static void* spectator_thread(void* spectator);
+
+static void spectator_accept(struct spectator* spectator, int sockfd,
+	off_t end) {
+	struct spectator_client* client;
+	struct epoll_event event;
+	int fd;
+	size_t i;
+	struct spectator_client* tmp;
+
+	while ((fd = accept4(sockfd, NULL, NULL,
+		SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+		// Grow client table to cover the socket.
+		if (fd >= spectator->client_size) {
+			tmp = realloc(spectator->clients,
+				(fd + 1) * sizeof(struct spectator_client));
+			if (!tmp) {
+				g_log_warn("Unable to track spectator");
+				close(fd);
+				continue;
+			}
+			for (i = spectator->client_size; i <= fd; i++) {
+				tmp[i].fd = -1;
+			}
+			spectator->clients = tmp;
+			spectator->client_size = fd + 1;
+		}
+
+		// Watch spectator.
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		if (epoll_ctl(spectator->epollfd, EPOLL_CTL_ADD, fd, &event)
+			== -1) {
+			g_log_warn("Unable to watch spectator: '%s'",
+				g_serr(errno));
+			close(fd);
+			continue;
+		}
+		client = &spectator->clients[fd];
+		memset(client, 0, sizeof(struct spectator_client));
+		client->fd = fd;
+		client->phase = SPECTATOR_PHASE_WAIT;
+		spectator->client_count++;
+		g_log_debug("Spectator connected (%zu watching)",
+			spectator->client_count);
+
+		// Start with the latest snapshot unless it is too old.
+		if (!spectator->requested && (!spectator->snapshot ||
+			end - spectator->snapshot->position >
+			SPECTATOR_SNAPSHOT_LAG)) {
+			pthread_mutex_lock(&spectator->mutex);
+			spectator->wanted = 1;
+			pthread_mutex_unlock(&spectator->mutex);
+			spectator->requested = 1;
+		}
+		spectator_flush(spectator, client, end);
+	}
+	if (errno != EAGAIN && errno != EWOULDBLOCK) {
+		g_log_warn("Accepting spectator failed: '%s'", g_serr(errno));
+	}
+}
+
+void spectator_close(struct spectator* spectator) {
+	size_t i;
+	int ret;
+
+	// Stop fan-out thread.
+	if (spectator->running) {
+		pthread_mutex_lock(&spectator->mutex);
+		spectator->running = 0;
+		pthread_mutex_unlock(&spectator->mutex);
+		if (write(spectator->wake[1], "", 1) == -1) {
+			g_log_warn("Unable to wake spectator thread: '%s'",
+				g_serr(errno));
+		}
+		if ((ret = pthread_join(spectator->thread, NULL))) {
+			g_log_warn("Unable to join spectator thread: '%s'",
+				g_serr(ret));
+		}
+	}
+
+	// Disconnect spectators.
+	for (i = 0; i < spectator->client_size; i++) {
+		if (spectator->clients[i].fd != -1) {
+			spectator_drop(spectator, &spectator->clients[i]);
+		}
+	}
+	free(spectator->clients);
+	if (spectator->snapshot) {
+		spectator->snapshot->stale = 1;
+		spectator->snapshot->refs++;
+		spectator_release(spectator->snapshot);
+	}
+	if (spectator->pending) {
+		spectator->pending->stale = 1;
+		spectator->pending->refs++;
+		spectator_release(spectator->pending);
+	}
+
+	// Close descriptors.
+	if (spectator->sockfd != -1 && close(spectator->sockfd) == -1) {
+		g_log_warn("Unable to close spectator socket: '%s'",
+			g_serr(errno));
+	}
+	if (spectator->unixfd != -1) {
+		if (close(spectator->unixfd) == -1) {
+			g_log_warn("Unable to close replica socket: '%s'",
+				g_serr(errno));
+		}
+		if (unlink(spectator->path) == -1) {
+			g_log_warn("Unable to remove replica socket: '%s'",
+				g_serr(errno));
+		}
+	}
+	if (spectator->events != -1) {
+		close(spectator->events);
+	}
+	if (spectator->epollfd != -1) {
+		close(spectator->epollfd);
+	}
+	if (spectator->wake[0] != -1) {
+		close(spectator->wake[0]);
+		close(spectator->wake[1]);
+	}
+	pthread_mutex_destroy(&spectator->mutex);
+	spectator->clients = NULL;
+	spectator->pending = NULL;
+	spectator->snapshot = NULL;
+	spectator->sockfd = -1;
+	spectator->unixfd = -1;
+}
+
+static void spectator_discard(struct spectator* spectator, off_t end) {
+	size_t i;
+	off_t low;
+
+	// Find the oldest event still needed.
+	if (end - spectator->discarded < 2 * SPECTATOR_DISCARD) {
+		return;
+	}
+	low = end;
+	if (spectator->snapshot && spectator->snapshot->position < low) {
+		low = spectator->snapshot->position;
+	}
+	for (i = 0; i < spectator->client_size; i++) {
+		struct spectator_client* client;
+
+		client = &spectator->clients[i];
+		if (client->fd == -1) {
+			continue;
+		} else if (client->phase == SPECTATOR_PHASE_EVENTS &&
+			client->offset < low) {
+			low = client->offset;
+		} else if (client->phase == SPECTATOR_PHASE_SNAPSHOT &&
+			client->snapshot->position < low) {
+			low = client->snapshot->position;
+		}
+	}
+
+	// Free the file's blocks below it.
+	low -= low % SPECTATOR_DISCARD;
+	if (low <= spectator->discarded) {
+		return;
+	}
+	if (fallocate(spectator->events, FALLOC_FL_PUNCH_HOLE |
+		FALLOC_FL_KEEP_SIZE, spectator->discarded,
+		low - spectator->discarded) == -1) {
+		g_log_debug("Unable to discard spectator events: '%s'",
+			g_serr(errno));
+	}
+	spectator->discarded = low;
+}
+
+static void spectator_drop(struct spectator* spectator,
+	struct spectator_client* client) {
+	// Close socket.
+	if (close(client->fd) == -1) {
+		g_log_warn("Unable to close spectator: '%s'", g_serr(errno));
+	}
+	if (client->snapshot) {
+		spectator_release(client->snapshot);
+	}
+	client->fd = -1;
+	client->snapshot = NULL;
+	spectator->client_count--;
+	g_log_debug("Spectator disconnected (%zu watching)",
+		spectator->client_count);
+}
+
+struct flub* spectator_file(int* fd) {
+	char path[] = "/tmp/glsd-XXXXXX";
+
+	// Create file and remove its name.
+	if (((*fd) = mkstemp(path)) == -1) {
+		return g_flub_toss("Unable to create spectator file: '%s'",
+			g_serr(errno));
+	}
+	if (unlink(path) == -1) {
+		close(*fd);
+		return g_flub_toss("Unable to unlink spectator file: '%s'",
+			g_serr(errno));
+	}
+	return NULL;
+}
+
+static void spectator_flush(struct spectator* spectator,
+	struct spectator_client* client, off_t end) {
+	struct epoll_event event;
+	int blocked;
+	ssize_t ret;
+
+	// Attach to the latest snapshot.
+	blocked = 0;
+	if (client->phase == SPECTATOR_PHASE_WAIT) {
+		if (!spectator->snapshot || spectator->requested) {
+			return;
+		}
+		client->snapshot = spectator->snapshot;
+		client->snapshot->refs++;
+		client->offset = 0;
+		client->phase = SPECTATOR_PHASE_SNAPSHOT;
+	}
+
+	// Send snapshot.
+	if (client->phase == SPECTATOR_PHASE_SNAPSHOT) {
+		while (client->offset < client->snapshot->size) {
+			ret = sendfile(client->fd, client->snapshot->fd,
+				&client->offset,
+				client->snapshot->size - client->offset);
+			if (ret == -1 && (errno == EAGAIN ||
+				errno == EWOULDBLOCK)) {
+				blocked = 1;
+				break;
+			} else if (ret == -1) {
+				spectator_drop(spectator, client);
+				return;
+			}
+		}
+		if (!blocked) {
+			client->offset = client->snapshot->position;
+			spectator_release(client->snapshot);
+			client->snapshot = NULL;
+			client->phase = SPECTATOR_PHASE_EVENTS;
+		}
+	}
+
+	// Send events.
+	if (client->phase == SPECTATOR_PHASE_EVENTS) {
+		if (end - client->offset > SPECTATOR_LAG_MAX) {
+			g_log_warn("Dropping spectator too far behind");
+			spectator_drop(spectator, client);
+			return;
+		}
+		while (client->offset < end) {
+			ret = sendfile(client->fd, spectator->events,
+				&client->offset, end - client->offset);
+			if (ret == -1 && (errno == EAGAIN ||
+				errno == EWOULDBLOCK)) {
+				blocked = 1;
+				break;
+			} else if (ret == -1) {
+				spectator_drop(spectator, client);
+				return;
+			}
+		}
+	}
+
+	// Wait for the socket to drain only while data is left.
+	if (blocked == client->blocked) {
+		return;
+	}
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP | (blocked ? EPOLLOUT : 0);
+	event.data.fd = client->fd;
+	if (epoll_ctl(spectator->epollfd, EPOLL_CTL_MOD, client->fd, &event)
+		== -1) {
+		g_log_warn("Unable to watch spectator: '%s'", g_serr(errno));
+		spectator_drop(spectator, client);
+		return;
+	}
+	client->blocked = blocked;
+}
+
+static struct flub* spectator_listen(struct spectator* spectator,
+	uint16_t port) {
+	struct sockaddr_in sockaddr_in;
+
+	// Set up socket.
+	spectator->sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK |
+		SOCK_CLOEXEC, IPPROTO_TCP);
+	if (spectator->sockfd == -1) {
+		return g_flub_toss("Unable to create spectator socket: '%s'",
+			g_serr(errno));
+	}
+	memset(&sockaddr_in, 0, sizeof(struct sockaddr_in));
+	sockaddr_in.sin_family = AF_INET;
+	sockaddr_in.sin_port = htons(port);
+	sockaddr_in.sin_addr.s_addr = INADDR_ANY;
+	if (bind(spectator->sockfd, (struct sockaddr*)&sockaddr_in,
+		sizeof(struct sockaddr_in)) == -1) {
+		return g_flub_toss("Spectator socket binding failed: '%s'",
+			g_serr(errno));
+	}
+	if (listen(spectator->sockfd, SOMAXCONN) == -1) {
+		return g_flub_toss("Spectator socket listening failed: '%s'",
+			g_serr(errno));
+	}
+	return NULL;
+}
+
+static struct flub* spectator_listen_unix(struct spectator* spectator,
+	char* path) {
+	struct sockaddr_un sockaddr_un;
+
+	// Set up socket.
+	memset(&sockaddr_un, 0, sizeof(struct sockaddr_un));
+	sockaddr_un.sun_family = AF_UNIX;
+	if (strlcpy(sockaddr_un.sun_path, path,
+		sizeof(sockaddr_un.sun_path)) >=
+		sizeof(sockaddr_un.sun_path)) {
+		return g_flub_toss("Replica socket path too long");
+	}
+	spectator->unixfd = socket(AF_UNIX, SOCK_STREAM |
+		SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (spectator->unixfd == -1) {
+		return g_flub_toss("Unable to create replica socket: "
+			"'%s'", g_serr(errno));
+	}
+	if (unlink(path) == -1 && errno != ENOENT) {
+		close(spectator->unixfd);
+		spectator->unixfd = -1;
+		return g_flub_toss("Unable to remove stale replica "
+			"socket: '%s'", g_serr(errno));
+	}
+	if (bind(spectator->unixfd, (struct sockaddr*)&sockaddr_un,
+		sizeof(struct sockaddr_un)) == -1) {
+		close(spectator->unixfd);
+		spectator->unixfd = -1;
+		return g_flub_toss("Replica socket binding failed: "
+			"'%s'", g_serr(errno));
+	}
+	strlcpy(spectator->path, path, PATH_MAX);
+	if (listen(spectator->unixfd, SOMAXCONN) == -1) {
+		return g_flub_toss("Replica socket listening failed: "
+			"'%s'", g_serr(errno));
+	}
+	return NULL;
+}
+
+struct flub* spectator_open(struct spectator* spectator, uint16_t port,
+	char* path) {
+	struct epoll_event event;
+	struct flub* flub;
+	int ret;
+
+	// Initialize spectator.
+	memset(spectator, 0, sizeof(struct spectator));
+	spectator->sockfd = -1;
+	spectator->unixfd = -1;
+	spectator->events = -1;
+	spectator->epollfd = -1;
+	spectator->wake[0] = spectator->wake[1] = -1;
+	if ((ret = pthread_mutex_init(&spectator->mutex, NULL))) {
+		return g_flub_toss("Unable to create spectator mutex: '%s'",
+			g_serr(ret));
+	}
+
+	// Create event file and wake pipe.
+	if ((flub = spectator_file(&spectator->events))) {
+		spectator->events = -1;
+		goto err;
+	}
+	if (pipe2(spectator->wake, O_NONBLOCK | O_CLOEXEC) == -1) {
+		spectator->wake[0] = spectator->wake[1] = -1;
+		flub = g_flub_toss("Unable to create spectator pipe: '%s'",
+			g_serr(errno));
+		goto err;
+	}
+
+	// Set up sockets.
+	if (port && (flub = spectator_listen(spectator, port))) {
+		goto err;
+	}
+	if (path && (flub = spectator_listen_unix(spectator, path))) {
+		goto err;
+	}
+
+	// Watch socket and wake pipe.
+	if ((spectator->epollfd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		flub = g_flub_toss("Unable to create spectator epoll: '%s'",
+			g_serr(errno));
+		goto err;
+	}
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = spectator->sockfd;
+	if (spectator->sockfd != -1 && epoll_ctl(spectator->epollfd,
+		EPOLL_CTL_ADD, spectator->sockfd, &event) == -1) {
+		flub = g_flub_toss("Unable to watch spectator socket: '%s'",
+			g_serr(errno));
+		goto err;
+	}
+	event.data.fd = spectator->unixfd;
+	if (spectator->unixfd != -1 && epoll_ctl(spectator->epollfd,
+		EPOLL_CTL_ADD, spectator->unixfd, &event) == -1) {
+		flub = g_flub_toss("Unable to watch replica socket: '%s'",
+			g_serr(errno));
+		goto err;
+	}
+	event.data.fd = spectator->wake[0];
+	if (epoll_ctl(spectator->epollfd, EPOLL_CTL_ADD, spectator->wake[0],
+		&event) == -1) {
+		flub = g_flub_toss("Unable to watch spectator pipe: '%s'",
+			g_serr(errno));
+		goto err;
+	}
+
+	// Start fan-out thread.
+	spectator->running = 1;
+	if ((ret = pthread_create(&spectator->thread, NULL, spectator_thread,
+		(void*)spectator))) {
+		spectator->running = 0;
+		flub = g_flub_toss("Unable to create spectator thread: '%s'",
+			g_serr(ret));
+		goto err;
+	}
+	return NULL;
+
+err:
+	spectator_close(spectator);
+	return flub_append(flub, "opening spectators");
+}
+
+struct flub* spectator_publish(struct spectator* spectator) {
+	off_t end;
+
+	// Publish file length.
+	if ((end = lseek(spectator->events, 0, SEEK_CUR)) == -1) {
+		return g_flub_toss("Unable to publish spectator events: '%s'",
+			g_serr(errno));
+	}
+	pthread_mutex_lock(&spectator->mutex);
+	spectator->end = end;
+	pthread_mutex_unlock(&spectator->mutex);
+
+	// Wake fan-out thread; a full pipe means it is already awake.
+	if (write(spectator->wake[1], "", 1) == -1 && errno != EAGAIN) {
+		return g_flub_toss("Unable to wake spectator thread: '%s'",
+			g_serr(errno));
+	}
+	return NULL;
+}
+
+static void spectator_release(struct spectator_snapshot* snapshot) {
+	// Free replaced snapshot once nobody reads it.
+	snapshot->refs--;
+	if (!snapshot->refs && snapshot->stale) {
+		close(snapshot->fd);
+		free(snapshot);
+	}
+}
+
+struct flub* spectator_snapshot(struct spectator* spectator, int fd) {
+	off_t position;
+	off_t size;
+	struct spectator_snapshot* snapshot;
+
+	// Prepare snapshot.
+	if ((size = lseek(fd, 0, SEEK_CUR)) == -1 ||
+		(position = lseek(spectator->events, 0, SEEK_CUR)) == -1) {
+		close(fd);
+		return g_flub_toss("Unable to size spectator snapshot: '%s'",
+			g_serr(errno));
+	}
+	if (!(snapshot = calloc(1, sizeof(struct spectator_snapshot)))) {
+		close(fd);
+		return g_flub_toss("Unable to allocate spectator snapshot");
+	}
+	snapshot->fd = fd;
+	snapshot->size = size;
+	snapshot->position = position;
+
+	// Hand snapshot to the fan-out thread.
+	pthread_mutex_lock(&spectator->mutex);
+	if (spectator->pending) {
+		close(spectator->pending->fd);
+		free(spectator->pending);
+	}
+	spectator->pending = snapshot;
+	spectator->wanted = 0;
+	pthread_mutex_unlock(&spectator->mutex);
+	if (write(spectator->wake[1], "", 1) == -1 && errno != EAGAIN) {
+		return g_flub_toss("Unable to wake spectator thread: '%s'",
+			g_serr(errno));
+	}
+	return NULL;
+}
+
+int spectator_snapshot_wanted(struct spectator* spectator) {
+	int wanted;
+
+	pthread_mutex_lock(&spectator->mutex);
+	wanted = spectator->wanted;
+	pthread_mutex_unlock(&spectator->mutex);
+	return wanted;
+}
+
+static void* spectator_thread(void* spectator_void) {
+	char buffer[512];
+	struct spectator_client* client;
+	int count;
+	off_t end;
+	struct epoll_event events[64];
+	size_t i;
+	int j;
+	int ret;
+	struct spectator* spectator;
+	struct spectator_snapshot* snapshot;
+	int running;
+	int update;
+
+	spectator = (struct spectator*)spectator_void;
+	end = 0;
+	running = 1;
+	while (running) {
+		// Wait for spectators or events.
+		count = epoll_wait(spectator->epollfd, events, 64, -1);
+		if (count == -1 && errno == EINTR) {
+			continue;
+		} else if (count == -1) {
+			g_log_error("Unable to wait for spectators: '%s'",
+				g_serr(errno));
+			break;
+		}
+		update = 0;
+		for (j = 0; j < count; j++) {
+			int fd;
+
+			fd = events[j].data.fd;
+			if (fd == spectator->sockfd ||
+				fd == spectator->unixfd) {
+				spectator_accept(spectator, fd, end);
+				continue;
+			} else if (fd == spectator->wake[0]) {
+				while (read(fd, buffer, sizeof(buffer)) > 0);
+				update = 1;
+				continue;
+			}
+			client = &spectator->clients[fd];
+			if (client->fd == -1) {
+				// Dropped earlier in this pass.
+				continue;
+			}
+
+			// Spectators only listen; discard anything they say.
+			if (events[j].events & (EPOLLERR | EPOLLHUP |
+				EPOLLRDHUP)) {
+				spectator_drop(spectator, client);
+				continue;
+			} else if (events[j].events & EPOLLIN) {
+				ret = read(fd, buffer, sizeof(buffer));
+				if (ret == 0 || (ret == -1 && errno != EAGAIN &&
+					errno != EWOULDBLOCK)) {
+					spectator_drop(spectator, client);
+					continue;
+				}
+			}
+			if (events[j].events & EPOLLOUT) {
+				spectator_flush(spectator, client, end);
+			}
+		}
+		if (!update) {
+			continue;
+		}
+
+		// Pick up published events and snapshot.
+		pthread_mutex_lock(&spectator->mutex);
+		end = spectator->end;
+		snapshot = spectator->pending;
+		spectator->pending = NULL;
+		running = spectator->running;
+		pthread_mutex_unlock(&spectator->mutex);
+		if (snapshot) {
+			if (spectator->snapshot) {
+				spectator->snapshot->stale = 1;
+				spectator->snapshot->refs++;
+				spectator_release(spectator->snapshot);
+			}
+			spectator->snapshot = snapshot;
+			spectator->requested = 0;
+		}
+
+		// Fan events out.
+		for (i = 0; i < spectator->client_size; i++) {
+			if (spectator->clients[i].fd != -1) {
+				spectator_flush(spectator,
+					&spectator->clients[i], end);
+			}
+		}
+		spectator_discard(spectator, end);
+	}
+	return NULL;
+}
@@ -0,0 +1,156 @@
+/**
+ *  Read-only spectators fed from a shared event file.
+ *
+ *  Copyright (C) 2017  Wade T. Cline.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Affero General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Affero General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef spectator_H
+#define spectator_H
+
+#include "include.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/ip.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "global.h"
+
+// Most events a spectator may fall behind by before it is dropped.
+#define SPECTATOR_LAG_MAX (4 * 1024 * 1024)
+// Events a snapshot may fall behind by before a new one is requested.
+#define SPECTATOR_SNAPSHOT_LAG (64 * 1024)
+// Events discarded from the event file at a time.
+#define SPECTATOR_DISCARD (1024 * 1024)
+
+// Spectator phases.
+#define SPECTATOR_PHASE_WAIT 0
+#define SPECTATOR_PHASE_SNAPSHOT 1
+#define SPECTATOR_PHASE_EVENTS 2
+
+/**
+ * Synchronization packets for spectators joining after the event file
+ * reached 'position'.
+ */
+struct spectator_snapshot {
+	int fd;
+	off_t size;
+	off_t position;
+	// Spectators still reading the snapshot.
+	size_t refs;
+	// Replaced by a newer snapshot.
+	unsigned stale:1;
+};
+
+/**
+ * Connected spectator.
+ */
+struct spectator_client {
+	int fd;
+	int phase;
+	struct spectator_snapshot* snapshot;
+	// Offset into the snapshot or event file.
+	off_t offset;
+	// Waiting for the socket to become writable.
+	unsigned blocked:1;
+};
+
+/**
+ * Spectator fan-out.  The game thread writes every broadcast packet once to
+ * an unlinked event file and publishes its new length; spectators hold no
+ * player slot and are fed by a single thread, which copies the file to each
+ * of their sockets with 'sendfile'.  A spectator first receives a snapshot
+ * of the game written by the game thread on request, then the events that
+ * followed it.  Replica servers read the same stream over a local socket.
+ */
+struct spectator {
+	// Incoming connections sockets.
+	int sockfd;
+	int unixfd;
+	char path[PATH_MAX];
+	// Event file, written by the game thread.
+	int events;
+	// Fan-out thread.
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	int epollfd;
+	int wake[2];
+	// Published length of the event file.
+	off_t end;
+	// Event file discarded below this offset.
+	off_t discarded;
+	// Snapshot waiting to be picked up by the fan-out thread.
+	struct spectator_snapshot* pending;
+	// Latest snapshot.
+	struct spectator_snapshot* snapshot;
+	// Spectators by socket.
+	struct spectator_client* clients;
+	size_t client_count;
+	size_t client_size;
+	// Snapshot wanted by the fan-out thread.
+	int wanted;
+	// Snapshot requested and not yet picked up, as seen by the fan-out
+	// thread.  Written without the mutex, so it is not a bitfield sharing
+	// storage with the flags around it.
+	int requested;
+	// Fan-out thread running.
+	int running;
+};
+
+/**
+ * Sends any remaining events, stops the fan-out thread, and disconnects
+ * every spectator.
+ */
+void spectator_close(struct spectator* spectator);
+
+/**
+ * Creates an unlinked temporary file.
+ */
+struct flub* spectator_file(int* fd);
+
+/**
+ * Listens for spectators on the specified port, unless it is zero, and on
+ * the unix socket at the specified path, unless it is NULL, and starts the
+ * fan-out thread.
+ */
+struct flub* spectator_open(struct spectator* spectator, uint16_t port,
+	char* path);
+
+/**
+ * Publishes the packets written to the event file since the last call.
+ */
+struct flub* spectator_publish(struct spectator* spectator);
+
+/**
+ * Hands a snapshot written to 'fd' to the fan-out thread.  The snapshot
+ * reflects every published event.
+ */
+struct flub* spectator_snapshot(struct spectator* spectator, int fd);
+
+/**
+ * Returns whether the fan-out thread wants a new snapshot.
+ */
+int spectator_snapshot_wanted(struct spectator* spectator);
+
+#endif // spectator_H